@@ -3,27 +3,27 @@
 #include "renderable_box.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
-#include <glm/gtc/matrix_transform.hpp>
+#include <utility>
 
 class BoxEntity {
 public:
-    btRigidBody* body;
+    RigidBody body;
     RenderableBox renderable;
 
-    BoxEntity(btRigidBody* b, const glm::vec3& halfExtents)
-        : body(b), renderable(halfExtents) {}
+    BoxEntity(RigidBody&& b, const glm::vec3& halfExtents)
+        : body(std::move(b)), renderable(halfExtents) {}
 
-    void draw(GLuint shaderProgram, const glm::mat4& view, const glm::mat4& projection) {
+    // Current pose from the physics body
+    glm::vec3 position() const {
         btTransform trans;
         body->getMotionState()->getWorldTransform(trans);
+        return glm::vec3(trans.getOrigin().getX(), trans.getOrigin().getY(), trans.getOrigin().getZ());
+    }
 
-        glm::vec3 pos(trans.getOrigin().getX(), trans.getOrigin().getY(), trans.getOrigin().getZ());
+    glm::quat rotation() const {
+        btTransform trans;
+        body->getMotionState()->getWorldTransform(trans);
         btQuaternion rot = trans.getRotation();
-        glm::quat quat(rot.getW(), rot.getX(), rot.getY(), rot.getZ());
-
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), pos);
-        model *= glm::mat4_cast(quat);
-
-        renderable.draw(shaderProgram, model, view, projection);
+        return glm::quat(rot.getW(), rot.getX(), rot.getY(), rot.getZ());
     }
 };
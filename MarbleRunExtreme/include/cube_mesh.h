@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <GL/glew.h>
+#include "gl_handle.h"
+
+// The -1..1 cube with flat per-face normals (positions at location 0,
+// normals at location 1), uploaded once and shared by everything that draws
+// boxes. Scale it by half extents to get a box.
+class CubeMesh {
+public:
+    static const GLsizei VERTEX_COUNT = 36;
+
+    CubeMesh();
+
+    // VAO with just the cube's own attributes
+    GLuint vao() const { return VAO; }
+
+    // Point locations 0 and 1 of the bound VAO at the cube, for VAOs that
+    // add their own per-instance attributes
+    void bindVertexAttributes() const;
+
+    static size_t gpuBytes();
+
+private:
+    GlVertexArray VAO;
+    GlBuffer VBO;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Pre-sliced RGB8 cubemap with its full mip chain, stored exactly as the GL
+// upload wants it so loading is an mmap and six glTexImage2D per level.
+//
+// File layout (little endian):
+//   CubemapHeader
+//   for each mip level, largest first:
+//     for each face in GL order (+X, -X, +Y, -Y, +Z, -Z):
+//       size*size*3 bytes, rows tightly packed
+const char CUBEMAP_CACHE_MAGIC[4] = { 'M', 'R', 'C', 'B' };
+const uint32_t CUBEMAP_CACHE_VERSION = 1;
+
+struct CubemapHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t faceSize;
+    uint32_t mipCount;
+};
+
+// Read-only view of a cubemap in the layout above, either mapped or in memory
+struct CubemapView {
+    const unsigned char* payload = nullptr;     // first byte after the header
+    int faceSize = 0;
+    int mipCount = 0;
+
+    int levelSize(int level) const;
+    const unsigned char* face(int level, int face) const;
+};
+
+// Decoded cubemap in the cache layout, header included
+struct CubemapImage {
+    std::vector<unsigned char> bytes;
+    CubemapView view() const;
+};
+
+// Memory-mapped cache file
+class MappedCubemap {
+public:
+    MappedCubemap() = default;
+    ~MappedCubemap();
+
+    MappedCubemap(const MappedCubemap&) = delete;
+    MappedCubemap& operator=(const MappedCubemap&) = delete;
+
+    // Fails on a missing, truncated or wrong-version file
+    bool open(const std::string& path);
+    void close();
+
+    const CubemapView& view() const { return cubemap; }
+
+private:
+    void* base = nullptr;
+    size_t size = 0;
+    CubemapView cubemap;
+};
+
+// A cubemap ready to upload: the mapped cache if it was usable, otherwise
+// the freshly converted atlas
+struct LoadedCubemap {
+    MappedCubemap mapped;
+    CubemapImage image;
+    bool fromCache = false;
+
+    CubemapView view() const { return fromCache ? mapped.view() : image.view(); }
+};
+
+// Map the atlas's cache if it is fresh, otherwise convert the atlas and try
+// to write the cache for next time. Needs no GL context.
+bool loadCubemap(const std::string& atlasPath, LoadedCubemap& out);
+
+// Decode a 4x3 horizontal-cross atlas, slice it into faces and build the mips
+bool convertAtlasToCubemap(const std::string& atlasPath, CubemapImage& out);
+
+bool writeCubemapCache(const std::string& path, const CubemapImage& image);
+
+// assets/skybox/red_sky.png -> assets/skybox/red_sky.mrcube
+std::string cubemapCachePath(const std::string& atlasPath);
+
+// True if the cache exists and is at least as new as the atlas
+bool cubemapCacheIsFresh(const std::string& cachePath, const std::string& atlasPath);
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "race.h"
+
+// Race farm wire format. Every message is a varint payload length and then
+// the payload: a u8 message type and its fields. Integers are unsigned
+// LEB128 varints, floats little-endian f32, strings a varint byte count and
+// the bytes.
+//
+// Client to server
+//   JOB     1  id, seed, marble count, f32 tick rate (Hz), f32 max time (s),
+//              track description (see track_description.h; empty = the
+//              standard course)
+//
+// Server to client, jobs interleaved in whatever order they run
+//   FINISH  2  id, place of the first entry (0 = winner), entry count, then
+//              per entry: marble, f32 finish time (s)
+//   DONE    3  id, ticks, f32 simulated time (s), f32 setup ms, f32 run ms,
+//              u8 1 if the track came from the cache, state hash
+//   ERROR   4  id (0 if the message couldn't be read), message
+//
+// A job's FINISH messages arrive in place order, before its DONE. Races run
+// in deterministic mode, so a job gives the same answer every time.
+enum class FarmMessage : uint8_t {
+    Job = 1,
+    Finish = 2,
+    Done = 3,
+    Error = 4,
+};
+
+// Payloads past this are refused, and the connection dropped
+const size_t FARM_MAX_MESSAGE_BYTES = 1 << 20;
+
+struct FarmJob {
+    uint64_t id = 0;
+    uint32_t seed = 0;
+    uint32_t marbleCount = 25;
+    float tickRate = 60.0f;
+    float maxTime = 120.0f;
+    std::string track;
+};
+
+struct FarmFinish {
+    uint64_t id = 0;
+    uint32_t firstPlace = 0;
+    std::vector<FinishEntry> entries;
+};
+
+struct FarmDone {
+    uint64_t id = 0;
+    uint64_t ticks = 0;
+    float simTime = 0.0f;
+    float setupMs = 0.0f;
+    float runMs = 0.0f;
+    bool trackCached = false;
+    uint64_t stateHash = 0;
+};
+
+struct FarmError {
+    uint64_t id = 0;
+    std::string message;
+};
+
+// Append one whole message, length prefix included
+void encodeFarmMessage(const FarmJob& job, std::vector<uint8_t>& out);
+void encodeFarmMessage(const FarmFinish& finish, std::vector<uint8_t>& out);
+void encodeFarmMessage(const FarmDone& done, std::vector<uint8_t>& out);
+void encodeFarmMessage(const FarmError& error, std::vector<uint8_t>& out);
+
+// Payloads as handed out by FarmDecoder; false if truncated or malformed
+bool decodeFarmMessage(const std::vector<uint8_t>& payload, FarmJob& out);
+bool decodeFarmMessage(const std::vector<uint8_t>& payload, FarmFinish& out);
+bool decodeFarmMessage(const std::vector<uint8_t>& payload, FarmDone& out);
+bool decodeFarmMessage(const std::vector<uint8_t>& payload, FarmError& out);
+
+// Splits a byte stream back into messages
+class FarmDecoder {
+public:
+    void feed(const uint8_t* data, size_t size);
+
+    // The next whole message's type and payload (type byte stripped), if
+    // one has arrived. Once failed() nothing more comes out.
+    bool next(FarmMessage& type, std::vector<uint8_t>& payload);
+
+    // A length prefix was malformed or over FARM_MAX_MESSAGE_BYTES
+    bool failed() const { return broken; }
+
+private:
+    std::vector<uint8_t> buffer;
+    size_t readPos = 0;
+    bool broken = false;
+};
+
+// Blocking socket helpers for either end. sendAll retries short writes;
+// both return false once the peer is gone.
+bool sendAll(int fd, const std::vector<uint8_t>& bytes);
+bool receiveSome(int fd, FarmDecoder& decoder);
+
+// Client end: connected socket, or -1 with a message on stderr
+int connectRaceFarm(const std::string& socketPath);
@@ -0,0 +1,87 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <GL/glew.h>
+
+// Where captured frames go. Every output is top-down RGB24.
+enum class CaptureFormat {
+    PpmSequence,    // <target>/frame_000000.ppm, ...
+    RawStream,      // all frames back to back in the file <target>
+    Pipe            // raw frames on the stdin of the shell command <target>
+};
+
+struct CaptureStats {
+    long framesRead = 0;        // readbacks started
+    long framesWritten = 0;
+    long fenceStalls = 0;       // had to wait for a readback to finish
+    long writerStalls = 0;      // had to wait for the writer to free a buffer
+    bool writeFailed = false;
+};
+
+// Reads the bound framebuffer back through a ring of pixel pack buffers and
+// hands finished frames to a writer thread, so neither the GPU copy nor the
+// disk or encoder ever blocks the frame that asked for it. A readback is
+// only mapped ringSize frames after it was issued, by when its fence has
+// normally signalled.
+class FrameCapture {
+public:
+    FrameCapture(int width, int height, int ringSize = 3, int queueDepth = 8);
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // Start the writer. For PpmSequence the directory is created.
+    bool open(CaptureFormat format, const std::string& target);
+
+    // Queue a readback of the bound read framebuffer's colour buffer.
+    // Needs the GL context that open() was called with.
+    void capture();
+
+    // Collect every outstanding readback and wait for the writer to drain
+    void finish();
+
+    const CaptureStats& stats() const { return captureStats; }
+
+private:
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        long frame = -1;        // -1 = empty
+    };
+
+    struct Frame {
+        long index = 0;
+        std::vector<uint8_t> rgba;
+    };
+
+    int width, height;
+    std::vector<Slot> ring;
+    int next = 0;
+    long frameCounter = 0;
+
+    CaptureFormat format = CaptureFormat::PpmSequence;
+    std::string target;
+    FILE* stream = nullptr;
+
+    // Frames move from freeFrames to pending (GL thread) and back (writer)
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Frame> pending;
+    std::vector<Frame> freeFrames;
+    bool stopping = false;
+    std::thread writer;
+
+    CaptureStats captureStats;
+    bool finished = false;
+
+    void retire(Slot& slot);
+    void writerLoop();
+    bool writeFrame(const Frame& frame, std::vector<uint8_t>& rgb);
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "gpu_timer.h"
+#include "render_queue.h"
+
+struct Percentiles {
+    double p50 = 0.0, p95 = 0.0, p99 = 0.0;
+};
+
+// The last `window` samples of one measurement
+class RollingStats {
+public:
+    explicit RollingStats(size_t window = 600) : window(window) {}
+
+    void add(double value);
+    size_t count() const { return samples.size(); }
+
+    // Nearest-rank percentiles over the window; zeros when empty
+    Percentiles percentiles() const;
+
+private:
+    size_t window;
+    size_t next = 0;
+    std::vector<double> samples;
+    mutable std::vector<double> sorted;
+};
+
+// Per-frame timings: CPU frame, physics step and each render pass on the
+// GPU, each summarised as rolling p50/p95/p99 in milliseconds.
+//
+// Call beginFrame/endFrame around the frame's CPU work (not the buffer
+// swap) and beginPhysics/endPhysics around the simulation step, and pass
+// gpu() to RaceView::render. GPU numbers lag a few frames behind.
+class FrameProfiler {
+public:
+    explicit FrameProfiler(size_t window = 600);
+
+    // Summary lines are appended to the file on each log() call
+    bool openLog(const std::string& path);
+
+    GpuTimer& gpu() { return gpuTimer; }
+
+    void beginFrame();
+    void beginPhysics();
+    void endPhysics();
+    void endFrame();
+
+    // One "name p50 p95 p99" line per measurement
+    std::vector<std::string> summary() const;
+
+    // Write the summary to the log, stamped with `seconds`
+    void log(double seconds);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Series {
+        std::string name;
+        RollingStats stats;
+    };
+
+    GpuTimer gpuTimer;
+    std::vector<Series> series;     // cpu frame, physics, gpu total, then one per pass
+    std::vector<double> passMs;
+    Clock::time_point frameStart, physicsStart;
+    std::ofstream logFile;
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// World-space axis-aligned bounding box
+struct Aabb {
+    glm::vec3 min = glm::vec3(INFINITY);
+    glm::vec3 max = glm::vec3(-INFINITY);
+
+    bool empty() const { return min.x > max.x; }
+
+    void expand(const glm::vec3& p) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    void expand(const Aabb& b) {
+        min = glm::min(min, b.min);
+        max = glm::max(max, b.max);
+    }
+};
+
+// Boxes stored as separate float arrays so the frustum test runs over
+// contiguous data and the compiler can vectorise it
+class AabbList {
+public:
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    void clear();
+    void add(const Aabb& box);
+    size_t size() const { return minX.size(); }
+};
+
+// Six planes extracted from a view-projection matrix, normals pointing inwards
+class Frustum {
+public:
+    Frustum() = default;
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    bool intersects(const Aabb& box) const;
+    bool intersectsSphere(const glm::vec3& center, float radius) const;
+
+    // Replace `visible` with the indices of the entries that touch the frustum
+    void cull(const AabbList& boxes, std::vector<int>& visible) const;
+    void cullSpheres(const std::vector<glm::vec4>& spheres, std::vector<int>& visible) const; // xyz = centre, w = radius
+
+private:
+    glm::vec4 planes[6];
+
+    // Per-entry inside flags, reused between calls
+    mutable std::vector<uint8_t> inside;
+};
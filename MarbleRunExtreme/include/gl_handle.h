@@ -0,0 +1,80 @@
+#pragma once
+#include <utility>
+#include <GL/glew.h>
+
+// Owning, move-only GL object name. Deletes the object when it goes out of
+// scope or is replaced, so a class made of these gets correct moves and no
+// copies for free. Converts to GLuint so it drops straight into gl* calls.
+// Must be destroyed while the context that created it is current.
+template <class Traits>
+class GlHandle {
+public:
+    GlHandle() = default;
+    explicit GlHandle(GLuint name) : name(name) {}     // adopt an existing name
+    ~GlHandle() { reset(); }
+
+    GlHandle(GlHandle&& other) noexcept : name(std::exchange(other.name, 0)) {}
+    GlHandle& operator=(GlHandle&& other) noexcept {
+        if (this != &other)
+            reset(std::exchange(other.name, 0));
+        return *this;
+    }
+    GlHandle(const GlHandle&) = delete;
+    GlHandle& operator=(const GlHandle&) = delete;
+
+    // A freshly generated name
+    static GlHandle create() { return GlHandle(Traits::create()); }
+
+    GLuint get() const { return name; }
+    operator GLuint() const { return name; }
+
+    // Delete the current object and take ownership of `replacement`
+    void reset(GLuint replacement = 0) {
+        if (name)
+            Traits::destroy(name);
+        name = replacement;
+    }
+
+    // Give up ownership without deleting
+    GLuint release() { return std::exchange(name, 0); }
+
+private:
+    GLuint name = 0;
+};
+
+struct GlBufferTraits {
+    static GLuint create() { GLuint n = 0; glGenBuffers(1, &n); return n; }
+    static void destroy(GLuint n) { glDeleteBuffers(1, &n); }
+};
+
+struct GlVertexArrayTraits {
+    static GLuint create() { GLuint n = 0; glGenVertexArrays(1, &n); return n; }
+    static void destroy(GLuint n) { glDeleteVertexArrays(1, &n); }
+};
+
+struct GlTextureTraits {
+    static GLuint create() { GLuint n = 0; glGenTextures(1, &n); return n; }
+    static void destroy(GLuint n) { glDeleteTextures(1, &n); }
+};
+
+struct GlProgramTraits {
+    static GLuint create() { return glCreateProgram(); }
+    static void destroy(GLuint n) { glDeleteProgram(n); }
+};
+
+struct GlFramebufferTraits {
+    static GLuint create() { GLuint n = 0; glGenFramebuffers(1, &n); return n; }
+    static void destroy(GLuint n) { glDeleteFramebuffers(1, &n); }
+};
+
+struct GlRenderbufferTraits {
+    static GLuint create() { GLuint n = 0; glGenRenderbuffers(1, &n); return n; }
+    static void destroy(GLuint n) { glDeleteRenderbuffers(1, &n); }
+};
+
+using GlBuffer = GlHandle<GlBufferTraits>;
+using GlVertexArray = GlHandle<GlVertexArrayTraits>;
+using GlTexture = GlHandle<GlTextureTraits>;
+using GlProgram = GlHandle<GlProgramTraits>;
+using GlFramebuffer = GlHandle<GlFramebufferTraits>;
+using GlRenderbuffer = GlHandle<GlRenderbufferTraits>;
@@ -0,0 +1,48 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include <GL/glew.h>
+
+// GL_TIME_ELAPSED queries around numbered passes, kept in a ring of frames.
+// Results are only read once the driver says they are available, a few
+// frames later, so timing never stalls the pipeline. A frame whose results
+// still aren't in when its slot comes round again is dropped.
+class GpuTimer {
+public:
+    GpuTimer(int passCount, int frameLatency = 4);
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void beginFrame();
+    // Ends the running pass, if any; a pass may be timed more than once a frame
+    void beginPass(int pass);
+    void endPass();
+    void endFrame();
+
+    // Oldest finished frame since the last call, in ms per pass (0 for
+    // passes that weren't drawn). False when nothing new has arrived.
+    bool popFrame(std::vector<double>& passMs);
+
+    long droppedFrames() const { return dropped; }
+
+private:
+    struct Slot {
+        std::vector<GLuint> queries;
+        std::vector<int> passes;
+        int used = 0;
+        bool pending = false;
+    };
+
+    int passCount;
+    std::vector<Slot> ring;
+    int writeIndex = 0;     // slot being recorded
+    int readIndex = 0;      // oldest pending slot
+    int pendingCount = 0;
+    bool running = false;
+    long dropped = 0;
+    std::deque<std::vector<double>> finished;
+
+    void collect();
+};
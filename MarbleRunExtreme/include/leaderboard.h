@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "track_progress.h"
+#include "marble_entity.h"
+
+struct FinishEntry;
+
+// Live race standings. Finished marbles lead in finish order, the rest
+// follow by distance along the track.
+//
+// Ranks barely change from one tick to the next, so the previous order is
+// re-sorted with an insertion sort, which is linear when little moved.
+// Only a big reshuffle (the first tick, say) falls back to a full sort.
+class Leaderboard {
+public:
+    // Ranks every marble; call after the marbles are synced for the tick.
+    // With spread > 1 only every spread-th marble is re-located, a
+    // different slice each call, and the rest rank where they were last seen.
+    void update(const TrackProgressIndex& index,
+                const std::vector<MarbleEntity>& marbles,
+                const std::vector<FinishEntry>& finishOrder,
+                int spread = 1);
+
+    // Marble indices, leader first
+    const std::vector<int>& order() const { return ranking; }
+
+    // 0-based place of a marble
+    int placeOf(int marble) const { return places[marble]; }
+
+    // Last known position on the track. A marble off the track (in the air,
+    // or fallen off) keeps the one from before.
+    const TrackPosition& progressOf(int marble) const { return progress[marble]; }
+
+    // The track's first `count` segments were retired; shift the segment
+    // hints to match. Distances don't move.
+    void rebase(int count);
+
+    // "place  marble  distance" lines for the top `count`, plus `marble`'s
+    // own line if it isn't among them
+    std::vector<std::string> summary(int count, int marble) const;
+
+private:
+    std::vector<TrackPosition> progress;
+    std::vector<double> keys;           // higher is further ahead
+    std::vector<int> ranking;
+    std::vector<int> places;
+    int slice = 0;                      // next to re-locate when spread
+
+    void sortRanking();
+};
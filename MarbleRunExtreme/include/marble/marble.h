@@ -1,14 +1,14 @@
 #pragma once
 #include <glm/glm.hpp>
-#include <GL/glew.h>
+#include <glm/gtc/quaternion.hpp>
 
+// Render-side state of a marble, drawn by MarbleRenderer
 class Marble {
 public:
     glm::vec3 position;
     glm::vec3 color;
     float radius;
+    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
 
     Marble(glm::vec3 pos, glm::vec3 col, float r);
-
-    void draw(GLuint shaderProgram, const glm::mat4& view, const glm::mat4& projection);
 };
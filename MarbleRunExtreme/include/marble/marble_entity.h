@@ -7,7 +7,7 @@
 class MarbleEntity {
 public:
     Marble renderable;
-    btRigidBody* body;
+    RigidBody body;
 
     MarbleEntity(const glm::vec3& pos,
                  const glm::vec3& color,
@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "marble_entity.h"
+#include "shader_program.h"
+#include "frustum.h"
+#include "render_queue.h"
+#include "stream_buffer.h"
+#include "gl_handle.h"
+
+// Per-marble data read by marble.vert, one entry per instance
+struct MarbleInstance {
+    glm::vec4 positionRadius;   // xyz = centre, w = radius
+    glm::vec4 rotation;         // quaternion (x, y, z, w)
+    glm::vec4 colorHighlight;   // rgb = colour, a = 1 when highlighted
+};
+
+// How marbles are drawn: always the sphere mesh, always ray-traced impostors,
+// or the mesh up close and impostors beyond meshDistance
+enum class MarbleLodMode { Mesh, Impostor, Auto };
+
+// Submits every visible marble as at most two instanced draws, one for the
+// shared sphere mesh and one for camera-facing impostor quads. Instances are
+// written into the caller's stream buffer every frame.
+class MarbleRenderer {
+public:
+    MarbleRenderer();
+
+    MarbleLodMode mode = MarbleLodMode::Auto;
+    float meshDistance = 25.0f;     // camera distance below which Auto uses the mesh
+
+    // View/projection and lighting come from the FrameData uniform block.
+    // Marbles outside the frustum are skipped; LOD uses the queue's camera.
+    // `stream` must be between beginFrame() and flush(), with room for two
+    // MarbleInstance per marble.
+    void submit(RenderQueue& queue,
+                StreamBuffer& stream,
+                const ShaderProgram& meshShader,
+                const ShaderProgram& impostorShader,
+                const std::vector<MarbleEntity>& marbles,
+                const MarbleEntity* highlighted,
+                const Frustum& frustum);
+
+    // Marbles submitted by the last call, per path
+    size_t meshCount() const { return meshInstanceCount; }
+    size_t impostorCount() const { return impostorInstanceCount; }
+
+    // Sphere mesh and impostor quad; instances live in the caller's stream
+    size_t gpuBytes() const { return bufferBytes; }
+
+private:
+    GlVertexArray VAO;
+    GlBuffer VBO, EBO;
+    GLsizei indexCount = 0;
+
+    GlVertexArray impostorVAO;
+    GlBuffer quadVBO;
+
+    size_t meshInstanceCount = 0, impostorInstanceCount = 0;
+    size_t bufferBytes = 0;
+    std::vector<glm::vec4> bounds;
+    std::vector<int> visible;
+};
@@ -0,0 +1,17 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+// Where marbles of the given radii start, with at least `gap` between any
+// two so the first ticks have no overlaps to resolve.
+//
+// Shelf packing: marbles go side by side along x into rows no wider than
+// footprint.x, rows go one behind the other along z into layers no deeper
+// than footprint.y, and layers stack upwards from base.y. Each row is as
+// deep as its largest marble and each layer as tall as its largest, so
+// small marbles pack tight. Rows and layers are centred on base in x and z.
+// Marbles keep their order: marble 0 is the first in the bottom layer.
+std::vector<glm::vec3> packSpawnPositions(const std::vector<float>& radii,
+                                          const glm::vec3& base,
+                                          const glm::vec2& footprint,
+                                          float gap = 0.1f);
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "physics.h"
+#include "track_segment.h"
+
+class Race;
+
+// Bytes held by one thing, by where they live. Containers count their
+// capacity, Bullet objects their own size plus the arrays they own.
+struct MemoryBytes {
+    size_t geometry = 0;        // CPU vertices, normals and indices
+    size_t triangleMesh = 0;    // Bullet mesh interface and any arrays it owns
+    size_t bvh = 0;             // BVH nodes, leaves and subtree headers
+    size_t shapes = 0;          // collision shape objects
+    size_t bodies = 0;          // rigid bodies and their motion states
+    size_t gpu = 0;             // GL buffer and texture storage
+
+    size_t cpu() const { return geometry + triangleMesh + bvh + shapes + bodies; }
+    size_t total() const { return cpu() + gpu; }
+
+    MemoryBytes& operator+=(const MemoryBytes& o);
+};
+
+struct SegmentMemory {
+    long index = 0;             // run-wide, counting retired segments
+    bool sweep = false;
+    int gridU = 0, gridV = 0;
+    size_t vertices = 0, triangles = 0;
+    MemoryBytes bytes;
+};
+
+// What a race costs, per track segment and per subsystem ("track",
+// "obstacles", "marbles", and whatever the renderer adds). The segments
+// are also counted in "track".
+struct MemoryReport {
+    long trackRevision = 0;     // Race::trackRevision when measured
+    std::vector<SegmentMemory> segments;
+    std::vector<std::pair<std::string, MemoryBytes>> subsystems;
+
+    // Adds the subsystem if it isn't there yet
+    MemoryBytes& subsystem(const std::string& name);
+
+    MemoryBytes total() const;
+
+    void writeJson(std::ostream& out) const;
+    bool writeJson(const std::string& path) const;
+};
+
+// Body, shape, triangle mesh and BVH behind one handle
+MemoryBytes measureRigidBody(const RigidBody& body);
+
+// CPU geometry plus the collision body; GPU bytes are left to the renderer
+SegmentMemory measureSegment(const TrackSegment& seg);
+
+// Everything the simulation holds. RaceView::measureMemory adds the GPU side.
+MemoryReport measureMemory(const Race& race);
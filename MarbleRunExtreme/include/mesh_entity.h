@@ -1,16 +1,17 @@
 #pragma once
 #include "renderable_mesh.h"
 #include "physics.h"
+#include <utility>
 
 class MeshEntity {
 public:
-    btRigidBody* body;
+    RigidBody body;
     RenderableMesh renderable;
 
-    MeshEntity(btRigidBody* rb, const RenderableMesh& mesh)
-        : body(rb), renderable(mesh) {}
+    MeshEntity(RigidBody&& rb, RenderableMesh&& mesh)
+        : body(std::move(rb)), renderable(std::move(mesh)) {}
 
-    void draw(GLuint shaderProgram, const glm::mat4& view, const glm::mat4& projection) {
+    void submit(RenderQueue& queue, const ShaderProgram& shader) {
         btTransform trans;
         body->getMotionState()->getWorldTransform(trans);
 
@@ -19,6 +20,6 @@ public:
         glm::quat quat(rot.getW(), rot.getX(), rot.getY(), rot.getZ());
 
         glm::mat4 model = glm::translate(glm::mat4(1.0f), pos) * glm::mat4_cast(quat);
-        renderable.draw(shaderProgram, model, view, projection);
+        renderable.submit(queue, shader, model, queue.depthOf(pos));
     }
 };
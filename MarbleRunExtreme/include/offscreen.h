@@ -0,0 +1,42 @@
+#pragma once
+#include <GL/glew.h>
+#include "gl_handle.h"
+
+// GL context with no window or display server, through EGL. Prefers Mesa's
+// surfaceless platform (works with llvmpipe on a bare server) and falls back
+// to the default display with a 1x1 pbuffer.
+class OffscreenContext {
+public:
+    OffscreenContext() = default;
+    ~OffscreenContext();
+
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    // Core profile context made current on this thread, GLEW initialised
+    bool create(int major = 4, int minor = 1);
+
+private:
+    void* display = nullptr;    // EGLDisplay
+    void* context = nullptr;    // EGLContext
+    void* surface = nullptr;    // EGLSurface, only for the pbuffer fallback
+};
+
+// Colour + depth render target
+class Framebuffer {
+public:
+    Framebuffer(int width, int height);
+
+    // Bind for drawing and reading, and set the viewport to cover it
+    void bind() const;
+    bool complete() const { return isComplete; }
+
+    int width() const { return w; }
+    int height() const { return h; }
+
+private:
+    int w, h;
+    GlFramebuffer fbo;
+    GlRenderbuffer color, depth;
+    bool isComplete = false;
+};
@@ -1,37 +1,113 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <memory>
 #include <vector>
 #include <bullet/btBulletDynamicsCommon.h>
 
+// Collision shape used by several bodies, possibly in different worlds
+// stepped on different threads; Bullet only reads a static shape while
+// stepping. The last owner deletes it and the mesh interface behind it.
+using SharedShape = std::shared_ptr<btCollisionShape>;
+
+// Owning, move-only handle to a rigid body in a PhysicsWorld. On destruction
+// the body leaves the world and is deleted along with its motion state, its
+// collision shape and the triangle mesh behind that shape, if any. Handles
+// must go before the world they were created in.
+class RigidBody {
+public:
+    RigidBody() = default;
+    RigidBody(btDiscreteDynamicsWorld* world, btRigidBody* body, btCollisionShape* shape,
+              btStridingMeshInterface* mesh = nullptr);
+    // Body on a shape it shares rather than owns
+    RigidBody(btRigidBody* body, SharedShape shape);
+    ~RigidBody() { reset(); }
+
+    RigidBody(RigidBody&& other) noexcept;
+    RigidBody& operator=(RigidBody&& other) noexcept;
+    RigidBody(const RigidBody&) = delete;
+    RigidBody& operator=(const RigidBody&) = delete;
+
+    btRigidBody* get() const { return body; }
+    btRigidBody* operator->() const { return body; }
+    explicit operator bool() const { return body != nullptr; }
+
+    // What the handle owns besides the body; the mesh is null for primitives
+    // and for shared shapes
+    btCollisionShape* collisionShape() const { return shape ? shape : sharedShape.get(); }
+    btStridingMeshInterface* meshInterface() const { return mesh; }
+
+    void reset();
+
+private:
+    friend class PhysicsWorld;
+
+    btDiscreteDynamicsWorld* world = nullptr;  // null until added to one
+    btRigidBody* body = nullptr;
+    btCollisionShape* shape = nullptr;
+    btStridingMeshInterface* mesh = nullptr;
+    SharedShape sharedShape;
+};
+
 class PhysicsWorld {
 public:
     PhysicsWorld();
     ~PhysicsWorld();
 
     void step(float deltaTime);
+
+    // Exactly one internal step of `tick` seconds, with no carried-over time
+    // and no interpolated motion states; the same calls give the same world
+    void stepFixed(float tick);
     void addGround();
     void addRigidBody(btRigidBody* body);
     
-    btRigidBody* addSphere(float radius, const glm::vec3& startPos, float mass = 1.0f);
-    btRigidBody* addInclinedPlane(
+    // Bodies from the add* calls are owned by the returned handle; the world
+    // only cleans up what was added with addGround or addRigidBody
+    RigidBody addSphere(float radius, const glm::vec3& startPos, float mass = 1.0f);
+    RigidBody addInclinedPlane(
                                   const glm::vec3& normal,
                                   float constant,
                                   const glm::vec3& position,
                                   const glm::vec3& rotation);
-    btRigidBody* addBox(
+    RigidBody addBox(
                         const glm::vec3& halfExtents,
                         const glm::vec3& position,
                         const glm::vec3& rotation,
                         bool isStatic = true);
     
     glm::vec3 getObjectPosition(btRigidBody* body) const;
-    btRigidBody* addTriangleMesh(
+    glm::quat getObjectRotation(btRigidBody* body) const;
+    RigidBody addTriangleMesh(
                                  const std::vector<glm::vec3>& vertices,
                                  const std::vector<unsigned int>& indices,
                                  const glm::vec3& position,
                                  const glm::vec3& rotation);
     btDiscreteDynamicsWorld* getWorld() { return dynamicsWorld; }
 
+    // The create* calls build a body, shape and (for meshes) BVH without
+    // touching any world, so they can run on a worker thread. add() then puts
+    // the body in this world, on the thread that steps it.
+    //
+    // Triangle meshes reference `vertices` and `indices` rather than copying
+    // them, so both must stay alive and unchanged for as long as the body.
+    // Moving the vectors is fine; their storage stays where it is.
+    static RigidBody createTriangleMesh(const std::vector<glm::vec3>& vertices,
+                                        const std::vector<unsigned int>& indices,
+                                        const glm::vec3& position,
+                                        const glm::vec3& rotation);
+    static RigidBody createBox(const glm::vec3& halfExtents,
+                               const glm::vec3& position,
+                               const glm::vec3& rotation,
+                               bool isStatic = true);
+    void add(RigidBody& body);
+
+    // A triangle mesh shape, with its BVH, for bodies made by createStatic().
+    // The vertices and indices are referenced as above.
+    static SharedShape createTriangleMeshShape(const std::vector<glm::vec3>& vertices,
+                                               const std::vector<unsigned int>& indices);
+    static RigidBody createStatic(const SharedShape& shape);
+
     
 private:
     btDefaultCollisionConfiguration* collisionConfiguration;
@@ -0,0 +1,116 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "physics.h"
+#include "track.h"
+#include "track_utils.h"
+#include "track_generator.h"
+#include "track_cache.h"
+#include "marble_entity.h"
+#include "track_progress.h"
+#include "leaderboard.h"
+
+struct RaceSettings {
+    int marbleCount = 25;
+    unsigned int seed = 0;
+    glm::vec3 spawnCenter = glm::vec3(31.0f, 26.0f, 1.0f);
+    glm::vec2 spawnFootprint = glm::vec2(32.0f, 8.0f);     // x by z; more marbles stack higher
+
+    // No finish: track is generated ahead of the leader and retired behind
+    // it, and marbles left behind with it are out
+    bool endless = false;
+
+    // Same seed, marble count and step() sizes give the same race, tick for
+    // tick: each step() is one fixed physics step, and the endless track is
+    // attached at set distances rather than whenever the worker is done.
+    // Callers still have to pass a constant tick.
+    bool deterministic = false;
+
+    // Live standings. By default each step() re-locates every marble and
+    // re-sorts them. Above 1, only every standingsSpread-th marble is
+    // re-located, a different slice each time, so a marble's place is at
+    // most that many steps old; 0 = no standings. Endless races re-locate
+    // every marble every step, whatever this says, since they retire track
+    // by it.
+    int standingsSpread = 1;
+};
+
+struct FinishEntry {
+    int marble;     // index into Race::marbles
+    float time;     // simulated seconds since the race started
+};
+
+// Everything needed to run a race without a window: physics world, track,
+// obstacles and marbles. Rendering code only reads from it.
+class Race {
+public:
+    // Set when the race runs on a shared track; its shapes read this geometry
+    std::shared_ptr<const BuiltTrack> sharedTrack;
+
+    PhysicsWorld physics;       // before every body handle below, so it outlives them
+    Track track;
+    std::vector<Obstacle> obstacles;
+    std::vector<MarbleEntity> marbles;
+    std::vector<FinishEntry> finishOrder;
+    float elapsed = 0.0f;
+    long ticks = 0;             // step() calls so far
+
+    TrackProgressIndex trackIndex;
+    Leaderboard leaderboard;    // see RaceSettings::standingsSpread
+
+    // Endless mode only
+    std::unique_ptr<TrackGenerator> generator;
+    long trackRevision = 0;     // bumped whenever segments or obstacles change
+    int eliminatedCount = 0;
+
+    explicit Race(const RaceSettings& settings);
+
+    // On a track built elsewhere, e.g. taken from a TrackCache, instead of
+    // the standard course; settings.endless is ignored. Segments get their
+    // own copy of the geometry and bodies on the track's shared shapes.
+    Race(const RaceSettings& settings, std::shared_ptr<const BuiltTrack> track);
+
+    Race(const Race&) = delete;
+    Race& operator=(const Race&) = delete;
+
+    // Step physics, sync marble positions, check the finish line and update the standings
+    void step(float deltaTime);
+
+    // Returns how many marbles crossed the finish in this call
+    int checkFinish();
+
+    // Hash of everything that moves: every marble's transform, velocities,
+    // activation and race state, in marble order, plus the tick. Two runs
+    // have diverged by the first tick where these differ.
+    uint64_t stateHash() const;
+
+    // Editing a fixed track (not an endless one). A new segment's body joins
+    // the world; segments after the edit move to follow on and take their
+    // obstacles along, and obstacles on a removed or replaced segment go
+    // with it. Only the new segment's geometry is ever built, by the caller.
+    // The last segment is always the finish, and the track can't be emptied.
+    void insertSegment(size_t index, TrackSegment&& seg);
+    void removeSegment(size_t index);
+    void replaceSegment(size_t index, TrackSegment&& seg);
+    void setTrackStart(const glm::mat4& transform);
+
+    MarbleEntity* winner();
+    bool isEliminated(int marble) const { return eliminated[marble]; }
+    TrackSegment& finishSegment() { return track.segments.back(); }
+    bool allFinished() const { return finishOrder.size() == marbles.size(); }
+
+private:
+    RaceSettings settings;
+    std::vector<bool> finished;
+    std::vector<bool> eliminated;
+
+    void buildTrack(unsigned int seed);
+    template <class MakeSegment>
+    void layTrack(const TrackDescription& description, unsigned int seed, MakeSegment&& segmentFor);
+    void buildEndlessStart(unsigned int seed);
+    void advanceTrack();
+    void spawnMarbles(int count, unsigned int seed);
+
+    template <class Edit> void editTrack(Edit&& edit);
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "farm_protocol.h"
+#include "track_cache.h"
+
+struct RaceFarmSettings {
+    std::string socketPath;
+    int workers = 0;                // 0 = one per hardware thread
+    size_t cachedTracks = 8;
+
+    // A job's finishers go out together at most this often, and at the end
+    int finishBatchTicks = 60;
+};
+
+struct RaceFarmStats {
+    long jobsDone = 0;
+    long jobsFailed = 0;            // bad request, or cut off by stop()
+    TrackCacheStats cache;
+};
+
+// Long-lived race server on a Unix domain socket (see farm_protocol.h).
+// Each connection gets a thread reading its jobs into one queue, and a pool
+// of workers runs them, each job in its own Race and so its own physics
+// world. Tracks come from a TrackCache shared by the workers, so repeated
+// jobs on a track only build marbles and bodies.
+class RaceFarm {
+public:
+    explicit RaceFarm(const RaceFarmSettings& settings);
+    ~RaceFarm();
+
+    RaceFarm(const RaceFarm&) = delete;
+    RaceFarm& operator=(const RaceFarm&) = delete;
+
+    // Bind the socket, replacing a stale one left at the path. False, with
+    // a message on stderr, if it can't.
+    bool listen();
+
+    // Accept and run jobs until stop(); returns with every thread joined
+    // and the socket removed
+    void serve();
+
+    // Safe from any thread and from a signal handler. Running races are
+    // cut off with an error, queued jobs dropped.
+    void stop();
+
+    RaceFarmStats stats() const;
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::mutex writeMutex;
+        std::atomic<bool> closed{ false };      // a write failed; stop its jobs
+
+        ~Connection();
+        bool send(const std::vector<uint8_t>& bytes);
+    };
+
+    struct Job {
+        std::shared_ptr<Connection> connection;
+        FarmJob request;
+    };
+
+    struct Client {
+        std::shared_ptr<Connection> connection;
+        std::thread reader;
+        std::shared_ptr<std::atomic<bool>> finished;
+    };
+
+    RaceFarmSettings settings;
+    TrackCache cache;
+    int listenFd = -1;
+    int wakeFds[2] = { -1, -1 };    // stop() writes, serve() polls
+    std::atomic<bool> stopping{ false };
+
+    mutable std::mutex mutex;
+    std::condition_variable jobReady;
+    std::deque<Job> queue;
+    long jobsDone = 0, jobsFailed = 0;
+
+    std::list<Client> clients;      // serve() thread only
+    std::vector<std::thread> workers;
+
+    void readLoop(std::shared_ptr<Connection> connection);
+    void workerLoop();
+    void run(const Job& job);
+    void fail(const Job& job, const std::string& message);
+    void reapClients(bool all);
+};
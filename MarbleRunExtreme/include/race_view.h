@@ -0,0 +1,91 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "race.h"
+#include "shader_program.h"
+#include "skybox.h"
+#include "marble_renderer.h"
+#include "track_batch.h"
+#include "obstacle_renderer.h"
+#include "cube_mesh.h"
+#include "stream_buffer.h"
+#include "render_queue.h"
+#include "frustum.h"
+#include "memory_report.h"
+
+// Where the race is looked at from in one frame
+struct ViewParams {
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec3 position = glm::vec3(0.0f);       // camera, for LOD and sorting
+    int viewportHeight = 1;                     // pixels, for track LOD
+    glm::vec3 lightPos = glm::vec3(2.0f, 2.0f, 2.0f);
+};
+
+// Everything that draws a race: shader programs, skybox, batched track,
+// marbles and obstacles, all through one render queue. The game window and
+// the offscreen capture tool both draw with this, so they show the same scene.
+//
+// Loading is either load() on the GL thread, or filling in the public
+// members by other means (e.g. the game's async startup) and then calling
+// finishLoading().
+class RaceView {
+public:
+    ShaderProgram skyboxProgram, marbleProgram, marbleImpostorProgram, obstacleProgram, trackBatchProgram;
+    std::unique_ptr<Skybox> skybox;
+    TrackBatch trackBatch;
+
+    struct ProgramFiles {
+        ShaderProgram* program;
+        std::string vertexPath, fragmentPath;
+        std::vector<std::string> sharedFragmentPaths;
+    };
+
+    // The programs above and the files each is built from, relative to the working directory
+    std::vector<ProgramFiles> programFiles();
+
+    // Build everything synchronously. Needs a current GL context.
+    void load(const Race& race, const std::string& skyboxPath);
+
+    // Uniforms that never change; call once every program is built
+    void setProgramConstants();
+
+    // Frame uniforms, marble buffers and culling lists. Call once the
+    // programs, skybox and track batch are in place.
+    void finishLoading(const Race& race);
+
+    // Clear the bound framebuffer and draw the race. With a timer, each
+    // render pass is timed on the GPU.
+    void render(const Race& race, const ViewParams& params, const MarbleEntity* highlighted,
+                GpuTimer* timer = nullptr);
+
+    const RenderStats& stats() const { return queue.stats(); }
+
+    // Frames that waited for the GPU to release per-frame instance memory
+    long streamStalls() const { return instanceStream ? instanceStream->fenceStalls() : 0; }
+
+    // Add GPU buffer and texture bytes to a report from measureMemory(race):
+    // per segment and under "track", "obstacles", "marbles" and "skybox"
+    void measureMemory(MemoryReport& report) const;
+
+private:
+    std::unique_ptr<FrameUniformBuffer> frameUniforms;
+    std::unique_ptr<MarbleRenderer> marbleRenderer;
+    std::unique_ptr<StreamBuffer> instanceStream;   // marble instances, rewritten every frame
+    std::unique_ptr<CubeMesh> cube;
+    std::unique_ptr<ObstacleRenderer> obstacleRenderer;
+    RenderQueue queue;
+
+    // Track and obstacles never move, so their bounds are only gathered
+    // again when the race's track revision changes (endless mode)
+    AabbList segmentBounds, obstacleBounds;
+    std::vector<int> visibleSegments, visibleObstacles;
+    long trackRevision = -1;
+
+    // Obstacle instances and culling bounds for the race's current track
+    void syncTrack(const Race& race);
+
+    static size_t marbleStreamBytes(const Race& race);
+};
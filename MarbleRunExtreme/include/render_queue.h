@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "shader_program.h"
+#include "gpu_timer.h"
+
+// Texture and depth state shared by every packet that uses it. Owned by the
+// renderer that submits it and compared by address.
+struct Material {
+    GLenum textureTarget = 0;       // 0 = no texture
+    GLuint texture = 0;
+    GLuint textureUnit = 0;
+    GLenum depthFunc = GL_LESS;
+};
+
+enum class DrawKind { Arrays, Elements, ArraysInstanced, ElementsInstanced, MultiElementsBaseVertex };
+
+// The GL draw call a packet ends in. Multi-draw arrays belong to the
+// submitter and have to stay alive until the queue is flushed.
+struct DrawCommand {
+    DrawKind kind = DrawKind::Arrays;
+    GLenum mode = GL_TRIANGLES;
+    GLint first = 0;
+    GLsizei count = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    const void* indexOffset = nullptr;
+    GLsizei instanceCount = 1;
+
+    const GLsizei* counts = nullptr;
+    const void* const* offsets = nullptr;
+    const GLint* baseVertices = nullptr;
+    GLsizei drawCount = 0;
+};
+
+// Draw order between groups of packets, lowest first
+enum class RenderLayer : uint8_t { Opaque = 0, Sky = 1 };
+
+// What a packet draws. Within a layer, packets go out one pass at a time so
+// each pass can be timed on the GPU as a whole.
+enum class RenderPass : uint8_t { Marbles, Track, Obstacles, Sky, Count };
+
+const char* renderPassName(RenderPass pass);
+
+struct DrawPacket {
+    const ShaderProgram* program = nullptr;
+    GLuint vao = 0;
+    const Material* material = nullptr;
+    float depth = 0.0f;             // distance from the camera, sorts front to back
+    RenderLayer layer = RenderLayer::Opaque;
+    RenderPass pass = RenderPass::Track;
+
+    bool hasModel = false;          // upload `model` to the "model" uniform
+    glm::mat4 model = glm::mat4(1.0f);
+
+    DrawCommand command;
+};
+
+// What the last flush sent to GL
+struct RenderStats {
+    int draws = 0;
+    int programChanges = 0;
+    int vaoChanges = 0;
+    int materialChanges = 0;
+    int uniformUploads = 0;
+
+    int stateChanges() const { return programChanges + vaoChanges + materialChanges + uniformUploads; }
+};
+
+// Collects a frame's draw packets, then sorts them by layer, pass, program
+// and depth (front to back, for early-z) and issues them, skipping any
+// program, VAO, texture or depth function that is already bound.
+class RenderQueue {
+public:
+    // Start a new frame; depths are measured from cameraPos
+    void begin(const glm::vec3& cameraPos);
+
+    void submit(const DrawPacket& packet) { packets.push_back(packet); }
+
+    const glm::vec3& cameraPosition() const { return camera; }
+    float depthOf(const glm::vec3& worldPos) const { return glm::length(worldPos - camera); }
+
+    // Sort and issue everything submitted since begin(). With a timer, each
+    // pass is wrapped in a GPU time query.
+    void flush(GpuTimer* timer = nullptr);
+
+    const RenderStats& stats() const { return frameStats; }
+
+private:
+    glm::vec3 camera = glm::vec3(0.0f);
+    std::vector<DrawPacket> packets;
+    std::vector<uint32_t> order;
+    RenderStats frameStats;
+
+    void issue(const DrawCommand& command);
+};
@@ -3,12 +3,20 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include "shader_program.h"
+#include "render_queue.h"
+#include "gl_handle.h"
 
+// Owns its buffers, so it moves but never copies
 class RenderableMesh {
 public:
-    GLuint VAO = 0, VBO = 0, EBO = 0;
-    size_t indexCount = 0;
+    GlVertexArray VAO;
+    GlBuffer VBO, EBO;
+    size_t vertexCount = 0, indexCount = 0;
 
+    size_t gpuBytes() const { return vertexCount * 6 * sizeof(float) + indexCount * sizeof(unsigned int); }
+
+    // Replaces anything loaded before
     void load(const std::vector<glm::vec3>& vertices,
               const std::vector<glm::vec3>& normals,
               const std::vector<unsigned int>& indices) {
@@ -23,11 +31,12 @@ public:
             data.push_back(normals[i].z);
         }
 
+        vertexCount = vertices.size();
         indexCount = indices.size();
 
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+        VAO = GlVertexArray::create();
+        VBO = GlBuffer::create();
+        EBO = GlBuffer::create();
         glBindVertexArray(VAO);
 
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
@@ -44,14 +53,16 @@ public:
         glBindVertexArray(0);
     }
 
-    void draw(GLuint shaderProgram, const glm::mat4& model,
-              const glm::mat4& view, const glm::mat4& projection) const {
-        glUseProgram(shaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, &model[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, &view[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, &projection[0][0]);
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, (GLsizei)indexCount, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    // View/projection come from the FrameData uniform block
+    void submit(RenderQueue& queue, const ShaderProgram& shader, const glm::mat4& model, float depth) const {
+        DrawPacket packet;
+        packet.program = &shader;
+        packet.vao = VAO;
+        packet.depth = depth;
+        packet.hasModel = true;
+        packet.model = model;
+        packet.command.kind = DrawKind::Elements;
+        packet.command.count = (GLsizei)indexCount;
+        queue.submit(packet);
     }
 };
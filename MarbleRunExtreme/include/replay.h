@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "marble_entity.h"
+
+// Records marble positions once per tick into a compact byte stream.
+//
+// Layout: "MRRP", u8 version, varint marble count, f32 tick rate, f32 position
+// step; then for every frame and marble the zigzag varint delta of the
+// quantized x/y/z position against the previous frame.
+class ReplayRecorder {
+public:
+    ReplayRecorder(int marbleCount, float tickRate, float positionStep = 0.001f);
+
+    void recordFrame(const std::vector<MarbleEntity>& marbles);
+    void recordFrame(const std::vector<glm::vec3>& positions);
+
+    size_t frameCount() const { return frames; }
+    const std::vector<uint8_t>& bytes() const { return data; }
+
+    bool save(const std::string& path) const;
+
+private:
+    int marbleCount;
+    float positionStep;
+    size_t frames = 0;
+    std::vector<int32_t> previous;   // quantized x/y/z per marble
+    std::vector<uint8_t> data;
+
+    void writeVarint(uint64_t v);
+    void writeFloat(float f);
+    void writePosition(int marble, const glm::vec3& p);
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "shader_utils.h"
+#include "gl_handle.h"
+
+// Binding point of the FrameData uniform block shared by all shaders
+const GLuint FRAME_UNIFORM_BINDING = 0;
+
+// Linked GL program with its active uniform locations looked up once at link
+// time, so draws never call glGetUniformLocation.
+class ShaderProgram {
+public:
+    ShaderProgram() = default;
+    ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath,
+                  const std::vector<std::string>& sharedFragmentPaths = {});
+    // Compile sources already read with loadShaderSources
+    explicit ShaderProgram(const ShaderSources& sources);
+
+    GLuint id() const { return program; }
+    void use() const { glUseProgram(program); }
+
+    // -1 if the uniform doesn't exist or was optimised out
+    GLint uniform(const std::string& name) const;
+
+    void set(const std::string& name, int value) const;
+    void set(const std::string& name, const glm::vec3& value) const;
+    void set(const std::string& name, const glm::mat4& value) const;
+
+private:
+    GlProgram program;
+    std::unordered_map<std::string, GLint> uniforms;
+
+    void reflect();
+};
+
+// Per-frame camera and light data, std140 layout matching FrameData in the shaders
+struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 lightPos;
+    glm::vec4 viewPos;
+};
+
+// Uniform buffer holding FrameUniforms, updated and bound once per frame
+class FrameUniformBuffer {
+public:
+    FrameUniformBuffer();
+
+    void update(const FrameUniforms& data);
+
+private:
+    GlBuffer UBO;
+};
@@ -1,6 +1,46 @@
 #pragma once
 #include <string>
+#include <vector>
 #include <GL/glew.h>
 
 std::string loadShaderSource(const std::string& filePath);
-GLuint createShaderProgram(const std::string& vertexPath, const std::string& fragmentPath);
+
+// Source text of every stage of a program, read ahead of compiling. Loading
+// needs no GL context, so it can happen on another thread.
+struct ShaderSources {
+    struct Stage {
+        std::string path;       // only used in error messages
+        std::string code;
+    };
+    Stage vertex;
+    Stage fragment;
+    std::vector<Stage> sharedFragments;
+};
+
+ShaderSources loadShaderSources(const std::string& vertexPath, const std::string& fragmentPath,
+                                const std::vector<std::string>& sharedFragmentPaths = {});
+
+// sharedFragmentPaths are extra fragment shaders (functions only, no main)
+// linked into the same program, so several programs can share code
+GLuint createShaderProgram(const std::string& vertexPath, const std::string& fragmentPath,
+                           const std::vector<std::string>& sharedFragmentPaths = {});
+
+// Checks the program binary cache first, see below
+GLuint createShaderProgram(const ShaderSources& sources);
+
+// Linked programs are saved with glGetProgramBinary and reloaded with
+// glProgramBinary on the next launch. Entries are keyed by a hash of every
+// stage's source plus the GL vendor, renderer and version strings, so an
+// edited shader or a driver update just misses and compiles from source.
+// A binary the driver rejects is recompiled and overwritten.
+struct ProgramCacheStats {
+    int hits = 0;
+    int misses = 0;
+    int rejected = 0;       // found on disk but refused by the driver
+    int stores = 0;
+};
+
+// Defaults to "shader_cache" under the working directory; empty disables the cache
+void setProgramCacheDir(const std::string& dir);
+const std::string& programCacheDir();
+const ProgramCacheStats& programCacheStats();
@@ -3,19 +3,33 @@
 #include <glm/glm.hpp>
 #include <string>
 #include <vector>
+#include "shader_program.h"
+#include "render_queue.h"
+#include "cubemap_cache.h"
+#include "gl_handle.h"
 
 class Skybox{
 public:
     Skybox(const std::vector<std::string>& faces);
     Skybox(const std::string& atlasPath);
-    ~Skybox();
+    // Upload a cubemap loaded elsewhere, e.g. on a startup worker
+    explicit Skybox(const CubemapView& cubemap);
     
-    void draw(const glm::mat4& view, const glm::mat4& projection, GLuint shaderProgram);
+    // View/projection come from the FrameData uniform block. Goes in the sky
+    // layer, after everything opaque, with GL_LEQUAL so it only fills gaps.
+    void submit(RenderQueue& queue, const ShaderProgram& shader);
+
+    // Cubemap texels as uploaded (drivers may pad RGB to four bytes), plus the cube
+    size_t gpuBytes() const { return textureBytes + vertexBytes; }
     
 private:
-    GLuint cubemapTexture;
-    GLuint VAO, VBO;
+    GlTexture cubemapTexture;
+    GlVertexArray VAO;
+    GlBuffer VBO;
+    Material material;
+    size_t textureBytes = 0, vertexBytes = 0;
 
-    GLuint loadCubemap(const std::vector<std::string>& faces);
-    GLuint loadCubemapFromAtlas(const std::string& atlasPath);
+    void createGeometry();
+    GlTexture loadCubemap(const std::vector<std::string>& faces);
+    GlTexture loadCubemapFromAtlas(const std::string& atlasPath);
 };
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <bullet/btBulletDynamicsCommon.h>
+
+// 64-bit FNV-1a. Floats go in by their bit patterns, so two states only hash
+// the same if they match to the last bit.
+class StateHash {
+public:
+    void add(const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            h ^= bytes[i];
+            h *= 1099511628211ull;
+        }
+    }
+
+    void add(float v) { add(&v, sizeof(v)); }
+    void add(int64_t v) { add(&v, sizeof(v)); }
+
+    // x, y, z only; the fourth lane is padding
+    void add(const btVector3& v) { add((float)v.x()); add((float)v.y()); add((float)v.z()); }
+    void add(const btQuaternion& q) { add((float)q.x()); add((float)q.y()); add((float)q.z()); add((float)q.w()); }
+
+    uint64_t value() const { return h; }
+
+private:
+    uint64_t h = 14695981039346656037ull;
+};
+
+// Per-tick hash logs: one "tick hash" line per tick from tick 0, the hash as
+// 16 hex digits, so two runs can be compared with diff or loaded back
+// here to find the first tick that differs
+std::string formatStateHash(uint64_t hash);
+bool loadStateHashLog(const std::string& path, std::vector<uint64_t>& hashes);
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <GL/glew.h>
+
+// Persistent: one buffer mapped for its whole life (GL 4.4 or
+// ARB_buffer_storage), split into per-frame regions guarded by fences.
+// Orphaning: GL 3.3/4.1 fallback; the buffer is remapped with
+// GL_MAP_INVALIDATE_BUFFER_BIT every frame so the driver hands out fresh
+// storage instead of waiting on the draws still reading the old one.
+enum class StreamMode { Auto, Persistent, Orphaning };
+
+// Per-frame vertex data written by the CPU straight into GL memory, with no
+// glBufferData or glBufferSubData call that could stall on the GPU.
+//
+// Each frame: beginFrame(), allocate() and write, flush(), issue the draws
+// that read it, endFrame(). The buffer name stays the same from frame to
+// frame but offsets don't, so attribute pointers have to be set from the
+// offsets allocate() returns, every frame.
+class StreamBuffer {
+public:
+    explicit StreamBuffer(size_t bytesPerFrame, StreamMode mode = StreamMode::Auto, int frames = 3);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    GLuint id() const { return buffer; }
+    bool persistent() const { return mode == StreamMode::Persistent; }
+
+    // Move to the next frame's region, grown to at least `bytes`. Waits if
+    // the GPU is still reading that region from `frames` frames ago.
+    void beginFrame(size_t bytes = 0);
+
+    // Room for `bytes` in this frame's region. `offset` is from the start
+    // of the buffer. nullptr once the region is full.
+    void* allocate(size_t bytes, size_t alignment, size_t& offset);
+
+    // Make this frame's writes visible to GL; call before drawing from them
+    void flush();
+
+    // Call once the draws reading this frame's data have been issued
+    void endFrame();
+
+    // Frames that had to wait for the GPU in beginFrame
+    long fenceStalls() const { return stalls; }
+
+    // Storage asked of GL: every region when persistent, one when orphaning
+    size_t gpuBytes() const { return persistent() ? regionSize * frameCount : regionSize; }
+
+private:
+    StreamMode mode;
+    size_t regionSize;
+    int frameCount;
+
+    GLuint buffer = 0;
+    char* persistentBase = nullptr;     // whole buffer, persistent mode only
+    char* frameBase = nullptr;          // this frame's region while it's writable
+    size_t frameOffset = 0;             // of this frame's region in the buffer
+    size_t cursor = 0;
+    int region = -1;
+    std::vector<GLsync> fences;
+    long stalls = 0;
+
+    void create();
+    void destroy();
+    void wait(GLsync& fence);
+};
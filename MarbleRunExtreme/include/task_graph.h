@@ -0,0 +1,82 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Where a task may run. GL calls need the thread that owns the context, so
+// anything touching GL is a Main task and runs inside runMainThreadTasks().
+enum class TaskThread { Worker, Main };
+
+// Small dependency graph of one-shot tasks, used for startup. Worker tasks
+// run on a private thread pool as soon as their dependencies finish; main
+// tasks are queued until the owning thread pumps them, so it can keep
+// drawing frames in between.
+class TaskGraph {
+public:
+    using TaskId = int;
+
+    // 0 = one less than the hardware thread count, at least one
+    explicit TaskGraph(int workerCount = 0);
+    // Waits for running worker tasks; unstarted ones are dropped
+    ~TaskGraph();
+
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    // Tasks can only be added before start()
+    TaskId add(const std::string& name, std::function<void()> work,
+               const std::vector<TaskId>& dependencies = {}, TaskThread thread = TaskThread::Worker);
+
+    void start();
+
+    // Run ready main-thread tasks until none are left or budgetMs has passed.
+    // Returns how many ran.
+    int runMainThreadTasks(double budgetMs);
+
+    // Block until everything has finished, running main tasks as they become ready
+    void wait();
+
+    bool finished(TaskId id) const;
+    bool allFinished() const;
+    int finishedCount() const;
+    int size() const { return (int)tasks.size(); }
+
+    // One line per task: thread, start and end in ms since start()
+    void report(std::ostream& out) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Task {
+        std::string name;
+        std::function<void()> work;
+        std::vector<TaskId> dependents;
+        TaskThread thread = TaskThread::Worker;
+        int pendingDependencies = 0;
+        bool done = false;
+        double startMs = 0.0, endMs = 0.0;
+    };
+
+    std::vector<Task> tasks;
+    std::vector<std::thread> workers;
+    int workerCount;
+
+    mutable std::mutex mutex;
+    std::condition_variable workerWake;     // worker queue or stopping changed
+    std::condition_variable mainWake;       // main queue or completion changed
+    std::deque<TaskId> workerQueue, mainQueue;
+    int doneCount = 0;
+    bool started = false, stopping = false;
+    Clock::time_point startTime;
+
+    void workerLoop();
+    void run(TaskId id);                    // called without the lock
+    void enqueueLocked(TaskId id);
+    double msSinceStart() const;
+};
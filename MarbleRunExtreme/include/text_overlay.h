@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "shader_program.h"
+#include "gl_handle.h"
+
+const GLuint TEXT_FONT_TEXTURE_UNIT = 2;
+
+// Lines of debug text in the top-left corner, on a dark panel, drawn with a
+// built-in 5x7 pixel font as one instanced draw. Only upper case, digits
+// and a little punctuation; lower case is shown as upper case.
+class TextOverlay {
+public:
+    TextOverlay();
+
+    int scale = 2;      // screen pixels per font pixel
+
+    // Re-uploads the glyphs; cheap, but not something to do every frame
+    void setText(const std::vector<std::string>& lines);
+
+    // Draw over whatever is in the bound framebuffer. The shader's "font"
+    // sampler must be set to TEXT_FONT_TEXTURE_UNIT.
+    void draw(const ShaderProgram& shader, int screenWidth, int screenHeight) const;
+
+private:
+    GlVertexArray VAO;
+    GlBuffer quadVBO, instanceVBO;
+    GlTexture fontTexture;
+    size_t instanceCapacity = 0;
+    GLsizei glyphCount = 0;
+    int columns = 0, rows = 0;
+};
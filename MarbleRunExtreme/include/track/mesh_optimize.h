@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Simulated post-transform cache size used by the optimiser
+const int VERTEX_CACHE_SIZE = 32;
+
+// Reorder triangles for the post-transform vertex cache (Forsyth's linear-speed
+// algorithm). Triangles keep their winding; only their order changes.
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+
+// Renumber vertices in the order the index buffer first uses them, so vertex
+// fetch walks memory forwards. Rewrites indices and returns remap[old] = new.
+std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int>& indices, size_t vertexCount);
+
+// Average cache miss ratio (transformed vertices per triangle) for a FIFO cache
+float averageCacheMissRatio(const std::vector<unsigned int>& indices, size_t vertexCount,
+                            int cacheSize = 16);
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "obstacle_utils.h"
+#include "cube_mesh.h"
+#include "shader_program.h"
+#include "render_queue.h"
+#include "gl_handle.h"
+
+// Per-obstacle data read by obstacle.vert, one entry per instance
+struct ObstacleInstance {
+    glm::vec4 position;         // xyz = centre
+    glm::vec4 rotation;         // quaternion (x, y, z, w)
+    glm::vec4 halfExtents;      // xyz = half size along the box's own axes
+};
+
+// Draws every static obstacle as one instanced draw of the shared cube. The
+// obstacles never move, so their instances are uploaded once by build() and
+// never touched again.
+class ObstacleRenderer {
+public:
+    explicit ObstacleRenderer(const CubeMesh& cube);
+
+    // Upload the instances. Call again only if the obstacle list changes.
+    void build(const std::vector<Obstacle>& obstacles);
+
+    // View/projection and lighting come from the FrameData uniform block.
+    // Draws all obstacles if any of them is visible: re-uploading the visible
+    // subset would cost more than letting the GPU clip the rest. The packet
+    // sorts at the nearest visible obstacle.
+    void submit(RenderQueue& queue, const ShaderProgram& shader,
+                const std::vector<Obstacle>& obstacles, const std::vector<int>& visible) const;
+
+    size_t instanceCount() const { return count; }
+    size_t gpuBytes() const { return count * sizeof(ObstacleInstance); }
+
+private:
+    GlVertexArray VAO;
+    GlBuffer instanceVBO;
+    size_t count = 0;
+};
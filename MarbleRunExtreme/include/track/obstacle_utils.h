@@ -2,25 +2,59 @@
 #include "box_entity.h"
 #include <vector>
 #include <random>
+#include <glm/gtc/type_ptr.hpp>
 #include "track_segment.h"
 #include "physics.h"
+#include "frustum.h"
 
 struct Obstacle {
-    BoxEntity* box = nullptr;
+    BoxEntity box;
+    Aabb bounds;    // obstacles are static; world bounds of the box
+    long segment = -1;  // run-wide index of the segment it sits on, if retired with it
 };
 
 
-inline Obstacle buildObstacle(
-    PhysicsWorld& physics,
+// Static box with its body not yet in a world; see PhysicsWorld::add
+inline Obstacle makeObstacle(
     const glm::vec3& worldPos,
     const glm::vec3& size
 ) {
     glm::vec3 halfExtents = size * 0.5f;
 
-    btRigidBody* body = physics.addBox(halfExtents, worldPos, glm::vec3(0.0f), true);
+    Aabb bounds;
+    bounds.min = worldPos - halfExtents;
+    bounds.max = worldPos + halfExtents;
+
+    return Obstacle{ BoxEntity(PhysicsWorld::createBox(halfExtents, worldPos, glm::vec3(0.0f), true), halfExtents),
+                     bounds };
+}
+
+// Move a placed obstacle rigidly by `delta`, e.g. along with its segment
+inline void transformObstacle(Obstacle& o, const glm::mat4& delta) {
+    btTransform current;
+    o.box.body->getMotionState()->getWorldTransform(current);
+    btTransform by;
+    by.setFromOpenGLMatrix(glm::value_ptr(delta));
+    btTransform moved = by * current;
+    o.box.body->setWorldTransform(moved);
+    o.box.body->getMotionState()->setWorldTransform(moved);
 
-    Obstacle o;
-    o.box = new BoxEntity(body, halfExtents);
+    glm::mat4 m;
+    moved.getOpenGLMatrix(glm::value_ptr(m));
+    const glm::vec3& h = o.box.renderable.size;
+    o.bounds = Aabb();
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec3 p((corner & 1) ? h.x : -h.x, (corner & 2) ? h.y : -h.y, (corner & 4) ? h.z : -h.z);
+        o.bounds.expand(glm::vec3(m * glm::vec4(p, 1.0f)));
+    }
+}
 
+inline Obstacle buildObstacle(
+    PhysicsWorld& physics,
+    const glm::vec3& worldPos,
+    const glm::vec3& size
+) {
+    Obstacle o = makeObstacle(worldPos, size);
+    physics.add(o.box.body);
     return o;
 }
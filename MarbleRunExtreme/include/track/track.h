@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <utility>
 #include <vector>
 #include "track_segment.h"
 
@@ -6,39 +8,109 @@ class Track {
 public:
     std::vector<TrackSegment> segments;
 
-    void addSegment(TrackSegment seg) {
-        if (segments.empty()) {
-            seg.setWorldTransform(glm::mat4(1.0f));
-            segments.push_back(seg);
-            return;
+    // Segments dropped off the front by retireFront(), and the arc length
+    // they covered. Segment i here is segment retired + i of the whole run.
+    size_t retired = 0;
+    float startDistance = 0.0f;
+
+    // Takes the segment over; pass a temporary or std::move it in
+    TrackSegment& addSegment(TrackSegment&& seg) {
+        return insertSegment(segments.size(), std::move(seg));
+    }
+
+    // Editing. A new segment attaches where the one at `index` did, and the
+    // segments after it are moved to follow on, stopping at the first one
+    // that is already in place. Nothing before the edit is touched, and no
+    // segment but the new one needs its geometry built.
+
+    TrackSegment& insertSegment(size_t index, TrackSegment&& seg) {
+        index = std::min(index, segments.size());
+        seg.id = nextSegmentId++;
+        seg.setWorldTransform(segments.empty() ? glm::mat4(1.0f) : attachmentTransform(entryFrame(index), seg));
+        segments.insert(segments.begin() + index, std::move(seg));
+        relink(index + 1);
+        return segments[index];
+    }
+
+    void removeSegment(size_t index) {
+        if (index >= segments.size()) return;
+        glm::mat4 frame = entryFrame(index);
+        segments.erase(segments.begin() + index);
+        if (index < segments.size()) {
+            segments[index].setWorldTransform(attachmentTransform(frame, segments[index]));
+            relink(index + 1);
         }
+    }
 
-        TrackSegment& prev = segments.back();
-        glm::mat4 T = computeAttachmentTransform(prev, seg);
+    // E.g. the same kind of segment built with new parameters
+    TrackSegment& replaceSegment(size_t index, TrackSegment&& seg) {
+        if (index >= segments.size())
+            return addSegment(std::move(seg));
+        seg.id = nextSegmentId++;
+        seg.setWorldTransform(attachmentTransform(entryFrame(index), seg));
+        segments[index] = std::move(seg);
+        relink(index + 1);
+        return segments[index];
+    }
 
-        seg.setWorldTransform(T);
-        segments.push_back(seg);
+    // Place the first segment and everything after it
+    void setStartTransform(const glm::mat4& t) {
+        if (segments.empty()) return;
+        segments[0].setWorldTransform(t);
+        relink(1);
     }
 
-private:
-    glm::mat4 computeAttachmentTransform(
-        const TrackSegment& prev,
-        const TrackSegment& next
-    ) {
+    // Re-attach segments from `first` on to their predecessors. Returns one
+    // past the last segment that moved.
+    size_t relink(size_t first) {
+        size_t i = std::max<size_t>(first, 1);
+        for (; i < segments.size(); ++i) {
+            glm::mat4 T = attachmentTransform(exitFrame(segments[i - 1]), segments[i]);
+            if (T == segments[i].worldTransform)
+                break;
+            segments[i].setWorldTransform(T);
+        }
+        return i;
+    }
+
+    // Frame a segment at `index` attaches to: the previous segment's exit,
+    // or for the first segment, where its entry is now
+    glm::mat4 entryFrame(size_t index) const {
+        if (index > 0)
+            return exitFrame(segments[std::min(index, segments.size()) - 1]);
+        return glm::translate(segments[0].worldTransform, segments[0].entryPos);
+    }
+
+    // Drop the first `count` segments and their bodies
+    void retireFront(size_t count) {
+        count = std::min(count, segments.size());
+        for (size_t i = 0; i < count; ++i)
+            startDistance += segments[i].length();
+        segments.erase(segments.begin(), segments.begin() + count);
+        retired += count;
+    }
+
+    // World-space frame at a segment's exit: x = right, y = up, z = forward
+    static glm::mat4 exitFrame(const TrackSegment& prev) {
         glm::vec3 P = glm::vec3(prev.worldTransform * glm::vec4(prev.exitPos, 1.0f));
         glm::vec3 F = glm::normalize(glm::vec3(prev.worldTransform * glm::vec4(prev.exitForward, 0.0f)));
         glm::vec3 U = glm::normalize(glm::vec3(prev.worldTransform * glm::vec4(prev.exitUp, 0.0f)));
         glm::vec3 R = glm::normalize(glm::cross(F, U));
 
-        glm::mat4 endBasis(
+        return glm::mat4(
             glm::vec4(R,0),
             glm::vec4(U,0),
             glm::vec4(F,0),
             glm::vec4(P,1)
         );
+    }
 
+    // Transform that puts `next`'s entry on a frame from exitFrame()
+    static glm::mat4 attachmentTransform(const glm::mat4& frame, const TrackSegment& next) {
         glm::mat4 removeEntry = glm::translate(glm::mat4(1.0f), -next.entryPos);
-
-        return endBasis * removeEntry;
+        return frame * removeEntry;
     }
+
+private:
+    uint64_t nextSegmentId = 1;
 };
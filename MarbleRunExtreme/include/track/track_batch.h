@@ -0,0 +1,183 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "track.h"
+#include "shader_program.h"
+#include "frustum.h"
+#include "render_queue.h"
+#include "gl_handle.h"
+
+// Texture unit the per-segment bounds and transform buffer is bound to while drawing
+const GLuint TRACK_BOUNDS_TEXTURE_UNIT = 1;
+
+// RGBA32F texels per segment slot: local bounds min, local bounds extent,
+// then the three rows of the segment's (rigid) local-to-world transform
+const int TRACK_TEXELS_PER_SLOT = 5;
+
+// 12-byte track vertex read by track_batch.vert. Position is 16-bit unorm
+// inside its segment's local bounds, w holds the segment's slot used to look
+// those bounds and its transform up. Normal is signed 2_10_10_10, local space.
+struct PackedTrackVertex {
+    uint16_t position[3];
+    uint16_t segment;
+    uint32_t normal;
+};
+
+// Where one segment lives inside the batched buffers
+struct SegmentDrawRange {
+    GLsizei indexCount = 0;
+    size_t firstIndex = 0;      // offset into the index buffer, in indices
+    GLint baseVertex = 0;       // added to every index of this segment
+};
+
+// Draw ranges for one LodChunk of a sweep segment
+struct ChunkDrawRanges {
+    Aabb localBounds;
+    Aabb bounds;                                            // world space
+    std::vector<float> error;                               // per level
+    std::vector<SegmentDrawRange> body;                     // [level]
+    std::vector<std::vector<SegmentDrawRange>> startEdge;   // [level][boundary level]
+    std::vector<std::vector<SegmentDrawRange>> endEdge;
+};
+
+// Camera data used to pick chunk LODs
+struct TrackLodView {
+    glm::vec3 cameraPos = glm::vec3(0.0f);
+    float pixelScale = 0.0f;        // viewport height / (2 tan(fovY / 2))
+    float maxPixelError = 1.0f;
+};
+
+// All static track geometry packed into one vertex/index buffer, so the
+// whole track goes out as a single multi-draw. Each segment is packed in its
+// own local space once and placed by a few texels holding its transform.
+//
+// Segments are told apart by TrackSegment::id. Rebuilding after an edit only
+// packs (and optimises, and builds LODs for) segments the batch hasn't seen;
+// segments that merely moved get new transform texels. Space left by removed
+// segments is reclaimed when the buffers next run out of room.
+class TrackBatch {
+public:
+    // Bring the buffers in line with the track. Needs a current GL context.
+    void build(const Track& track);
+
+    // A full build in two halves. prepare() does all the packing and
+    // optimising and touches no GL, so it can run on a worker while the
+    // track is not being modified; upload() then creates the buffers on the
+    // GL thread, replacing anything built before.
+    void prepare(const Track& track);
+    void upload();
+
+    // The shader's "segmentBounds" sampler must be set to TRACK_BOUNDS_TEXTURE_UNIT.
+    // The submitted multi-draw reads scratch arrays owned by the batch, so
+    // submit at most once per queue flush.
+
+    // Submit every segment
+    void submit(RenderQueue& queue, const ShaderProgram& shader) const;
+
+    // Submit only the listed segments (indices into Track::segments)
+    void submit(RenderQueue& queue, const ShaderProgram& shader, const std::vector<int>& segments) const;
+
+    // Same, with sweep segments drawn chunk by chunk at the coarsest level
+    // whose error stays under view.maxPixelError on screen
+    void submit(RenderQueue& queue, const ShaderProgram& shader, const std::vector<int>& segments,
+                const TrackLodView& view) const;
+
+    // Triangles in the last submit
+    size_t drawnTriangles() const { return triangleCount; }
+
+    // One entry per Track::segments, in the same order. For sweep segments
+    // this is the full-resolution mesh.
+    const std::vector<SegmentDrawRange>& ranges() const { return segmentRanges; }
+
+    // Allocated buffer sizes, including room to grow
+    size_t vertexBytes() const { return vertexCapacity * sizeof(PackedTrackVertex); }
+    size_t indexBytes() const { return indexCapacity * indexSize; }
+    size_t gpuBytes() const { return vertexBytes() + indexBytes() + slotCapacity * TRACK_TEXELS_PER_SLOT * sizeof(glm::vec4); }
+
+    // Per Track::segments entry: its vertices, its indices at every LOD level
+    // and its texels. Adds up to at most gpuBytes().
+    const std::vector<size_t>& segmentGpuBytes() const { return segmentBytes; }
+
+    // Segments packed by the last build() or prepare()
+    size_t packedSegments() const { return lastPacked; }
+
+private:
+    // One segment packed in local space, with ranges relative to its own
+    // vertices and indices, before it has a place in the buffers
+    struct PackedSegment {
+        uint64_t key = 0;
+        glm::mat4 transform = glm::mat4(1.0f);
+        Aabb localBounds;
+        std::vector<PackedTrackVertex> vertices;
+        std::vector<uint32_t> indices;
+        SegmentDrawRange full;
+        std::vector<ChunkDrawRanges> chunks;
+    };
+
+    // A segment in the buffers
+    struct Block {
+        uint16_t slot = 0;
+        size_t firstVertex = 0, vertexCount = 0;
+        size_t firstIndex = 0, indexCount = 0;
+        glm::mat4 transform = glm::mat4(0.0f);      // as last written to its texels
+        SegmentDrawRange full;
+        std::vector<ChunkDrawRanges> chunks;
+    };
+
+    GlVertexArray VAO;
+    GlBuffer VBO, EBO;
+    GlBuffer boundsBuffer;
+    GlTexture boundsTexture;
+    Material material;
+    GLenum indexType = GL_UNSIGNED_INT;
+    size_t indexSize = sizeof(uint32_t);
+
+    // Buffers fill from the front; the ends move back only when repacked
+    size_t vertexCapacity = 0, vertexEnd = 0, liveVertices = 0;    // in vertices
+    size_t indexCapacity = 0, indexEnd = 0, liveIndices = 0;       // in indices
+
+    // Slots index the texel buffer; freed ones are reused
+    size_t slotCapacity = 0;
+    uint16_t nextSlot = 0;
+    std::vector<uint16_t> freeSlots;
+    std::vector<glm::vec4> slotTexels;                  // copy of the texel buffer
+    size_t dirtyFirst = SIZE_MAX, dirtyEnd = 0;         // texels to upload, in slots
+
+    std::unordered_map<uint64_t, Block> blocks;         // by segment key
+    std::vector<const Block*> order;                    // per Track::segments
+    std::vector<SegmentDrawRange> segmentRanges;
+    std::vector<size_t> segmentBytes;
+    size_t lastPacked = 0;
+
+    // Between prepare() and upload()
+    std::vector<PackedSegment> pending;
+    bool pendingShortIndices = true;
+    bool hasPending = false;
+
+    // Scratch arrays for glMultiDrawElementsBaseVertex
+    mutable std::vector<GLsizei> counts;
+    mutable std::vector<const void*> offsets;
+    mutable std::vector<GLint> baseVertices;
+    mutable std::vector<int> chunkLevels;
+    mutable size_t triangleCount = 0;
+
+    static PackedSegment pack(const TrackSegment& seg, uint64_t key);
+    static bool hasUniqueIds(const Track& track);
+
+    void createBuffers(size_t vertices, size_t indices, size_t slots);
+    void setVertexLayout();
+    void reserve(size_t vertices, size_t indices, size_t slots);
+    void repack(size_t vertices, size_t indices);
+    void growSlots(size_t slots);
+    void place(PackedSegment&& packed);
+    void release(Block& block);
+    void arrange(const std::vector<uint64_t>& keys, const std::vector<glm::mat4>& transforms);
+    void flushTexels();
+
+    void clearRanges() const;
+    void addRange(const SegmentDrawRange& r) const;
+    void submitRanges(RenderQueue& queue, const ShaderProgram& shader) const;
+};
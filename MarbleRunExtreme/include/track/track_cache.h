@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "track_description.h"
+#include "physics.h"
+
+// A described track built once and then only read, by any number of races
+// on any threads: each piece's geometry in local space, and its collision
+// shape with the BVH. A race copies the geometry and puts its own bodies on
+// the shared shapes, so it skips sweeping meshes and building BVHs.
+struct BuiltTrack {
+    TrackDescription description;
+    std::string key;                        // formatTrackDescription()
+    std::vector<TrackSegment> segments;     // not placed, no bodies
+    std::vector<SharedShape> shapes;        // per segment, reading its arrays
+    double buildMs = 0.0;
+
+    // The shapes point into `segments`, so whoever holds a shape holds this too
+    static std::shared_ptr<const BuiltTrack> build(const TrackDescription& description);
+};
+
+struct TrackCacheStats {
+    long hits = 0;
+    long misses = 0;
+    long evictions = 0;
+};
+
+// Built tracks by description, the least recently used dropped past
+// `capacity`. Safe to share between threads; a track asked for while another
+// thread builds it is waited for rather than built twice. A dropped track is
+// freed once the last race on it is gone.
+class TrackCache {
+public:
+    explicit TrackCache(size_t capacity = 8);
+
+    // Builds on the calling thread on a miss
+    std::shared_ptr<const BuiltTrack> get(const TrackDescription& description, bool* hit = nullptr);
+
+    TrackCacheStats stats() const;
+
+private:
+    using Result = std::shared_future<std::shared_ptr<const BuiltTrack>>;
+
+    struct Entry {
+        Result track;
+        std::list<std::string>::iterator recent;
+        long build = 0;                     // tells a failed build from its replacement
+    };
+
+    size_t capacity;
+    mutable std::mutex mutex;
+    std::list<std::string> recent;          // keys, most recently used first
+    std::unordered_map<std::string, Entry> entries;
+    long builds = 0;
+    TrackCacheStats counters;
+};
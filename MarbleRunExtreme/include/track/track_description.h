@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "track_segment.h"
+#include "obstacle_utils.h"
+
+// One piece of a fixed track: a track_utils builder and its arguments, in
+// the builder's order. Arguments left off take the builder's defaults.
+struct TrackPiece {
+    enum class Kind { Funnel, Curve, Straight };
+    Kind kind = Kind::Straight;
+    std::vector<float> args;
+
+    // Slot machine obstacles scattered over a straight, up to `spread`
+    // either side of its middle (0 = half the straight's width)
+    int obstacles = 0;
+    float spread = 0.0f;
+};
+
+// A fixed track as text, one piece per line, '#' starts a comment:
+//
+//   funnel 180 10 30 20 3 5
+//   curve 360 15
+//   straight 60 -10 1 30 obstacles=15
+//
+// The first piece sits under the spawn point and the last is the finish.
+struct TrackDescription {
+    std::vector<TrackPiece> pieces;
+};
+
+// False, with a message naming the line, if the text isn't a track or
+// would build more geometry or obstacles than one track is allowed
+bool parseTrackDescription(const std::string& text, TrackDescription& out, std::string& error);
+
+// Canonical text: the same track always formats the same, so it can key a cache
+std::string formatTrackDescription(const TrackDescription& description);
+
+// The course Race builds when it isn't given one
+const TrackDescription& standardTrackDescription();
+
+// Geometry for one piece, in local space, without a body
+TrackSegment makeTrackPiece(const TrackPiece& piece);
+
+// The piece's obstacles on `segment`, already placed; bodies not yet in a world
+std::vector<Obstacle> makeTrackPieceObstacles(const TrackPiece& piece, const TrackSegment& segment, unsigned int seed);
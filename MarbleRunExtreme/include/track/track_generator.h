@@ -0,0 +1,138 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "track.h"
+#include "track_utils.h"
+#include "physics.h"
+#include "frustum.h"
+
+struct TrackGeneratorSettings {
+    unsigned int seed = 0;
+    float buildAhead = 400.0f;      // keep this much track past the leader
+    float retireBehind = 200.0f;    // drop segments this far behind the leader
+    int readyPieces = 3;            // finished pieces waiting to be attached, at most
+
+    // On average the track falls dropPerMetre per metre of arc length, give
+    // or take dropSlack metres
+    float dropPerMetre = 0.12f;
+    float dropSlack = 30.0f;
+
+    float clearance = 4.0f;         // free space kept around every part of the track
+    int attempts = 24;              // candidates tried before settling for less
+
+    // Main-thread time per attach() call. At least one piece is always attached.
+    float attachBudgetMs = 1.0f;
+
+    // Attach only when the track ends less than buildAhead past the leader,
+    // waiting for the worker if it has to, so which tick a piece lands on
+    // doesn't depend on thread timing
+    bool deterministic = false;
+};
+
+struct TrackGeneratorStats {
+    long piecesGenerated = 0;
+    long piecesAttached = 0;
+    long segmentsRetired = 0;
+    long rejectedIntersect = 0;     // candidates that came too close to the track
+    long rejectedDrop = 0;          // candidates that broke the drop budget
+    long forcedDrops = 0;           // no candidate cleared the track, so dropped straight down
+    long starvedUpdates = 0;        // the leader was near the end and nothing was ready
+    double maxGenerateMs = 0.0;     // worker, per piece, geometry and collision BVH
+    double maxAttachMs = 0.0;       // main thread, per attach() call
+};
+
+// Endless track. A worker thread keeps a few pieces (a curve, a funnel, a
+// ramp, a flight of stairs, a straight full of obstacles) built ahead of the
+// leading marble: geometry, collision mesh and BVH, all placed in world
+// space. The thread that steps physics only moves finished pieces onto the
+// track and into the world, within a time budget, and retires the track
+// behind the leader.
+//
+// Candidates are seeded, rejected if any part comes within `clearance` of
+// the live track (chunk bounds in a uniform grid) or breaks the drop budget.
+// If none fits, one that only broke the budget is used, and failing that a
+// straight drop. Every piece ends level, so any piece can follow any other
+// of a fitting width.
+class TrackGenerator {
+public:
+    // Picks up from the end of `track`, which must not be empty
+    TrackGenerator(const Track& track, const TrackGeneratorSettings& settings);
+    ~TrackGenerator();
+
+    TrackGenerator(const TrackGenerator&) = delete;
+    TrackGenerator& operator=(const TrackGenerator&) = delete;
+
+    // Tell the worker where the leader is and attach whatever is ready.
+    // Returns the number of segments added.
+    int attach(Track& track, PhysicsWorld& physics, std::vector<Obstacle>& obstacles,
+               float leaderDistance);
+
+    // Retire segments that end more than retireBehind behind the leader,
+    // with their obstacles. Returns the number of segments removed.
+    int retire(Track& track, std::vector<Obstacle>& obstacles, float leaderDistance);
+
+    // Arc length behind which retire() removes track
+    float retireLine(float leaderDistance) const { return leaderDistance - settings.retireBehind; }
+
+    // Snapshot; the worker updates its half under the lock
+    TrackGeneratorStats stats();
+
+private:
+    enum class Width { Narrow, Wide };
+
+    // A run of segments, placed and with detached bodies
+    struct Piece {
+        std::vector<TrackSegment> segments;
+        std::vector<Obstacle> obstacles;
+        int obstacleSegment = -1;           // index into segments the obstacles sit on
+        float length = 0.0f;
+    };
+
+    // Part of a segment's world bounds, grown by the clearance
+    struct Chunk {
+        Aabb bounds;
+        float from = 0.0f, to = 0.0f;       // arc length range along the run
+    };
+
+    TrackGeneratorSettings settings;
+
+    // Worker-only state: where the last generated piece ended
+    std::mt19937 rng;
+    glm::mat4 cursor = glm::mat4(1.0f);
+    Width tailWidth = Width::Narrow;
+    float endDistance = 0.0f;
+    float totalDrop = 0.0f, dropDistance = 0.0f;
+
+    // Live chunks, oldest first, and the grid cells that list them by id
+    std::deque<Chunk> chunks;
+    uint64_t firstChunk = 0;
+    std::unordered_map<uint64_t, std::vector<uint64_t>> grid;
+
+    // Shared with the worker
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Piece> ready;
+    float wantedDistance = 0.0f;
+    bool stopping = false;
+    TrackGeneratorStats counters;
+    std::thread worker;
+
+    void workerLoop();
+    Piece generatePiece(TrackGeneratorStats& delta);
+    void candidate(Piece& piece, Width& width);
+    void place(Piece& piece, glm::mat4& frame, float startDistance,
+               std::vector<Chunk>& pieceChunks) const;
+    void chunkSegment(const TrackSegment& seg, float from, std::vector<Chunk>& out) const;
+    bool clear(const std::vector<Chunk>& pieceChunks) const;
+    void addChunks(const std::vector<Chunk>& pieceChunks);
+    void pruneChunks(float before);
+
+    template <class F> void forEachCell(const Aabb& bounds, F&& f) const;
+};
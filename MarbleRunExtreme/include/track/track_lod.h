@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "track_segment.h"
+#include "frustum.h"
+
+// Quads along the sweep per LOD chunk
+const int LOD_CHUNK_QUADS = 16;
+
+// Coarsest level is grid stride 2^(LOD_MAX_LEVELS - 1)
+const int LOD_MAX_LEVELS = 4;
+
+// Segment-local triangle lists for one chunk of a sweep grid, one slice of
+// rows along u. Level L samples every 2^L-th grid line. The first and last
+// row of quads are kept apart from the body, with one variant per boundary
+// level, so neighbours at different levels share the same boundary vertices.
+struct LodChunk {
+    int firstRow = 0, lastRow = 0;      // grid rows u covered, inclusive
+    Aabb localBounds;
+
+    std::vector<float> error;           // max deviation from the full mesh per level, in metres
+    std::vector<std::vector<unsigned int>> body;                       // [level]
+    std::vector<std::vector<std::vector<unsigned int>>> startEdge;     // [level][boundary level]
+    std::vector<std::vector<std::vector<unsigned int>>> endEdge;
+};
+
+struct GridLod {
+    int levels = 0;
+    std::vector<LodChunk> chunks;
+};
+
+// Split a sweep segment (TrackSegment::gridU > 0) into chunks with every LOD
+// level and edge variant precomputed. Empty for other segments.
+GridLod buildGridLod(const TrackSegment& seg);
+
+// Coarsest level whose error projects to at most maxPixelError on screen.
+// pixelScale is viewport height / (2 tan(fovY / 2)).
+int selectLodLevel(const std::vector<float>& error, float distance, float pixelScale, float maxPixelError);
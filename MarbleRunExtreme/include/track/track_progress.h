@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "track.h"
+#include "frustum.h"
+
+// Where a position is along the track
+struct TrackPosition {
+    int segment = -1;           // -1 = not on or near the track
+    float t = 0.0f;             // along the segment, 0..1
+    float distance = 0.0f;      // arc length from the start of the track, retired segments included
+    float offset = 0.0f;        // from the segment's centreline
+};
+
+// Maps positions to track progress. Segments sit in a bounding volume
+// hierarchy over their world bounds, so a lookup descends O(log S) nodes;
+// among the segments whose bounds hold the point, the one with the nearest
+// centreline wins. Stacked spirals overlap a lot, hence the centreline test.
+class TrackProgressIndex {
+public:
+    // Call again whenever the track changes; keeps a pointer to it
+    void build(const Track& track);
+
+    // `hint` is the segment this marble was on last time. It and the next
+    // segment are tried before the tree, which is where a rolling marble
+    // nearly always still is.
+    TrackPosition locate(const glm::vec3& pos, int hint = -1) const;
+
+    float totalLength() const { return starts.empty() ? 0.0f : starts.back(); }
+    // Arc length from the start of the track to the start of segment i,
+    // counting from Track::startDistance
+    float segmentStart(int i) const { return starts[i]; }
+    size_t segmentCount() const { return bounds.size(); }
+
+private:
+    struct Node {
+        Aabb bounds;
+        int left = -1, right = -1;      // children, or -1 for a leaf
+        int first = 0, count = 0;       // leaf range in `leaves`
+    };
+
+    const Track* track = nullptr;
+    std::vector<Aabb> bounds;           // per segment, grown by its reach
+    std::vector<float> starts;          // segment count + 1 entries
+    std::vector<Node> nodes;
+    std::vector<int> leaves;
+
+    int buildNode(int first, int count);
+    bool test(int segment, const glm::vec3& pos, TrackPosition& best) const;
+};
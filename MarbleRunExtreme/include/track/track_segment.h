@@ -1,12 +1,127 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include "mesh_entity.h"
 #include "physics.h"
+#include "frustum.h"
 
+// atan2 to within 2e-4 rad (millimetres on a track curve), at a fraction
+// of the cost; track lookups run it for every marble every tick
+inline float approxAtan2(float y, float x) {
+    float ax = std::abs(x), ay = std::abs(y);
+    float hi = std::max(ax, ay);
+    if (hi == 0.0f) return 0.0f;
+    float a = std::min(ax, ay) / hi, s = a * a;
+    float r = ((-0.0464964749f * s + 0.15931422f) * s - 0.327622764f) * s * a + a;
+    r = ay > ax ? glm::half_pi<float>() - r : r;
+    r = x < 0.0f ? glm::pi<float>() - r : r;
+    return std::copysign(r, y);
+}
+
+// The line a marble rolls along through a segment, in the segment's local
+// space. Sweeps (curves and funnels) are a helix of `arc` radians around the
+// vertical axis at (-radius, 0, 0), dropping `drop` over the segment;
+// straights run along `forward`. Both have constant speed in t, so
+// arc length is just t * length.
+struct TrackCenterline {
+    enum class Kind { Straight, Sweep };
+    Kind kind = Kind::Straight;
+
+    glm::vec3 start = glm::vec3(0.0f);          // at t = 0
+    glm::vec3 forward = glm::vec3(0.0f, 0.0f, 1.0f);
+    float length = 0.0f;
+    float arc = 0.0f, drop = 0.0f, radius = 0.0f;
+
+    // How far from the line a marble can be and still be on this segment
+    float reach = 0.0f;
+
+    glm::vec3 pointAt(float t) const {
+        if (kind == Kind::Straight)
+            return start + forward * (length * t);
+        float angle = arc * t;
+        return start + glm::vec3(radius * std::cos(angle) - radius, -drop * t, radius * std::sin(angle));
+    }
+
+    // Parameter of the point on the line nearest to p, in [0, 1]
+    float closestT(const glm::vec3& p) const {
+        if (length <= 0.0f) return 0.0f;
+        glm::vec3 d = p - start;
+        if (kind == Kind::Straight)
+            return glm::clamp(glm::dot(d, forward) / length, 0.0f, 1.0f);
+
+        // Angle around the axis gives t up to whole turns; height picks the turn
+        float angle = approxAtan2(d.z / radius, (d.x + radius) / radius);
+        float tHeight = drop != 0.0f ? -d.y / drop : 0.5f;
+        float turn = glm::two_pi<float>();
+        float k = std::round((tHeight * arc - angle) / turn);
+        return glm::clamp((angle + k * turn) / arc, 0.0f, 1.0f);
+    }
+
+    // closestT, plus how far p is from the line there
+    float closestT(const glm::vec3& p, float& offset) const {
+        float t = closestT(p);
+        if (kind == Kind::Sweep && t > 0.0f && t < 1.0f) {
+            // Nearest point is at p's own angle around the axis, leaving
+            // only the radial and vertical gaps; no need for pointAt
+            glm::vec3 d = p - start;
+            float radial = std::sqrt((d.x + radius) * (d.x + radius) + d.z * d.z) - std::abs(radius);
+            float vertical = d.y + drop * t;
+            offset = std::sqrt(radial * radial + vertical * vertical);
+        } else {
+            offset = glm::length(p - pointAt(t));
+        }
+        return t;
+    }
+
+    static TrackCenterline straight(const glm::vec3& start, const glm::vec3& forward, float length, float reach) {
+        TrackCenterline c;
+        c.kind = Kind::Straight;
+        c.start = start;
+        c.forward = forward;
+        c.length = length;
+        c.reach = reach;
+        return c;
+    }
+
+    static TrackCenterline sweep(const glm::vec3& start, float arc, float drop, float radius, float reach) {
+        TrackCenterline c;
+        c.kind = Kind::Sweep;
+        c.start = start;
+        c.arc = arc;
+        c.drop = drop;
+        c.radius = radius;
+        c.length = std::sqrt(radius * arc * radius * arc + drop * drop);
+        c.reach = reach;
+        return c;
+    }
+};
+
+// Owns its collision body and holds a few hundred KB of geometry, so it
+// moves but never copies
 class TrackSegment {
 public:
-    RenderableMesh mesh;
-    btRigidBody* body = nullptr;
+    // Given by the Track it joins, unique within that track, so whatever
+    // caches per-segment data can tell a moved segment from a new one
+    uint64_t id = 0;
+
+    RigidBody body;
+
+    // Segment geometry in local space. Rendering goes through TrackBatch,
+    // which bakes worldTransform into one shared buffer for the whole track.
+    // The collision mesh reads vertices and indices in place, so they don't
+    // change once the body is built.
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<unsigned int> indices;
+
+    // Sweep segments are a (gridU + 1) x (gridV + 1) vertex grid, row u at
+    // vertices[u * (gridV + 1)]. Zero for anything else.
+    int gridU = 0, gridV = 0;
 
     glm::vec3 entryPos = glm::vec3(0.0f);
     glm::vec3 entryForward = glm::vec3(0.0f,0.0f,1.0f);
@@ -15,11 +130,22 @@ public:
     glm::vec3 exitForward = glm::vec3(0.0f,0.0f,1.0f);
 
     glm::mat4 worldTransform = glm::mat4(1.0f);
+    glm::mat4 inverseWorldTransform = glm::mat4(1.0f);
+
+    TrackCenterline centerline;
+
+    // World-space bounds of the geometry, refreshed whenever the transform changes
+    Aabb worldBounds;
+
+    // Bounds of `vertices`, taken the first time the segment is placed
+    Aabb localBounds;
     
     glm::vec3 exitUp = glm::vec3(0,1,0);
 
     void setWorldTransform(const glm::mat4& t) {
         worldTransform = t;
+        inverseWorldTransform = glm::inverse(t);
+        worldBounds = boundsUnder(t);
 
         if(body) {
             btTransform bt;
@@ -27,4 +153,68 @@ public:
             body->setWorldTransform(bt);
         }
     }
+
+    // A handful of vertices are transformed as they are, for a tight box.
+    // Anything bigger transforms its local box instead, so placing a segment
+    // costs the same whatever its resolution.
+    Aabb boundsUnder(const glm::mat4& t) {
+        Aabb b;
+        if (vertices.size() <= 8) {
+            for (const auto& v : vertices)
+                b.expand(glm::vec3(t * glm::vec4(v, 1.0f)));
+            return b;
+        }
+
+        if (localBounds.empty())
+            for (const auto& v : vertices)
+                localBounds.expand(v);
+        glm::vec3 centre = glm::vec3(t * glm::vec4(0.5f * (localBounds.min + localBounds.max), 1.0f));
+        glm::vec3 half = 0.5f * (localBounds.max - localBounds.min);
+        glm::vec3 extent(0.0f);
+        for (int col = 0; col < 3; ++col)
+            for (int row = 0; row < 3; ++row)
+                extent[row] += std::abs(t[col][row]) * half[col];
+        b.min = centre - extent;
+        b.max = centre + extent;
+        return b;
+    }
+
+    TrackSegment() = default;
+    TrackSegment(TrackSegment&&) = default;
+    TrackSegment& operator=(TrackSegment&&) = default;
+    TrackSegment(const TrackSegment&) = delete;
+    TrackSegment& operator=(const TrackSegment&) = delete;
+
+    // Everything but the body and id, for another race on the same track
+    TrackSegment copyGeometry() const {
+        TrackSegment c;
+        c.vertices = vertices;
+        c.normals = normals;
+        c.indices = indices;
+        c.gridU = gridU;
+        c.gridV = gridV;
+        c.entryPos = entryPos;
+        c.entryForward = entryForward;
+        c.exitPos = exitPos;
+        c.exitForward = exitForward;
+        c.exitUp = exitUp;
+        c.worldTransform = worldTransform;
+        c.inverseWorldTransform = inverseWorldTransform;
+        c.centerline = centerline;
+        c.worldBounds = worldBounds;
+        c.localBounds = localBounds;
+        return c;
+    }
+
+    float length() const { return centerline.length; }
+
+    // World-space point on the centreline
+    glm::vec3 pointAt(float t) const {
+        return glm::vec3(worldTransform * glm::vec4(centerline.pointAt(t), 1.0f));
+    }
+
+    // Centreline parameter nearest to a world-space position
+    float closestT(const glm::vec3& worldPos) const {
+        return centerline.closestT(glm::vec3(inverseWorldTransform * glm::vec4(worldPos, 1.0f)));
+    }
 };
@@ -1,13 +1,19 @@
 #pragma once
+#include <algorithm>
 #include <vector>
+#include <random>
+#include <utility>
 #include <glm/glm.hpp>
 #include "mesh_entity.h"
 #include "physics.h"
 #include "track_segment.h"
 #include "obstacle_utils.h"
 
-inline TrackSegment buildCurvedSegment(
-    PhysicsWorld& physics,
+// The make*Segment builders produce geometry, connection points and
+// centreline only, with no collision body, so they are safe on any thread.
+// The build*Segment versions also add the collision mesh to `physics`.
+
+inline TrackSegment makeCurvedSegment(
     float arcDeg,
     float drop   = 10.0f,
     float radius = 30.0f,
@@ -79,11 +85,11 @@ inline TrackSegment buildCurvedSegment(
         }
     }
     
-    RenderableMesh mesh;
-    mesh.load(verts, norms, idx);
-    seg.mesh = mesh;
-    
-    seg.body = physics.addTriangleMesh(verts, idx, glm::vec3(0), glm::vec3(0));
+    seg.vertices = std::move(verts);
+    seg.normals = std::move(norms);
+    seg.indices = std::move(idx);
+    seg.gridU = segU;
+    seg.gridV = segV;
     
     // Connection
     seg.entryPos = glm::vec3(0, 0, 0);
@@ -100,12 +106,15 @@ inline TrackSegment buildCurvedSegment(
     
     seg.exitUp = glm::normalize(lastBasis * glm::vec3(0,1,0));
     
+    // Along the bottom of the trough
+    seg.centerline = TrackCenterline::sweep(glm::vec3(0, -depth, 0), arc, drop, radius,
+                                            std::sqrt(width * width + depth * depth) + 1.0f);
+    
     return seg;
 }
 
 
-inline TrackSegment buildStraightSegment(
-    PhysicsWorld& physics,
+inline TrackSegment makeStraightSegment(
     float length,
     float pitchDeg,
     float heightOffset = 0.0f,
@@ -134,32 +143,37 @@ inline TrackSegment buildStraightSegment(
     std::vector<glm::vec3> norms = { up, up, up, up };
     std::vector<unsigned int> idx = { 0,2,1, 1,2,3 };
 
-    RenderableMesh m;
-    m.load(verts, norms, idx);
-    seg.mesh = m;
+    seg.vertices = std::move(verts);
+    seg.normals = std::move(norms);
+    seg.indices = std::move(idx);
 
-    seg.body = physics.addTriangleMesh(verts, idx, glm::vec3(0), glm::vec3(0));
     seg.entryPos = glm::vec3(0);
     seg.entryForward = forward;
     seg.exitPos = forward * length;
     seg.exitForward = forward;
     seg.exitUp = up;
 
+    // Down the middle of the surface
+    seg.centerline = TrackCenterline::straight(downShift - up * depth, forward, length,
+                                               width + 1.0f);
+
     return seg;
 }
 
 
-inline std::vector<Obstacle> generateSlotMachineObstacles(
-    PhysicsWorld& physics,
+// Obstacles scattered over a straight segment in its current world
+// placement, with bodies not yet added to any world
+inline std::vector<Obstacle> makeSlotMachineObstacles(
     const TrackSegment& segment,
     float segmentLength,
     float segmentWidth,
-    int count
+    int count,
+    unsigned int seed
 ) {
     std::vector<Obstacle> obstacles;
+    obstacles.reserve(count);
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen(seed);
 
     std::uniform_real_distribution<float> distX(-segmentWidth + 2.0f, segmentWidth - 2.0f);
     std::uniform_real_distribution<float> distZ(2.0f, segmentLength - 2.0f);
@@ -183,14 +197,13 @@ inline std::vector<Obstacle> generateSlotMachineObstacles(
         // Compute obstacle center so its base sits on the track surface
         glm::vec3 worldPos = segOrigin + segRight * xLocal + segForward * zLocal + segUp * (h * 0.5f - 3.0f);
 
-        obstacles.push_back(buildObstacle(physics, worldPos, glm::vec3(w, h, d)));
+        obstacles.push_back(makeObstacle(worldPos, glm::vec3(w, h, d)));
     }
 
     return obstacles;
 }
 
-inline TrackSegment buildFunnelSegment(
-    PhysicsWorld& physics,
+inline TrackSegment makeFunnelSegment(
     float arcDeg,
     float drop = 10.0f,
     float radius = 30.0f,
@@ -251,12 +264,12 @@ inline TrackSegment buildFunnelSegment(
         }
     }
 
-    // --- Load mesh ---
-    RenderableMesh mesh;
-    mesh.load(verts, norms, idx);
-    seg.mesh = mesh;
-
-    seg.body = physics.addTriangleMesh(verts, idx, glm::vec3(0), glm::vec3(0));
+    // --- Keep geometry for the render upload ---
+    seg.vertices = std::move(verts);
+    seg.normals = std::move(norms);
+    seg.indices = std::move(idx);
+    seg.gridU = segU;
+    seg.gridV = segV;
 
     // --- Connection points ---
     seg.entryPos = glm::vec3(0, 0, 0);
@@ -271,6 +284,73 @@ inline TrackSegment buildFunnelSegment(
     seg.exitForward = glm::normalize(exitForward);
     seg.exitUp = glm::normalize(lastBasis * glm::vec3(0, 1, 0));
 
+    // Along the bottom of the trough; reach covers the wide end
+    float maxWidth = std::max(startWidth, exitWidth);
+    seg.centerline = TrackCenterline::sweep(glm::vec3(0, -depth, 0), arc, drop, radius,
+                                            std::sqrt(maxWidth * maxWidth + depth * depth) + 1.0f);
+
+    return seg;
+}
+
+// Collision mesh in local space; setWorldTransform places it
+inline void addSegmentBody(PhysicsWorld& physics, TrackSegment& seg) {
+    seg.body = physics.addTriangleMesh(seg.vertices, seg.indices, glm::vec3(0), glm::vec3(0));
+}
+
+inline TrackSegment buildCurvedSegment(
+    PhysicsWorld& physics,
+    float arcDeg,
+    float drop   = 10.0f,
+    float radius = 30.0f,
+    float width  = 5.0f,
+    float depth  = 3.0f,
+    int segU = 240,
+    int segV = 60
+) {
+    TrackSegment seg = makeCurvedSegment(arcDeg, drop, radius, width, depth, segU, segV);
+    addSegmentBody(physics, seg);
+    return seg;
+}
+
+inline TrackSegment buildStraightSegment(
+    PhysicsWorld& physics,
+    float length,
+    float pitchDeg,
+    float heightOffset = 0.0f,
+    float width = 5.0f,
+    float depth = 2.0f
+) {
+    TrackSegment seg = makeStraightSegment(length, pitchDeg, heightOffset, width, depth);
+    addSegmentBody(physics, seg);
     return seg;
 }
 
+inline TrackSegment buildFunnelSegment(
+    PhysicsWorld& physics,
+    float arcDeg,
+    float drop = 10.0f,
+    float radius = 30.0f,
+    float startWidth = 5.0f,
+    float depth = 3.0f,
+    float exitWidth = 2.5f,
+    int segU = 240,
+    int segV = 60
+) {
+    TrackSegment seg = makeFunnelSegment(arcDeg, drop, radius, startWidth, depth, exitWidth, segU, segV);
+    addSegmentBody(physics, seg);
+    return seg;
+}
+
+inline std::vector<Obstacle> generateSlotMachineObstacles(
+    PhysicsWorld& physics,
+    const TrackSegment& segment,
+    float segmentLength,
+    float segmentWidth,
+    int count,
+    unsigned int seed
+) {
+    std::vector<Obstacle> obstacles = makeSlotMachineObstacles(segment, segmentLength, segmentWidth, count, seed);
+    for (Obstacle& o : obstacles)
+        physics.add(o.box.body);
+    return obstacles;
+}
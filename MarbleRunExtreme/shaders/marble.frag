@@ -3,36 +3,12 @@ out vec4 FragColor;
 
 in vec3 FragPos;
 in vec3 Normal;
+in vec3 Color;
+flat in int Highlight;
 
-uniform vec3 lightPos;
-uniform vec3 viewPos;
-uniform vec3 objectColor;
-uniform bool highlight;
+// Defined in marble_shading.frag
+vec3 shadeMarble(vec3 fragPos, vec3 normal, vec3 color, int highlight);
 
 void main() {
-    // Glow
-    vec3 baseColor = objectColor;
-    if (highlight) {
-        baseColor += vec3(0.6, 0.4, 0.1);
-    }
-
-    // Ambient
-    float ambientStrength = 0.2;
-    vec3 ambient = ambientStrength * vec3(1.0);
-
-    // Diffuse
-    vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - FragPos);
-    float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * vec3(1.0);
-
-    // Specular
-    float specularStrength = 0.5;
-    vec3 viewDir = normalize(viewPos - FragPos);
-    vec3 reflectDir = reflect(-lightDir, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-    vec3 specular = specularStrength * spec * vec3(1.0);
-
-    vec3 result = (ambient + diffuse + specular) * baseColor;
-    FragColor = vec4(result, 1.0);
+    FragColor = vec4(shadeMarble(FragPos, Normal, Color, Highlight), 1.0);
 }
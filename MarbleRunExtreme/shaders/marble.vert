@@ -2,16 +2,35 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 
+// Per instance
+layout (location = 2) in vec4 aPositionRadius;
+layout (location = 3) in vec4 aRotation;
+layout (location = 4) in vec4 aColorHighlight;
+
 out vec3 FragPos;
 out vec3 Normal;
+out vec3 Color;
+flat out int Highlight;
+
+// Shared per-frame data, filled once per frame by FrameUniformBuffer
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 lightPos;
+    vec4 viewPos;
+};
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Rotate v by the unit quaternion q (xyz = vector part, w = scalar)
+vec3 rotate(vec4 q, vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
 
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal; // Correct normal transformation
+    FragPos = aPositionRadius.xyz + rotate(aRotation, aPos * aPositionRadius.w);
+    Normal = rotate(aRotation, aNormal); // Uniform scale, so rotating is enough
+
+    Color = aColorHighlight.rgb;
+    Highlight = aColorHighlight.a > 0.5 ? 1 : 0;
 
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
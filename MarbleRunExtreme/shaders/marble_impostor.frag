@@ -0,0 +1,40 @@
+#version 410 core
+out vec4 FragColor;
+
+in vec3 RayTarget;
+flat in vec4 Sphere;
+in vec3 Color;
+flat in int Highlight;
+
+// Shared per-frame data, filled once per frame by FrameUniformBuffer
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 lightPos;
+    vec4 viewPos;
+};
+
+// Defined in marble_shading.frag
+vec3 shadeMarble(vec3 fragPos, vec3 normal, vec3 color, int highlight);
+
+void main() {
+    // Ray from the eye through this fragment against the exact sphere
+    vec3 origin = viewPos.xyz;
+    vec3 dir = normalize(RayTarget - origin);
+    vec3 oc = origin - Sphere.xyz;
+
+    float b = dot(oc, dir);
+    float c = dot(oc, oc) - Sphere.w * Sphere.w;
+    float h = b * b - c;
+    if (h < 0.0)
+        discard;
+
+    vec3 hit = origin + dir * (-b - sqrt(h));
+    vec3 normal = (hit - Sphere.xyz) / Sphere.w;
+
+    // Depth of the surface point rather than the quad
+    vec4 clip = projection * view * vec4(hit, 1.0);
+    gl_FragDepth = (clip.z / clip.w) * 0.5 + 0.5;
+
+    FragColor = vec4(shadeMarble(hit, normal, Color, Highlight), 1.0);
+}
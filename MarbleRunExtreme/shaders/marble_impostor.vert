@@ -0,0 +1,44 @@
+#version 410 core
+// Quad corner in [-1, 1]
+layout (location = 0) in vec2 aCorner;
+
+// Per instance, same layout as marble.vert
+layout (location = 2) in vec4 aPositionRadius;
+layout (location = 3) in vec4 aRotation;
+layout (location = 4) in vec4 aColorHighlight;
+
+out vec3 RayTarget;
+flat out vec4 Sphere;
+out vec3 Color;
+flat out int Highlight;
+
+// Shared per-frame data, filled once per frame by FrameUniformBuffer
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 lightPos;
+    vec4 viewPos;
+};
+
+void main() {
+    vec3 center = aPositionRadius.xyz;
+    float radius = aPositionRadius.w;
+
+    // Quad through the centre, facing the camera along the ray to the centre
+    vec3 toCenter = center - viewPos.xyz;
+    float dist = max(length(toCenter), radius * 1.01);
+    vec3 forward = toCenter / dist;
+    vec3 up = abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 right = normalize(cross(forward, up));
+    up = cross(right, forward);
+
+    // Half-size of the silhouette cone where it crosses the quad's plane
+    float halfSize = radius * dist / sqrt(dist * dist - radius * radius);
+
+    RayTarget = center + (right * aCorner.x + up * aCorner.y) * halfSize;
+    Sphere = aPositionRadius;
+    Color = aColorHighlight.rgb;
+    Highlight = aColorHighlight.a > 0.5 ? 1 : 0;
+
+    gl_Position = projection * view * vec4(RayTarget, 1.0);
+}
@@ -0,0 +1,38 @@
+#version 410 core
+
+// Marble lighting, linked into both marble.frag and marble_impostor.frag
+
+// Shared per-frame data, filled once per frame by FrameUniformBuffer
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 lightPos;
+    vec4 viewPos;
+};
+
+vec3 shadeMarble(vec3 fragPos, vec3 normal, vec3 color, int highlight) {
+    // Glow
+    vec3 baseColor = color;
+    if (highlight != 0) {
+        baseColor += vec3(0.6, 0.4, 0.1);
+    }
+
+    // Ambient
+    float ambientStrength = 0.2;
+    vec3 ambient = ambientStrength * vec3(1.0);
+
+    // Diffuse
+    vec3 norm = normalize(normal);
+    vec3 lightDir = normalize(lightPos.xyz - fragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * vec3(1.0);
+
+    // Specular
+    float specularStrength = 0.5;
+    vec3 viewDir = normalize(viewPos.xyz - fragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    vec3 specular = specularStrength * spec * vec3(1.0);
+
+    return (ambient + diffuse + specular) * baseColor;
+}
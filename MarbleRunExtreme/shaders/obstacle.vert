@@ -0,0 +1,32 @@
+#version 410 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+
+// Per instance
+layout (location = 2) in vec4 aPosition;
+layout (location = 3) in vec4 aRotation;
+layout (location = 4) in vec4 aHalfExtents;
+
+out vec3 FragPos;
+out vec3 Normal;
+
+// Shared per-frame data, filled once per frame by FrameUniformBuffer
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 lightPos;
+    vec4 viewPos;
+};
+
+// Rotate v by the unit quaternion q (xyz = vector part, w = scalar)
+vec3 rotate(vec4 q, vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+    FragPos = aPosition.xyz + rotate(aRotation, aPos * aHalfExtents.xyz);
+    // Inverse scale keeps normals perpendicular under non-uniform scaling
+    Normal = rotate(aRotation, aNormal / aHalfExtents.xyz);
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,14 @@
+#version 410 core
+out vec4 FragColor;
+
+in vec2 CellPos;
+flat in int Glyph;
+
+uniform sampler2D font;
+
+void main() {
+    ivec2 texel = ivec2(CellPos);
+    if (texelFetch(font, ivec2(Glyph * 6 + texel.x, texel.y), 0).r < 0.5)
+        discard;
+    FragColor = vec4(1.0, 1.0, 1.0, 1.0);
+}
@@ -0,0 +1,22 @@
+#version 410 core
+layout (location = 0) in vec2 aCorner;     // 0..1, y down
+
+// Per instance
+layout (location = 1) in vec3 aGlyph;      // column, row, glyph index
+
+uniform vec3 screenSize;                    // width, height, pixels per font pixel
+
+out vec2 CellPos;
+flat out int Glyph;
+
+const vec2 CELL = vec2(6.0, 8.0);
+
+void main() {
+    CellPos = aCorner * CELL;
+    Glyph = int(aGlyph.z);
+
+    // One cell of margin, origin at the top left of the screen
+    vec2 pixel = ((aGlyph.xy + 1.0) * CELL + CellPos) * screenSize.z;
+    vec2 ndc = pixel / screenSize.xy * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+}
@@ -0,0 +1,35 @@
+#version 410 core
+// Packed track vertex (see PackedTrackVertex): xyz = 16-bit position inside
+// the segment's local bounds, w = segment slot
+layout(location = 0) in uvec4 aPacked;
+layout(location = 1) in vec4 aNormal;
+
+// Five texels per slot: local bounds min, bounds extent, then the rows of
+// the segment's rigid local-to-world transform
+uniform samplerBuffer segmentBounds;
+
+// Shared per-frame data, filled once per frame by FrameUniformBuffer
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 lightPos;
+    vec4 viewPos;
+};
+
+out vec3 FragPos;
+out vec3 Normal;
+
+void main()
+{
+    int slot = int(aPacked.w) * 5;
+    vec3 boundsMin = texelFetch(segmentBounds, slot).xyz;
+    vec3 boundsExtent = texelFetch(segmentBounds, slot + 1).xyz;
+    vec4 row0 = texelFetch(segmentBounds, slot + 2);
+    vec4 row1 = texelFetch(segmentBounds, slot + 3);
+    vec4 row2 = texelFetch(segmentBounds, slot + 4);
+
+    vec4 local = vec4(boundsMin + vec3(aPacked.xyz) * (1.0 / 65535.0) * boundsExtent, 1.0);
+    FragPos = vec3(dot(row0, local), dot(row1, local), dot(row2, local));
+    Normal = vec3(dot(row0.xyz, aNormal.xyz), dot(row1.xyz, aNormal.xyz), dot(row2.xyz, aNormal.xyz));
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,47 @@
+#include "cube_mesh.h"
+
+// Two triangles per face, counter-clockwise seen from outside
+static const float CUBE_VERTICES[] = {
+    // position          // normal
+    -1,-1,-1,   0, 0,-1,   -1, 1,-1,   0, 0,-1,    1, 1,-1,   0, 0,-1,     // back
+     1, 1,-1,   0, 0,-1,    1,-1,-1,   0, 0,-1,   -1,-1,-1,   0, 0,-1,
+    -1,-1, 1,   0, 0, 1,    1,-1, 1,   0, 0, 1,    1, 1, 1,   0, 0, 1,     // front
+     1, 1, 1,   0, 0, 1,   -1, 1, 1,   0, 0, 1,   -1,-1, 1,   0, 0, 1,
+    -1, 1, 1,  -1, 0, 0,   -1, 1,-1,  -1, 0, 0,   -1,-1,-1,  -1, 0, 0,     // left
+    -1,-1,-1,  -1, 0, 0,   -1,-1, 1,  -1, 0, 0,   -1, 1, 1,  -1, 0, 0,
+     1, 1, 1,   1, 0, 0,    1,-1, 1,   1, 0, 0,    1,-1,-1,   1, 0, 0,     // right
+     1,-1,-1,   1, 0, 0,    1, 1,-1,   1, 0, 0,    1, 1, 1,   1, 0, 0,
+    -1, 1,-1,   0, 1, 0,   -1, 1, 1,   0, 1, 0,    1, 1, 1,   0, 1, 0,     // top
+     1, 1, 1,   0, 1, 0,    1, 1,-1,   0, 1, 0,   -1, 1,-1,   0, 1, 0,
+    -1,-1,-1,   0,-1, 0,    1,-1,-1,   0,-1, 0,    1,-1, 1,   0,-1, 0,     // bottom
+     1,-1, 1,   0,-1, 0,   -1,-1, 1,   0,-1, 0,   -1,-1,-1,   0,-1, 0,
+};
+
+CubeMesh::CubeMesh()
+    : VAO(GlVertexArray::create()), VBO(GlBuffer::create())
+{
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(CUBE_VERTICES), CUBE_VERTICES, GL_STATIC_DRAW);
+
+    glBindVertexArray(VAO);
+    bindVertexAttributes();
+    glBindVertexArray(0);
+}
+
+size_t CubeMesh::gpuBytes() {
+    return sizeof(CUBE_VERTICES);
+}
+
+void CubeMesh::bindVertexAttributes() const {
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+    // Position attribute (location = 0)
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Normal attribute (location = 1)
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
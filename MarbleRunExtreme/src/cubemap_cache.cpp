@@ -0,0 +1,220 @@
+#include "cubemap_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+static const int CHANNELS = 3;
+
+static size_t faceBytes(int size) {
+    return (size_t)size * size * CHANNELS;
+}
+
+static size_t payloadBytes(int faceSize, int mipCount) {
+    size_t total = 0;
+    for (int level = 0; level < mipCount; ++level)
+        total += 6 * faceBytes(std::max(1, faceSize >> level));
+    return total;
+}
+
+int CubemapView::levelSize(int level) const {
+    return std::max(1, faceSize >> level);
+}
+
+const unsigned char* CubemapView::face(int level, int face) const {
+    size_t offset = 0;
+    for (int l = 0; l < level; ++l)
+        offset += 6 * faceBytes(levelSize(l));
+    return payload + offset + face * faceBytes(levelSize(level));
+}
+
+// Check the header and that the payload it describes fits in `size` bytes
+static bool parseCubemap(const unsigned char* data, size_t size, CubemapView& view) {
+    if (size < sizeof(CubemapHeader)) return false;
+
+    CubemapHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, CUBEMAP_CACHE_MAGIC, 4) != 0) return false;
+    if (header.version != CUBEMAP_CACHE_VERSION) return false;
+    if (header.faceSize == 0 || header.mipCount == 0 || header.mipCount > 32) return false;
+    if (size - sizeof(CubemapHeader) < payloadBytes(header.faceSize, header.mipCount)) return false;
+
+    view.payload = data + sizeof(CubemapHeader);
+    view.faceSize = (int)header.faceSize;
+    view.mipCount = (int)header.mipCount;
+    return true;
+}
+
+CubemapView CubemapImage::view() const {
+    CubemapView v;
+    parseCubemap(bytes.data(), bytes.size(), v);
+    return v;
+}
+
+MappedCubemap::~MappedCubemap() {
+    close();
+}
+
+bool MappedCubemap::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    size = (size_t)st.st_size;
+    base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);    // the mapping keeps the file alive
+    if (base == MAP_FAILED) {
+        base = nullptr;
+        size = 0;
+        return false;
+    }
+
+    // The whole file is about to be uploaded front to back; start reading it now
+    madvise(base, size, MADV_SEQUENTIAL);
+    madvise(base, size, MADV_WILLNEED);
+
+    if (!parseCubemap((const unsigned char*)base, size, cubemap)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedCubemap::close() {
+    if (base)
+        munmap(base, size);
+    base = nullptr;
+    size = 0;
+    cubemap = CubemapView();
+}
+
+// 2x2 box filter; odd sizes clamp the second sample to the edge
+static void downsample(const unsigned char* src, int srcSize, unsigned char* dst, int dstSize) {
+    for (int y = 0; y < dstSize; ++y) {
+        int y0 = std::min(y * 2, srcSize - 1), y1 = std::min(y * 2 + 1, srcSize - 1);
+        for (int x = 0; x < dstSize; ++x) {
+            int x0 = std::min(x * 2, srcSize - 1), x1 = std::min(x * 2 + 1, srcSize - 1);
+            for (int c = 0; c < CHANNELS; ++c) {
+                int sum = src[(y0 * srcSize + x0) * CHANNELS + c] + src[(y0 * srcSize + x1) * CHANNELS + c] +
+                          src[(y1 * srcSize + x0) * CHANNELS + c] + src[(y1 * srcSize + x1) * CHANNELS + c];
+                dst[(y * dstSize + x) * CHANNELS + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+bool convertAtlasToCubemap(const std::string& atlasPath, CubemapImage& out) {
+    int width, height, channels;
+    unsigned char* data = stbi_load(atlasPath.c_str(), &width, &height, &channels, CHANNELS);
+    if (!data) {
+        std::cerr << "Failed to load atlas: " << atlasPath << std::endl;
+        return false;
+    }
+
+    // Calculate each face's size
+    int faceSize = width / 4; // assuming 4 faces horizontally
+    if (faceSize <= 0 || height != 3 * faceSize) {
+        std::cerr << "Unexpected atlas aspect ratio!" << std::endl;
+        stbi_image_free(data);
+        return false;
+    }
+
+    int mipCount = 1;
+    while ((faceSize >> mipCount) > 0)
+        ++mipCount;
+
+    CubemapHeader header;
+    std::memcpy(header.magic, CUBEMAP_CACHE_MAGIC, 4);
+    header.version = CUBEMAP_CACHE_VERSION;
+    header.faceSize = (uint32_t)faceSize;
+    header.mipCount = (uint32_t)mipCount;
+
+    out.bytes.assign(sizeof(header) + payloadBytes(faceSize, mipCount), 0);
+    std::memcpy(out.bytes.data(), &header, sizeof(header));
+    CubemapView view = out.view();
+
+    // Atlas cells of the standard cross layout, in GL face order
+    const int cells[6][2] = { { 2, 1 }, { 0, 1 }, { 1, 0 }, { 1, 2 }, { 1, 1 }, { 3, 1 } };
+    for (int f = 0; f < 6; ++f) {
+        unsigned char* face = const_cast<unsigned char*>(view.face(0, f));
+        for (int row = 0; row < faceSize; ++row) {
+            int srcY = cells[f][1] * faceSize + row;
+            std::memcpy(&face[row * faceSize * CHANNELS],
+                        &data[(srcY * width + cells[f][0] * faceSize) * CHANNELS],
+                        faceSize * CHANNELS);
+        }
+    }
+    stbi_image_free(data);
+
+    for (int level = 1; level < mipCount; ++level) {
+        for (int f = 0; f < 6; ++f) {
+            downsample(view.face(level - 1, f), view.levelSize(level - 1),
+                       const_cast<unsigned char*>(view.face(level, f)), view.levelSize(level));
+        }
+    }
+    return true;
+}
+
+bool writeCubemapCache(const std::string& path, const CubemapImage& image) {
+    // Write to a temporary name first so a crash never leaves a truncated cache
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        if (!file.is_open()) return false;
+        file.write((const char*)image.bytes.data(), (std::streamsize)image.bytes.size());
+        if (!file) return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+std::string cubemapCachePath(const std::string& atlasPath) {
+    return std::filesystem::path(atlasPath).replace_extension(".mrcube").string();
+}
+
+bool cubemapCacheIsFresh(const std::string& cachePath, const std::string& atlasPath) {
+    std::error_code ec;
+    auto cacheTime = std::filesystem::last_write_time(cachePath, ec);
+    if (ec) return false;
+    auto atlasTime = std::filesystem::last_write_time(atlasPath, ec);
+    if (ec) return true;    // atlas gone, the cache is all we have
+    return cacheTime >= atlasTime;
+}
+
+bool loadCubemap(const std::string& atlasPath, LoadedCubemap& out) {
+    // Only the first launch after the atlas changes pays for the decode
+    std::string cachePath = cubemapCachePath(atlasPath);
+
+    out.fromCache = cubemapCacheIsFresh(cachePath, atlasPath) && out.mapped.open(cachePath);
+    if (out.fromCache)
+        return true;
+
+    if (!convertAtlasToCubemap(atlasPath, out.image))
+        return false;
+
+    // A read-only asset directory just means decoding again next time
+    if (!writeCubemapCache(cachePath, out.image))
+        std::cerr << "Could not write cubemap cache: " << cachePath << std::endl;
+    return true;
+}
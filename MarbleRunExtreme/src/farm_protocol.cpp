@@ -0,0 +1,267 @@
+#include "farm_protocol.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+void writeVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(uint8_t(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(uint8_t(v));
+}
+
+void writeFloat(std::vector<uint8_t>& out, float f) {
+    uint8_t bytes[4];
+    std::memcpy(bytes, &f, 4);
+    out.insert(out.end(), bytes, bytes + 4);
+}
+
+void writeString(std::vector<uint8_t>& out, const std::string& s) {
+    writeVarint(out, s.size());
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+// Length prefix, then the payload built after the type byte
+void finishMessage(std::vector<uint8_t>& out, FarmMessage type, const std::vector<uint8_t>& fields) {
+    writeVarint(out, fields.size() + 1);
+    out.push_back((uint8_t)type);
+    out.insert(out.end(), fields.begin(), fields.end());
+}
+
+// Reads fields in order; any overrun sets !ok and yields zeros from then on
+struct Reader {
+    const std::vector<uint8_t>& data;
+    size_t pos = 0;
+    bool ok = true;
+
+    explicit Reader(const std::vector<uint8_t>& data) : data(data) {}
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; ok && shift < 64; shift += 7) {
+            if (pos >= data.size()) break;
+            uint8_t b = data[pos++];
+            v |= uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+
+    float f32() {
+        if (!ok || data.size() - pos < 4) {
+            ok = false;
+            return 0.0f;
+        }
+        float f;
+        std::memcpy(&f, &data[pos], 4);
+        pos += 4;
+        return f;
+    }
+
+    uint8_t u8() {
+        if (!ok || pos >= data.size()) {
+            ok = false;
+            return 0;
+        }
+        return data[pos++];
+    }
+
+    std::string string() {
+        uint64_t n = varint();
+        if (!ok || n > data.size() - pos) {
+            ok = false;
+            return {};
+        }
+        std::string s(data.begin() + pos, data.begin() + pos + n);
+        pos += n;
+        return s;
+    }
+
+    // Everything read and nothing left over
+    bool done() const { return ok && pos == data.size(); }
+};
+
+} // namespace
+
+void encodeFarmMessage(const FarmJob& job, std::vector<uint8_t>& out) {
+    std::vector<uint8_t> f;
+    writeVarint(f, job.id);
+    writeVarint(f, job.seed);
+    writeVarint(f, job.marbleCount);
+    writeFloat(f, job.tickRate);
+    writeFloat(f, job.maxTime);
+    writeString(f, job.track);
+    finishMessage(out, FarmMessage::Job, f);
+}
+
+void encodeFarmMessage(const FarmFinish& finish, std::vector<uint8_t>& out) {
+    std::vector<uint8_t> f;
+    writeVarint(f, finish.id);
+    writeVarint(f, finish.firstPlace);
+    writeVarint(f, finish.entries.size());
+    for (const FinishEntry& e : finish.entries) {
+        writeVarint(f, (uint64_t)e.marble);
+        writeFloat(f, e.time);
+    }
+    finishMessage(out, FarmMessage::Finish, f);
+}
+
+void encodeFarmMessage(const FarmDone& done, std::vector<uint8_t>& out) {
+    std::vector<uint8_t> f;
+    writeVarint(f, done.id);
+    writeVarint(f, done.ticks);
+    writeFloat(f, done.simTime);
+    writeFloat(f, done.setupMs);
+    writeFloat(f, done.runMs);
+    f.push_back(done.trackCached ? 1 : 0);
+    writeVarint(f, done.stateHash);
+    finishMessage(out, FarmMessage::Done, f);
+}
+
+void encodeFarmMessage(const FarmError& error, std::vector<uint8_t>& out) {
+    std::vector<uint8_t> f;
+    writeVarint(f, error.id);
+    writeString(f, error.message);
+    finishMessage(out, FarmMessage::Error, f);
+}
+
+bool decodeFarmMessage(const std::vector<uint8_t>& payload, FarmJob& out) {
+    Reader r(payload);
+    out.id = r.varint();
+    uint64_t seed = r.varint();
+    uint64_t marbles = r.varint();
+    out.tickRate = r.f32();
+    out.maxTime = r.f32();
+    out.track = r.string();
+    out.seed = (uint32_t)seed;
+    out.marbleCount = (uint32_t)marbles;
+    return r.done() && seed <= UINT32_MAX && marbles <= UINT32_MAX;
+}
+
+bool decodeFarmMessage(const std::vector<uint8_t>& payload, FarmFinish& out) {
+    Reader r(payload);
+    out.id = r.varint();
+    out.firstPlace = (uint32_t)r.varint();
+    uint64_t count = r.varint();
+    // Each entry takes at least five bytes, so a bogus count fails here
+    if (!r.ok || count > (payload.size() - r.pos) / 5)
+        return false;
+    out.entries.resize(count);
+    for (FinishEntry& e : out.entries) {
+        e.marble = (int)r.varint();
+        e.time = r.f32();
+    }
+    return r.done();
+}
+
+bool decodeFarmMessage(const std::vector<uint8_t>& payload, FarmDone& out) {
+    Reader r(payload);
+    out.id = r.varint();
+    out.ticks = r.varint();
+    out.simTime = r.f32();
+    out.setupMs = r.f32();
+    out.runMs = r.f32();
+    out.trackCached = r.u8() != 0;
+    out.stateHash = r.varint();
+    return r.done();
+}
+
+bool decodeFarmMessage(const std::vector<uint8_t>& payload, FarmError& out) {
+    Reader r(payload);
+    out.id = r.varint();
+    out.message = r.string();
+    return r.done();
+}
+
+void FarmDecoder::feed(const uint8_t* data, size_t size) {
+    // Drop what has been handed out before growing the buffer
+    if (readPos > 0 && readPos == buffer.size()) {
+        buffer.clear();
+        readPos = 0;
+    } else if (readPos > 4096 && readPos * 2 > buffer.size()) {
+        buffer.erase(buffer.begin(), buffer.begin() + readPos);
+        readPos = 0;
+    }
+    buffer.insert(buffer.end(), data, data + size);
+}
+
+bool FarmDecoder::next(FarmMessage& type, std::vector<uint8_t>& payload) {
+    if (broken) return false;
+
+    // Length prefix, which may not all be here yet
+    uint64_t length = 0;
+    size_t pos = readPos;
+    for (int shift = 0;; shift += 7) {
+        if (pos >= buffer.size())
+            return false;
+        if (shift > 28) {
+            broken = true;
+            return false;
+        }
+        uint8_t b = buffer[pos++];
+        length |= uint64_t(b & 0x7f) << shift;
+        if (!(b & 0x80)) break;
+    }
+    if (length == 0 || length > FARM_MAX_MESSAGE_BYTES) {
+        broken = true;
+        return false;
+    }
+    if (buffer.size() - pos < length)
+        return false;
+
+    type = (FarmMessage)buffer[pos];
+    payload.assign(buffer.begin() + pos + 1, buffer.begin() + pos + length);
+    readPos = pos + length;
+    return true;
+}
+
+bool sendAll(int fd, const std::vector<uint8_t>& bytes) {
+    size_t sent = 0;
+    while (sent < bytes.size()) {
+        ssize_t n = ::write(fd, bytes.data() + sent, bytes.size() - sent);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+bool receiveSome(int fd, FarmDecoder& decoder) {
+    uint8_t chunk[16384];
+    for (;;) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        decoder.feed(chunk, (size_t)n);
+        return true;
+    }
+}
+
+int connectRaceFarm(const std::string& socketPath) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << socketPath << "\n";
+        return -1;
+    }
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        std::cerr << "socket: " << std::strerror(errno) << "\n";
+        return -1;
+    }
+    if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        std::cerr << "Failed to connect to " << socketPath << ": " << std::strerror(errno) << "\n";
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
@@ -61,7 +61,7 @@ MarbleEntity* FinishTrigger::checkForWinner(const std::vector<MarbleEntity>& mar
         if (!rb) continue;
 
         for (auto& m : marbles) {
-            if (m.body == rb)
+            if (m.body.get() == rb)
                 return const_cast<MarbleEntity*>(&m);
         }
     }
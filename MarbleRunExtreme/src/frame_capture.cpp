@@ -0,0 +1,209 @@
+#include "frame_capture.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+FrameCapture::FrameCapture(int width, int height, int ringSize, int queueDepth)
+    : width(width), height(height), ring(std::max(1, ringSize))
+{
+    size_t bytes = (size_t)width * height * 4;
+    for (Slot& slot : ring) {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    freeFrames.resize(std::max(1, queueDepth));
+    for (Frame& frame : freeFrames)
+        frame.rgba.resize(bytes);
+}
+
+FrameCapture::~FrameCapture() {
+    finish();
+    for (Slot& slot : ring)
+        glDeleteBuffers(1, &slot.pbo);
+}
+
+bool FrameCapture::open(CaptureFormat captureFormat, const std::string& captureTarget) {
+    if (writer.joinable()) return false;
+    format = captureFormat;
+    target = captureTarget;
+
+    switch (format) {
+    case CaptureFormat::PpmSequence: {
+        std::error_code ec;
+        std::filesystem::create_directories(target, ec);
+        if (ec) {
+            std::cerr << "FrameCapture: cannot create " << target << ": " << ec.message() << "\n";
+            return false;
+        }
+        break;
+    }
+    case CaptureFormat::RawStream:
+        stream = std::fopen(target.c_str(), "wb");
+        break;
+    case CaptureFormat::Pipe:
+        stream = popen(target.c_str(), "w");
+        break;
+    }
+    if (format != CaptureFormat::PpmSequence && !stream) {
+        std::cerr << "FrameCapture: cannot open " << target << "\n";
+        return false;
+    }
+
+    writer = std::thread(&FrameCapture::writerLoop, this);
+    return true;
+}
+
+void FrameCapture::capture() {
+    if (!writer.joinable() || finished) return;
+
+    // The slot's previous readback is ringSize frames old by now
+    Slot& slot = ring[next];
+    if (slot.frame >= 0)
+        retire(slot);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.frame = frameCounter++;
+    next = (next + 1) % (int)ring.size();
+    ++captureStats.framesRead;
+}
+
+void FrameCapture::retire(Slot& slot) {
+    // Poll first so only real waits count as stalls
+    GLenum status = glClientWaitSync(slot.fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        ++captureStats.fenceStalls;
+        do {
+            status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while (status == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    Frame frame;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (freeFrames.empty()) {
+            ++captureStats.writerStalls;
+            changed.wait(lock, [&] { return !freeFrames.empty(); });
+        }
+        frame = std::move(freeFrames.back());
+        freeFrames.pop_back();
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frame.rgba.size(), GL_MAP_READ_BIT);
+    if (pixels) {
+        std::memcpy(frame.rgba.data(), pixels, frame.rgba.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    frame.index = slot.frame;
+    slot.frame = -1;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(frame));
+    }
+    changed.notify_all();
+}
+
+void FrameCapture::finish() {
+    if (finished) return;
+    finished = true;
+
+    // Oldest first, so frames reach the writer in order
+    for (size_t i = 0; i < ring.size(); ++i) {
+        Slot& slot = ring[(next + i) % ring.size()];
+        if (slot.frame >= 0)
+            retire(slot);
+    }
+
+    if (writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        writer.join();
+    }
+
+    if (stream) {
+        if (format == CaptureFormat::Pipe) {
+            if (pclose(stream) != 0)
+                captureStats.writeFailed = true;
+        } else {
+            std::fclose(stream);
+        }
+        stream = nullptr;
+    }
+}
+
+void FrameCapture::writerLoop() {
+    std::vector<uint8_t> rgb((size_t)width * height * 3);
+    for (;;) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return stopping || !pending.empty(); });
+            if (pending.empty()) return;
+            frame = std::move(pending.front());
+            pending.pop_front();
+        }
+
+        // Once a write fails the rest are dropped, but buffers keep cycling
+        bool ok = !captureStats.writeFailed && writeFrame(frame, rgb);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ok) ++captureStats.framesWritten;
+            else captureStats.writeFailed = true;
+            freeFrames.push_back(std::move(frame));
+        }
+        changed.notify_all();
+    }
+}
+
+bool FrameCapture::writeFrame(const Frame& frame, std::vector<uint8_t>& rgb) {
+    // GL rows start at the bottom; every output wants the top row first
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* src = &frame.rgba[(size_t)(height - 1 - y) * width * 4];
+        uint8_t* dst = &rgb[(size_t)y * width * 3];
+        for (int x = 0; x < width; ++x) {
+            dst[x * 3 + 0] = src[x * 4 + 0];
+            dst[x * 3 + 1] = src[x * 4 + 1];
+            dst[x * 3 + 2] = src[x * 4 + 2];
+        }
+    }
+
+    if (format == CaptureFormat::PpmSequence) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%06ld.ppm", frame.index);
+        std::string path = (std::filesystem::path(target) / name).string();
+
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            std::cerr << "FrameCapture: cannot write " << path << "\n";
+            return false;
+        }
+        std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+        bool ok = std::fwrite(rgb.data(), 1, rgb.size(), file) == rgb.size();
+        ok = std::fclose(file) == 0 && ok;
+        return ok;
+    }
+
+    if (std::fwrite(rgb.data(), 1, rgb.size(), stream) != rgb.size()) {
+        std::cerr << "FrameCapture: write to " << target << " failed\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,100 @@
+#include "frame_profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+enum { SERIES_CPU_FRAME, SERIES_PHYSICS, SERIES_GPU_TOTAL, SERIES_FIRST_PASS };
+
+void RollingStats::add(double value) {
+    if (samples.size() < window) {
+        samples.push_back(value);
+    } else {
+        samples[next] = value;
+        next = (next + 1) % window;
+    }
+}
+
+Percentiles RollingStats::percentiles() const {
+    Percentiles result;
+    if (samples.empty()) return result;
+
+    sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    auto rank = [&](double p) {
+        size_t i = (size_t)std::ceil(p * sorted.size());
+        return sorted[std::min(sorted.size(), std::max<size_t>(i, 1)) - 1];
+    };
+    result.p50 = rank(0.50);
+    result.p95 = rank(0.95);
+    result.p99 = rank(0.99);
+    return result;
+}
+
+FrameProfiler::FrameProfiler(size_t window)
+    : gpuTimer((int)RenderPass::Count)
+{
+    series.push_back({ "cpu frame", RollingStats(window) });
+    series.push_back({ "physics", RollingStats(window) });
+    series.push_back({ "gpu total", RollingStats(window) });
+    for (int p = 0; p < (int)RenderPass::Count; ++p)
+        series.push_back({ std::string("gpu ") + renderPassName((RenderPass)p), RollingStats(window) });
+}
+
+bool FrameProfiler::openLog(const std::string& path) {
+    logFile.open(path, std::ios::out | std::ios::trunc);
+    if (!logFile) {
+        std::cerr << "FrameProfiler: cannot open " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+void FrameProfiler::beginFrame() {
+    frameStart = Clock::now();
+    gpuTimer.beginFrame();
+}
+
+void FrameProfiler::beginPhysics() {
+    physicsStart = Clock::now();
+}
+
+void FrameProfiler::endPhysics() {
+    series[SERIES_PHYSICS].stats.add(std::chrono::duration<double, std::milli>(Clock::now() - physicsStart).count());
+}
+
+void FrameProfiler::endFrame() {
+    gpuTimer.endFrame();
+    series[SERIES_CPU_FRAME].stats.add(std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count());
+
+    while (gpuTimer.popFrame(passMs)) {
+        double total = 0.0;
+        for (size_t p = 0; p < passMs.size(); ++p) {
+            series[SERIES_FIRST_PASS + p].stats.add(passMs[p]);
+            total += passMs[p];
+        }
+        series[SERIES_GPU_TOTAL].stats.add(total);
+    }
+}
+
+std::vector<std::string> FrameProfiler::summary() const {
+    std::vector<std::string> lines;
+    char line[96];
+    std::snprintf(line, sizeof(line), "%-14s %7s %7s %7s", "ms", "p50", "p95", "p99");
+    lines.push_back(line);
+    for (const Series& s : series) {
+        Percentiles p = s.stats.percentiles();
+        std::snprintf(line, sizeof(line), "%-14s %7.2f %7.2f %7.2f", s.name.c_str(), p.p50, p.p95, p.p99);
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+void FrameProfiler::log(double seconds) {
+    if (!logFile) return;
+    logFile << "t=" << seconds << "s samples=" << series[SERIES_CPU_FRAME].stats.count()
+            << " gpu_dropped=" << gpuTimer.droppedFrames() << "\n";
+    for (const std::string& line : summary())
+        logFile << "  " << line << "\n";
+    logFile.flush();
+}
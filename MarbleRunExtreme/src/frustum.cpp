@@ -0,0 +1,86 @@
+#include "frustum.h"
+
+void AabbList::clear() {
+    minX.clear(); minY.clear(); minZ.clear();
+    maxX.clear(); maxY.clear(); maxZ.clear();
+}
+
+void AabbList::add(const Aabb& box) {
+    minX.push_back(box.min.x); minY.push_back(box.min.y); minZ.push_back(box.min.z);
+    maxX.push_back(box.max.x); maxY.push_back(box.max.y); maxZ.push_back(box.max.z);
+}
+
+Frustum::Frustum(const glm::mat4& m) {
+    // Gribb/Hartmann: each plane is the last row plus or minus one of the others
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+        rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+    for (int i = 0; i < 3; ++i) {
+        planes[i * 2]     = rows[3] + rows[i];
+        planes[i * 2 + 1] = rows[3] - rows[i];
+    }
+
+    // Normalise so sphere radii can be compared against plane distances
+    for (auto& p : planes)
+        p /= glm::length(glm::vec3(p));
+}
+
+bool Frustum::intersects(const Aabb& box) const {
+    for (const auto& p : planes) {
+        // Corner furthest along the plane normal
+        glm::vec3 v(p.x > 0.0f ? box.max.x : box.min.x,
+                    p.y > 0.0f ? box.max.y : box.min.y,
+                    p.z > 0.0f ? box.max.z : box.min.z);
+        if (glm::dot(glm::vec3(p), v) + p.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const {
+    for (const auto& p : planes) {
+        if (glm::dot(glm::vec3(p), center) + p.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+void Frustum::cull(const AabbList& boxes, std::vector<int>& visible) const {
+    size_t n = boxes.size();
+    inside.assign(n, 1);
+    uint8_t* in = inside.data();
+
+    for (const auto& p : planes) {
+        // Pick the furthest corner per plane once, so the inner loop has no branches
+        const float* xs = p.x > 0.0f ? boxes.maxX.data() : boxes.minX.data();
+        const float* ys = p.y > 0.0f ? boxes.maxY.data() : boxes.minY.data();
+        const float* zs = p.z > 0.0f ? boxes.maxZ.data() : boxes.minZ.data();
+        for (size_t i = 0; i < n; ++i) {
+            float d = p.x * xs[i] + p.y * ys[i] + p.z * zs[i] + p.w;
+            in[i] &= (uint8_t)(d >= 0.0f);
+        }
+    }
+
+    visible.clear();
+    for (size_t i = 0; i < n; ++i)
+        if (in[i]) visible.push_back((int)i);
+}
+
+void Frustum::cullSpheres(const std::vector<glm::vec4>& spheres, std::vector<int>& visible) const {
+    size_t n = spheres.size();
+    inside.assign(n, 1);
+    uint8_t* in = inside.data();
+    const glm::vec4* s = spheres.data();
+
+    for (const auto& p : planes) {
+        for (size_t i = 0; i < n; ++i) {
+            float d = p.x * s[i].x + p.y * s[i].y + p.z * s[i].z + p.w + s[i].w;
+            in[i] &= (uint8_t)(d >= 0.0f);
+        }
+    }
+
+    visible.clear();
+    for (size_t i = 0; i < n; ++i)
+        if (in[i]) visible.push_back((int)i);
+}
@@ -0,0 +1,89 @@
+#include "gpu_timer.h"
+#include <algorithm>
+
+GpuTimer::GpuTimer(int passCount, int frameLatency)
+    : passCount(passCount), ring(std::max(2, frameLatency)) {}
+
+GpuTimer::~GpuTimer() {
+    for (Slot& slot : ring)
+        if (!slot.queries.empty())
+            glDeleteQueries((GLsizei)slot.queries.size(), slot.queries.data());
+}
+
+void GpuTimer::beginFrame() {
+    collect();
+
+    // Every slot is still waiting on the GPU: give up on the oldest
+    Slot& slot = ring[writeIndex];
+    if (slot.pending) {
+        slot.pending = false;
+        readIndex = (readIndex + 1) % (int)ring.size();
+        --pendingCount;
+        ++dropped;
+    }
+    slot.used = 0;
+}
+
+void GpuTimer::beginPass(int pass) {
+    endPass();
+
+    Slot& slot = ring[writeIndex];
+    if (slot.used == (int)slot.queries.size()) {
+        GLuint query = 0;
+        glGenQueries(1, &query);
+        slot.queries.push_back(query);
+        slot.passes.push_back(0);
+    }
+    slot.passes[slot.used] = pass;
+    glBeginQuery(GL_TIME_ELAPSED, slot.queries[slot.used]);
+    ++slot.used;
+    running = true;
+}
+
+void GpuTimer::endPass() {
+    if (!running) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    running = false;
+}
+
+void GpuTimer::endFrame() {
+    endPass();
+
+    Slot& slot = ring[writeIndex];
+    if (slot.used == 0) return;
+    slot.pending = true;
+    ++pendingCount;
+    writeIndex = (writeIndex + 1) % (int)ring.size();
+}
+
+void GpuTimer::collect() {
+    // Oldest first, stopping at the first frame that isn't done
+    while (pendingCount > 0) {
+        Slot& slot = ring[readIndex];
+        for (int i = 0; i < slot.used; ++i) {
+            GLint available = 0;
+            glGetQueryObjectiv(slot.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) return;
+        }
+
+        std::vector<double> passMs(passCount, 0.0);
+        for (int i = 0; i < slot.used; ++i) {
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &ns);
+            if (slot.passes[i] >= 0 && slot.passes[i] < passCount)
+                passMs[slot.passes[i]] += ns * 1e-6;
+        }
+        finished.push_back(std::move(passMs));
+
+        slot.pending = false;
+        readIndex = (readIndex + 1) % (int)ring.size();
+        --pendingCount;
+    }
+}
+
+bool GpuTimer::popFrame(std::vector<double>& passMs) {
+    if (finished.empty()) return false;
+    passMs = std::move(finished.front());
+    finished.pop_front();
+    return true;
+}
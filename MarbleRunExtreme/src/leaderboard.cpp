@@ -0,0 +1,87 @@
+#include "leaderboard.h"
+#include "race.h"
+#include <algorithm>
+#include <cstdio>
+
+void Leaderboard::update(const TrackProgressIndex& index,
+                         const std::vector<MarbleEntity>& marbles,
+                         const std::vector<FinishEntry>& finishOrder,
+                         int spread)
+{
+    size_t count = marbles.size();
+    if (ranking.size() != count) {
+        progress.assign(count, TrackPosition());
+        keys.assign(count, 0.0);
+        places.assign(count, 0);
+        ranking.resize(count);
+        for (size_t i = 0; i < count; ++i)
+            ranking[i] = (int)i;
+        spread = 1;
+    }
+
+    size_t first = 0, stride = 1;
+    if (spread > 1) {
+        first = (size_t)(slice % spread);
+        stride = (size_t)spread;
+        slice = (slice + 1) % spread;
+    }
+    for (size_t i = first; i < count; i += stride) {
+        TrackPosition p = index.locate(marbles[i].renderable.position, progress[i].segment);
+        if (p.segment >= 0)
+            progress[i] = p;
+        keys[i] = progress[i].distance;
+    }
+
+    // Anything past the finish is ahead of everything still racing
+    double finishedKey = index.totalLength() + 1.0 + (double)finishOrder.size();
+    for (size_t place = 0; place < finishOrder.size(); ++place)
+        keys[finishOrder[place].marble] = finishedKey - (double)place;
+
+    sortRanking();
+    for (size_t i = 0; i < count; ++i)
+        places[ranking[i]] = (int)i;
+}
+
+void Leaderboard::rebase(int count) {
+    for (TrackPosition& p : progress)
+        p.segment = p.segment >= count ? p.segment - count : -1;
+}
+
+void Leaderboard::sortRanking() {
+    // Insertion sort from last tick's order, bounded so a shuffle can't go quadratic
+    size_t n = ranking.size();
+    size_t budget = 8 * n + 64, moves = 0;
+    for (size_t i = 1; i < n; ++i) {
+        int marble = ranking[i];
+        double key = keys[marble];
+        size_t j = i;
+        while (j > 0 && keys[ranking[j - 1]] < key) {
+            ranking[j] = ranking[j - 1];
+            --j;
+            ++moves;
+        }
+        ranking[j] = marble;
+        if (moves > budget) {
+            std::stable_sort(ranking.begin(), ranking.end(),
+                             [&](int a, int b) { return keys[a] > keys[b]; });
+            return;
+        }
+    }
+}
+
+std::vector<std::string> Leaderboard::summary(int count, int marble) const {
+    std::vector<std::string> lines;
+    char line[64];
+    auto add = [&](int place) {
+        int m = ranking[place];
+        std::snprintf(line, sizeof(line), "%3d. #%-5d %8.1f m", place + 1, m, progress[m].distance);
+        lines.push_back(line);
+    };
+
+    int shown = std::min(count, (int)ranking.size());
+    for (int place = 0; place < shown; ++place)
+        add(place);
+    if (marble >= 0 && marble < (int)places.size() && places[marble] >= shown)
+        add(places[marble]);
+    return lines;
+}
@@ -1,9 +1,14 @@
 // Standard headers
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <cmath>
 #include <random>
+#include <chrono>
+#include <memory>
 
 // OpenGL / GLM
 #include <GL/glew.h>
@@ -14,7 +19,9 @@
 
 // My headers
 #include "marble.h"
+#include "marble_renderer.h"
 #include "shader_utils.h"
+#include "shader_program.h"
 #include "skybox.h"
 #include "camera.h"
 #include "physics.h"
@@ -22,7 +29,17 @@
 #include "box_entity.h"
 #include "track.h"
 #include "track_utils.h"
-#include "finish_trigger.h"
+#include "track_batch.h"
+#include "race.h"
+#include "frustum.h"
+#include "render_queue.h"
+#include "race_view.h"
+#include "cubemap_cache.h"
+#include "task_graph.h"
+#include "frame_profiler.h"
+#include "text_overlay.h"
+#include "memory_report.h"
+#include "state_hash.h"
 
 // Bullet
 #include <bullet/btBulletDynamicsCommon.h>
@@ -37,13 +54,43 @@ float lastFrame = 0.0f;
 
 const std::string SKYBOX_IMAGE = "assets/skybox/red_sky.png";
 
+// Deterministic races step at this rate whatever the frame rate
+const float FIXED_TICK = 1.0f / 60.0f;
+const int MAX_TICKS_PER_FRAME = 8;
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     glViewport(0, 0, width, height);
     winWidth = width;
     winHeight = height;
 }
 
-int main() {
+// Progress bar drawn with scissored clears while startup tasks run, so no
+// shader has to be ready for it
+static void drawLoadingScreen(float progress) {
+    glClearColor(0.1f, 0.1f, 0.2f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    int barWidth = winWidth / 2, barHeight = 12;
+    int x = (winWidth - barWidth) / 2, y = winHeight / 2 - barHeight / 2;
+
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(x, y, barWidth, barHeight);
+    glClearColor(0.2f, 0.2f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glScissor(x, y, (int)(barWidth * progress), barHeight);
+    glClearColor(1.0f, 0.5f, 0.2f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+// Loads and runs the race in the window. Everything holding GL objects is
+// local to it, so it is all released before main() destroys the context.
+static void runRace(GLFWwindow* window, int argc, char** argv, std::chrono::steady_clock::time_point launchTime);
+
+int main(int argc, char** argv) {
+    using Clock = std::chrono::steady_clock;
+    auto launchTime = Clock::now();
+    
     // ---------------- GLFW / OpenGL Init ----------------
     if (!glfwInit()) return -1;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -70,232 +117,271 @@ int main() {
     
     glEnable(GL_DEPTH_TEST);
     
-    // ---------------- Shaders ----------------
-    GLuint skyboxProgram = createShaderProgram("shaders/skybox.vert", "shaders/skybox.frag");
-    GLuint marbleProgram = createShaderProgram("shaders/marble.vert", "shaders/marble.frag");
-    GLuint trackProgram = createShaderProgram("shaders/track.vert", "shaders/track.frag");
-    
-    // ---------------- Scene Objects ----------------
-    Skybox skybox(SKYBOX_IMAGE);
-    
-    // ---------------- Bullet Physics ----------------
-    PhysicsWorld physics;
-    //physics.addGround(); // Used for testing
-    
-    // ---------------- Track and Marble Setup ----------------
-    Track track;
-    TrackSegment funnelSeg = buildFunnelSegment(
-        physics,
-        180.0f,
-        10.0f,
-        30.0f,
-        20.0f,
-        3.0f,
-        5.0f
-    );
-    track.addSegment(funnelSeg);
-    //track.addSegment(buildCurvedSegment(physics, 180.0f, 15.0f));
-    
-    std::vector<MarbleEntity> marbles;
-    MarbleEntity* playerMarble = nullptr;
-    
-    // Random engine setup
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    
-    // Random property distributions
-    std::uniform_real_distribution<float> colorDist(0.2f, 1.0f);
-    std::uniform_real_distribution<float> radiusDist(0.3f, 0.7f);
-    std::uniform_real_distribution<float> massDist(0.5f, 4.0f);
+    runRace(window, argc, argv, launchTime);
     
-    // Random position offsets relative to player spawn
-    std::uniform_real_distribution<float> offsetXZ(-2.0f, 2.0f);
-    std::uniform_real_distribution<float> offsetY(-1.0f, 1.0f);
+    glfwTerminate();
+    return 0;
+}
+
+static void runRace(GLFWwindow* window, int argc, char** argv, std::chrono::steady_clock::time_point launchTime) {
+    using Clock = std::chrono::steady_clock;
+    auto msSinceLaunch = [&] { return std::chrono::duration<double, std::milli>(Clock::now() - launchTime).count(); };
     
-    const int NUM_MARBLES = 25;
+    // ---------------- Startup ----------------
+    // File reads, image decoding and the race build run on workers; the main
+    // thread only compiles and uploads as their results come in, and draws a
+    // loading bar in between instead of blocking.
+    RaceView raceView;
+    ShaderProgram textProgram;
+    struct ProgramLoad {
+        RaceView::ProgramFiles files;
+        ShaderSources sources;
+    };
+    std::vector<ProgramLoad> programLoads;
+    for (const auto& files : raceView.programFiles())
+        programLoads.push_back({ files, ShaderSources() });
+    programLoads.push_back({ { &textProgram, "shaders/text.vert", "shaders/text.frag", {} }, ShaderSources() });
     
-    // Player marble spawn
-    glm::vec3 spawnCenter(31.0f, 26.0f, 1.0f);
-    marbles.emplace_back(spawnCenter,
-                         glm::vec3(0.2f, 0.6f, 1.0f),
-                         0.5f, 1.0f, physics);
-    playerMarble = &marbles.back();
+    auto skyboxCubemap = std::make_unique<LoadedCubemap>();
     
-    // Generate random marbles around player spawn
-    for (int i = 0; i < NUM_MARBLES - 1; ++i) {
-        glm::vec3 pos(
-                      spawnCenter.x + offsetXZ(gen),
-                      spawnCenter.y + offsetY(gen),
-                      spawnCenter.z + offsetXZ(gen)
-                      );
-        glm::vec3 color(colorDist(gen), colorDist(gen), colorDist(gen));
-        float radius = radiusDist(gen);
-        float mass = massDist(gen);
-        
-        marbles.emplace_back(pos, color, radius, mass, physics);
+    // --seed S picks the race; --deterministic steps it at a fixed tick so
+    // the same seed gives the same race, and --hash-log FILE writes its
+    // per-tick state hashes for comparing against marblerun_headless
+    RaceSettings raceSettings;
+    raceSettings.seed = std::random_device{}();
+    std::string hashLogPath;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--endless")                   raceSettings.endless = true;
+        else if (arg == "--deterministic")        raceSettings.deterministic = true;
+        else if (arg == "--seed" && hasValue)     raceSettings.seed = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--hash-log" && hasValue) hashLogPath = argv[++i];
+        else std::cerr << "Ignoring unknown argument " << arg << "\n";
     }
+    std::cout << "Race seed " << raceSettings.seed << "\n";
+    std::unique_ptr<Race> racePtr;
     
-    // Move entire track so entry is at the marble spawn point
-    float trackXOffset = 0.0f;
-    float trackYOffset = -17.0f;
-    float trackZOffset = -10.0f;
+    // Declared last so it is destroyed first: a window closed mid-load joins
+    // the running workers before anything they write to, or any GL object,
+    // goes away
+    TaskGraph startup;
     
-    glm::vec3 trackStartPos = spawnCenter + glm::vec3(trackXOffset, trackYOffset, trackZOffset);
+    std::vector<TaskGraph::TaskId> programTasks;
+    for (auto& load : programLoads) {
+        const RaceView::ProgramFiles& files = load.files;
+        auto read = startup.add("read " + files.vertexPath, [&load] {
+            load.sources = loadShaderSources(load.files.vertexPath, load.files.fragmentPath,
+                                             load.files.sharedFragmentPaths);
+        });
+        programTasks.push_back(startup.add("compile " + files.vertexPath, [&load] {
+            *load.files.program = ShaderProgram(load.sources);
+            load.sources = ShaderSources();
+        }, { read }, TaskThread::Main));
+    }
     
-    track.segments[0].setWorldTransform(glm::translate(glm::mat4(1.0f), trackStartPos));
+    startup.add("program constants", [&] {
+        raceView.setProgramConstants();
+        textProgram.use();
+        textProgram.set("font", (int)TEXT_FONT_TEXTURE_UNIT);
+    }, programTasks, TaskThread::Main);
     
-    track.addSegment(buildCurvedSegment(physics, 360.0f, 15.0f));
-    track.addSegment(buildCurvedSegment(physics, -360.0f, 15.0f, -40.0f));
-    track.addSegment(buildCurvedSegment(physics,  100.0f));
-    track.addSegment(buildCurvedSegment(physics, -100.0f, 15.0f, -40.0f));
+    // Maps the baked cubemap, or decodes the atlas on first run
+    auto skyboxLoad = startup.add("load skybox", [&] {
+        if (!loadCubemap(SKYBOX_IMAGE, *skyboxCubemap))
+            std::cerr << "Failed to load skybox: " << SKYBOX_IMAGE << std::endl;
+    });
+    startup.add("upload skybox", [&] {
+        raceView.skybox = std::make_unique<Skybox>(skyboxCubemap->view());
+        skyboxCubemap.reset();  // unmap, GL has its own copy now
+    }, { skyboxLoad }, TaskThread::Main);
     
-    float straigthLength = 60.0f;
-    float straigthWidth = 30.0f;
+    // Physics world, track meshes and marbles are all CPU-side
+    auto raceBuild = startup.add("build race", [&] {
+        racePtr = std::make_unique<Race>(raceSettings);
+    });
+    // Pack the whole track into one buffer's worth of data, then upload it
+    auto trackPrepare = startup.add("prepare track batch", [&] {
+        raceView.trackBatch.prepare(racePtr->track);
+    }, { raceBuild });
+    startup.add("upload track batch", [&] {
+        raceView.trackBatch.upload();
+    }, { trackPrepare }, TaskThread::Main);
     
-    track.addSegment(buildStraightSegment(physics, straigthLength, -10.0f, 1.0f, straigthWidth));
+    startup.start();
     
-    // Access the last added segment
-    TrackSegment& straight = track.segments.back();
-    auto obstacles = generateSlotMachineObstacles(physics, straight, straigthLength, straigthWidth  - 15.0f, 15);
+    bool firstFrame = true;
+    while (!startup.allFinished()) {
+        if (glfwWindowShouldClose(window))
+            return;
+        
+        // Leave most of the frame for presenting so the bar stays responsive
+        startup.runMainThreadTasks(8.0);
+        
+        drawLoadingScreen((float)startup.finishedCount() / startup.size());
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+        
+        if (firstFrame) {
+            firstFrame = false;
+            std::cout << "Time to first frame: " << msSinceLaunch() << " ms" << std::endl;
+        }
+    }
     
-    track.addSegment(buildStraightSegment(physics, 10.0f, 10.0f, 2.0f, straigthWidth));
+    Race& race = *racePtr;
+    raceView.finishLoading(race);
     
-    // Adding a stair / steps
-    float stepLength = 5.0f;
-    track.addSegment(buildStraightSegment(physics, stepLength, -90.0f, 4.0f, straigthWidth));
-    track.addSegment(buildStraightSegment(physics, stepLength, 90.0f, 2.0f, straigthWidth));
-    track.addSegment(buildStraightSegment(physics, stepLength, -90.0f, 2.0f, straigthWidth));
-    track.addSegment(buildStraightSegment(physics, stepLength, 90.0f, 2.0f, straigthWidth));
-    track.addSegment(buildStraightSegment(physics, stepLength, -90.0f, 2.0f, straigthWidth));
-    track.addSegment(buildStraightSegment(physics, stepLength, 90.0f, 2.0f, straigthWidth));
-    track.addSegment(buildStraightSegment(physics, stepLength, -90.0f, 2.0f, straigthWidth));
-    track.addSegment(buildStraightSegment(physics, stepLength, 90.0f, 2.0f, straigthWidth));
-    track.addSegment(buildStraightSegment(physics, stepLength, -90.0f, 2.0f, straigthWidth));
-    track.addSegment(buildStraightSegment(physics, stepLength, 90.0f, 2.0f, straigthWidth));
-    track.addSegment(buildStraightSegment(physics, stepLength, -90.0f, 2.0f, straigthWidth));
-    track.addSegment(buildStraightSegment(physics, stepLength, 90.0f, 2.0f, straigthWidth));
-    track.addSegment(buildStraightSegment(physics, stepLength, -90.0f, 2.0f, straigthWidth));
-    track.addSegment(buildStraightSegment(physics, stepLength, 90.0f, 2.0f, straigthWidth));
+    bool winnerDeclared = false;
     
-    // Finish trigger and last step /goal
-    track.addSegment(buildStraightSegment(physics, straigthLength - 20.0f, 0.0f, 2.0f, straigthWidth));
-    TrackSegment& lastSeg = track.segments.back();
-    lastSeg.body->setCollisionFlags(
-                                    lastSeg.body->getCollisionFlags() | btCollisionObject::CF_NO_CONTACT_RESPONSE
-                                    );
+    // Render queue stats go in the window title and frame timings in the
+    // log once a second
+    float statsTimer = 0.0f;
     
-    MarbleEntity* winnerMarble = nullptr;
-    bool winnerDeclared = false;
+    // Rolling frame timings and the standings, shown in the corner (toggle with F3)
+    FrameProfiler profiler;
+    profiler.openLog("frame_stats.log");
+    TextOverlay overlay;
+    bool showOverlay = true;
+    bool f3PressedLastFrame = false;
+    bool f4PressedLastFrame = false;    // F4 writes memory_report.json
+    float overlayTimer = 0.0f;
     
     // ---------------- Light and Camera----------------
     glm::vec3 lightPos(2.0f, 2.0f, 2.0f);
     camera.movementSpeed = 10.0f;
     
+    std::ofstream hashLog;
+    if (!hashLogPath.empty()) {
+        hashLog.open(hashLogPath);
+        if (hashLog)
+            hashLog << race.ticks << " " << formatStateHash(race.stateHash()) << "\n";
+        else
+            std::cerr << "Failed to open " << hashLogPath << " for writing\n";
+    }
+    float tickDebt = 0.0f;
+    
+    // Loading time shouldn't count as the first race step
+    lastFrame = glfwGetTime();
+    bool raceStarted = false;
+    
     // ---------------- Render Loop ----------------
     while (!glfwWindowShouldClose(window)) {
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        profiler.beginFrame();
         
         processInput(window, camera, deltaTime);
         
-        // Step physics
-        physics.step(deltaTime);
+        bool f3Pressed = glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS;
+        if (f3Pressed && !f3PressedLastFrame)
+            showOverlay = !showOverlay;
+        f3PressedLastFrame = f3Pressed;
+
+        bool f4Pressed = glfwGetKey(window, GLFW_KEY_F4) == GLFW_PRESS;
+        if (f4Pressed && !f4PressedLastFrame) {
+            MemoryReport memory = measureMemory(race);
+            raceView.measureMemory(memory);
+            if (memory.writeJson("memory_report.json"))
+                std::cout << "Wrote memory_report.json" << std::endl;
+        }
+        f4PressedLastFrame = f4Pressed;
         
-        // Update all marbles
-        for (auto& m : marbles)
-            m.updateFromPhysics(physics);
+        // Step physics, update marbles and check the finish line. A
+        // deterministic race runs whole ticks and carries the remainder, and
+        // drops time rather than fall further behind after a long frame.
+        profiler.beginPhysics();
+        if (raceSettings.deterministic) {
+            tickDebt += deltaTime;
+            int ticksRun = 0;
+            while (tickDebt >= FIXED_TICK && ticksRun < MAX_TICKS_PER_FRAME) {
+                race.step(FIXED_TICK);
+                if (hashLog.is_open())
+                    hashLog << race.ticks << " " << formatStateHash(race.stateHash()) << "\n";
+                tickDebt -= FIXED_TICK;
+                ++ticksRun;
+            }
+            if (ticksRun == MAX_TICKS_PER_FRAME)
+                tickDebt = 0.0f;
+        } else {
+            race.step(deltaTime);
+        }
+        profiler.endPhysics();
         
         // ---------------- Check for winner ----------------
-        if (!winnerDeclared) {
-            for (auto& m : marbles) {
-                struct WinnerCallback : public btCollisionWorld::ContactResultCallback {
-                    btCollisionObject* targetSegment;
-                    bool hit = false;
-                    WinnerCallback(btCollisionObject* seg) : targetSegment(seg) {}
-                    btScalar addSingleResult(btManifoldPoint& cp,
-                                             const btCollisionObjectWrapper* colObj0Wrap, int partId0, int index0,
-                                             const btCollisionObjectWrapper* colObj1Wrap, int partId1, int index1) override
-                    {
-                        // Only trigger if collision is with the target segment
-                        if (colObj0Wrap->getCollisionObject() == targetSegment ||
-                            colObj1Wrap->getCollisionObject() == targetSegment)
-                        {
-                            hit = true;
-                        }
-                        return 0; // continue
-                    }
-                };
-
-                WinnerCallback callback(lastSeg.body);
-                physics.getWorld()->contactTest(m.body, callback);
-
-                if (callback.hit) {
-                    winnerMarble = &m;
-                    winnerDeclared = true;
-
-                    std::cout << "WINNER detected! Marble at position: "
-                              << m.renderable.position.x << ", "
-                              << m.renderable.position.y << ", "
-                              << m.renderable.position.z << std::endl;
-
-                    // Stop winner marble
-                    m.body->setLinearVelocity(btVector3(0,0,0));
-                    m.body->setAngularVelocity(btVector3(0,0,0));
-                    m.body->setActivationState(DISABLE_SIMULATION);
-                    break;
-                }
-            }
+        MarbleEntity* winnerMarble = race.winner();
+        if (winnerMarble && !winnerDeclared) {
+            winnerDeclared = true;
+            std::cout << "WINNER detected! Marble at position: "
+                      << winnerMarble->renderable.position.x << ", "
+                      << winnerMarble->renderable.position.y << ", "
+                      << winnerMarble->renderable.position.z << std::endl;
         }
 
-        // ---------------- Clear screen ----------------
-        glClearColor(0.1f, 0.1f, 0.2f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        
-        glm::mat4 view = camera.getViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f),
-                                                (float)winWidth / (float)winHeight, 0.1f, 500.0f);
-        
         // ---------------- Update light ----------------
         float lightSpeed = 0.2f;
         lightPos.x = 2.0f * sin(glfwGetTime() * lightSpeed);
         lightPos.z = 2.0f * cos(glfwGetTime() * lightSpeed);
         
         // ---------------- Render scene ----------------
+        ViewParams viewParams;
+        viewParams.view = camera.getViewMatrix();
+        viewParams.projection = glm::perspective(glm::radians(45.0f),
+                                                 (float)winWidth / (float)winHeight, 0.1f, 500.0f);
+        viewParams.position = camera.position;
+        viewParams.viewportHeight = winHeight;
+        viewParams.lightPos = lightPos;
+        raceView.render(race, viewParams, winnerMarble, &profiler.gpu());
         
-        // --- MARBLE SHADER ---
-        glUseProgram(marbleProgram);
-        glUniform3fv(glGetUniformLocation(marbleProgram, "lightPos"), 1, glm::value_ptr(lightPos));
-        glUniform3fv(glGetUniformLocation(marbleProgram, "viewPos"), 1, glm::value_ptr(camera.position));
-        
-        // Draw marbles
-        for (auto& m : marbles) {
-            bool isWinner = (&m == winnerMarble);
-            glUniform1i(glGetUniformLocation(marbleProgram, "highlight"), isWinner ? 1 : 0);
-            m.renderable.draw(marbleProgram, view, projection);
+        // ---------------- Timings ----------------
+        overlayTimer += deltaTime;
+        if (showOverlay && overlayTimer >= 0.25f) {
+            overlayTimer = 0.0f;
+            std::vector<std::string> lines = profiler.summary();
+            lines.push_back("");
+            for (const std::string& line : race.leaderboard.summary(5, 0))
+                lines.push_back(line);
+            if (race.generator) {
+                char line[64];
+                std::snprintf(line, sizeof(line), "TRACK %zu SEGS  OUT %d", race.track.segments.size(),
+                              race.eliminatedCount);
+                lines.push_back(line);
+            }
+            MemoryReport memory = measureMemory(race);
+            raceView.measureMemory(memory);
+            MemoryBytes memoryTotal = memory.total();
+            char memoryLine[64];
+            std::snprintf(memoryLine, sizeof(memoryLine), "MEM CPU %.1f MB  GPU %.1f MB",
+                          memoryTotal.cpu() / 1048576.0, memoryTotal.gpu / 1048576.0);
+            lines.push_back(memoryLine);
+            overlay.setText(lines);
         }
+        if (showOverlay)
+            overlay.draw(textProgram, winWidth, winHeight);
         
-        // --- TRACK SHADER ---
-        glUseProgram(trackProgram);
-        glUniform3fv(glGetUniformLocation(trackProgram, "lightPos"), 1, glm::value_ptr(lightPos));
-        glUniform3fv(glGetUniformLocation(trackProgram, "viewPos"), 1, glm::value_ptr(camera.position));
-        glUniform3fv(glGetUniformLocation(trackProgram, "objectColor"), 1, glm::value_ptr(glm::vec3(1.0f, 0.5f, 0.2f)));
-        
-        // Draw track pieces
-        for (auto& seg : track.segments)
-            seg.mesh.draw(trackProgram, seg.worldTransform, view, projection);
-        
-        // Draw obstacles
-        for (auto& o : obstacles)
-            o.box->draw(trackProgram, view, projection);
+        statsTimer += deltaTime;
+        if (statsTimer >= 1.0f) {
+            statsTimer = 0.0f;
+            const RenderStats& stats = raceView.stats();
+            std::string title = "Marble Run Extreme - " + std::to_string(stats.draws) + " draws, " +
+                                std::to_string(stats.stateChanges()) + " state changes";
+            glfwSetWindowTitle(window, title.c_str());
+            profiler.log(currentFrame);
+        }
         
-        // --- SKYBOX ---
-        skybox.draw(view, projection, skyboxProgram);
+        // CPU time stops here; waiting for the swap isn't the frame's work
+        profiler.endFrame();
         
         glfwSwapBuffers(window);
         glfwPollEvents();
+        
+        if (!raceStarted) {
+            raceStarted = true;
+            const ProgramCacheStats& cache = programCacheStats();
+            std::cout << "Time to race start: " << msSinceLaunch() << " ms\n"
+                      << "Program binary cache: " << cache.hits << " hits, " << cache.misses << " misses\n"
+                      << "Startup tasks:\n";
+            startup.report(std::cout);
+        }
     }
-    
-    glfwTerminate();
-    return 0;
 }
@@ -1,108 +1,4 @@
 #include "marble.h"
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-#include <vector>
-#include <cmath>
-#include <iostream>
-
-// Generate a simple UV sphere with positions and normals
-static void createSphere(std::vector<float>& vertices, std::vector<unsigned int>& indices,
-                         int sectorCount = 36, int stackCount = 18) {
-    float x, y, z, xy;
-    float nx, ny, nz, lengthInv = 1.0f; // normals = positions for unit sphere
-    float sectorStep = 2 * M_PI / sectorCount;
-    float stackStep = M_PI / stackCount;
-    float sectorAngle, stackAngle;
-
-    for (int i = 0; i <= stackCount; ++i) {
-        stackAngle = M_PI / 2 - i * stackStep; // from pi/2 to -pi/2
-        xy = cosf(stackAngle);
-        z = sinf(stackAngle);
-
-        for (int j = 0; j <= sectorCount; ++j) {
-            sectorAngle = j * sectorStep;
-
-            // vertex position (unit sphere)
-            x = xy * cosf(sectorAngle);
-            y = xy * sinf(sectorAngle);
-
-            // normalized vertex normal
-            nx = x * lengthInv;
-            ny = y * lengthInv;
-            nz = z * lengthInv;
-
-            // Each vertex has 6 floats: position (x,y,z) + normal (nx,ny,nz)
-            vertices.insert(vertices.end(), { x, y, z, nx, ny, nz });
-        }
-    }
-
-    // Indices
-    for (int i = 0; i < stackCount; ++i) {
-        int k1 = i * (sectorCount + 1);
-        int k2 = k1 + sectorCount + 1;
-        for (int j = 0; j < sectorCount; ++j, ++k1, ++k2) {
-            if (i != 0) {
-                indices.push_back(k1);
-                indices.push_back(k2);
-                indices.push_back(k1 + 1);
-            }
-            if (i != (stackCount - 1)) {
-                indices.push_back(k1 + 1);
-                indices.push_back(k2);
-                indices.push_back(k2 + 1);
-            }
-        }
-    }
-}
 
 Marble::Marble(glm::vec3 pos, glm::vec3 col, float r)
     : position(pos), color(col), radius(r) {}
-
-void Marble::draw(GLuint shaderProgram, const glm::mat4& view, const glm::mat4& projection)
-{
-    static GLuint VAO = 0, VBO = 0, EBO = 0;
-    static std::vector<unsigned int> indices;
-
-    // Create geometry once
-    if (VAO == 0) {
-        std::vector<float> vertices;
-        createSphere(vertices, indices);
-
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-        // Position attribute (location = 0)
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        // Normal attribute (location = 1)
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-    }
-
-    glUseProgram(shaderProgram);
-
-    // Build matrices
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
-    model = glm::scale(model, glm::vec3(radius));
-
-    // Send matrices and color to shader
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-
-    glUniform3fv(glGetUniformLocation(shaderProgram, "objectColor"), 1, glm::value_ptr(color));
-
-    // Draw sphere
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
-}
@@ -5,10 +5,9 @@ MarbleEntity::MarbleEntity(const glm::vec3& pos,
                            float radius,
                            float mass,
                            PhysicsWorld& world)
-    : renderable(pos, color, radius) {
-    body = world.addSphere(radius, pos, mass);
-}
+    : renderable(pos, color, radius), body(world.addSphere(radius, pos, mass)) {}
 
 void MarbleEntity::updateFromPhysics(PhysicsWorld& world) {
-    renderable.position = world.getObjectPosition(body);
+    renderable.position = world.getObjectPosition(body.get());
+    renderable.rotation = world.getObjectRotation(body.get());
 }
@@ -0,0 +1,209 @@
+#include "marble_renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Generate a simple UV sphere with positions and normals
+static void createSphere(std::vector<float>& vertices, std::vector<unsigned int>& indices,
+                         int sectorCount = 36, int stackCount = 18) {
+    float x, y, z, xy;
+    float nx, ny, nz, lengthInv = 1.0f; // normals = positions for unit sphere
+    float sectorStep = 2 * M_PI / sectorCount;
+    float stackStep = M_PI / stackCount;
+    float sectorAngle, stackAngle;
+
+    for (int i = 0; i <= stackCount; ++i) {
+        stackAngle = M_PI / 2 - i * stackStep; // from pi/2 to -pi/2
+        xy = cosf(stackAngle);
+        z = sinf(stackAngle);
+
+        for (int j = 0; j <= sectorCount; ++j) {
+            sectorAngle = j * sectorStep;
+
+            // vertex position (unit sphere)
+            x = xy * cosf(sectorAngle);
+            y = xy * sinf(sectorAngle);
+
+            // normalized vertex normal
+            nx = x * lengthInv;
+            ny = y * lengthInv;
+            nz = z * lengthInv;
+
+            // Each vertex has 6 floats: position (x,y,z) + normal (nx,ny,nz)
+            vertices.insert(vertices.end(), { x, y, z, nx, ny, nz });
+        }
+    }
+
+    // Indices
+    for (int i = 0; i < stackCount; ++i) {
+        int k1 = i * (sectorCount + 1);
+        int k2 = k1 + sectorCount + 1;
+        for (int j = 0; j < sectorCount; ++j, ++k1, ++k2) {
+            if (i != 0) {
+                indices.push_back(k1);
+                indices.push_back(k2);
+                indices.push_back(k1 + 1);
+            }
+            if (i != (stackCount - 1)) {
+                indices.push_back(k1 + 1);
+                indices.push_back(k2);
+                indices.push_back(k2 + 1);
+            }
+        }
+    }
+}
+
+// Per-instance attributes (locations 2-4), advanced once per marble
+static void enableInstanceAttributes() {
+    for (GLuint i = 0; i < 3; ++i) {
+        glEnableVertexAttribArray(2 + i);
+        glVertexAttribDivisor(2 + i, 1);
+    }
+}
+
+// Point the bound VAO's instance attributes at this frame's instances
+static void setInstanceOffset(GLuint buffer, size_t offset) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (GLuint i = 0; i < 3; ++i)
+        glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(MarbleInstance),
+                              (void*)(offset + i * sizeof(glm::vec4)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+MarbleRenderer::MarbleRenderer() {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    createSphere(vertices, indices);
+    indexCount = (GLsizei)indices.size();
+
+    VAO = GlVertexArray::create();
+    VBO = GlBuffer::create();
+    EBO = GlBuffer::create();
+
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    bufferBytes = vertices.size() * sizeof(float) + indices.size() * sizeof(unsigned int);
+
+    // Position attribute (location = 0)
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Normal attribute (location = 1)
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    enableInstanceAttributes();
+
+    glBindVertexArray(0);
+
+    // Impostors: one quad per marble, expanded and ray traced in the shaders
+    const float corners[] = { -1.0f, -1.0f,  1.0f, -1.0f,  -1.0f, 1.0f,  1.0f, 1.0f };
+
+    impostorVAO = GlVertexArray::create();
+    quadVBO = GlBuffer::create();
+
+    glBindVertexArray(impostorVAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    bufferBytes += sizeof(corners);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    enableInstanceAttributes();
+
+    glBindVertexArray(0);
+}
+
+void MarbleRenderer::submit(RenderQueue& queue,
+                            StreamBuffer& stream,
+                            const ShaderProgram& meshShader,
+                            const ShaderProgram& impostorShader,
+                            const std::vector<MarbleEntity>& marbles,
+                            const MarbleEntity* highlighted,
+                            const Frustum& frustum)
+{
+    const glm::vec3& cameraPos = queue.cameraPosition();
+
+    bounds.resize(marbles.size());
+    for (size_t i = 0; i < marbles.size(); ++i) {
+        const Marble& m = marbles[i].renderable;
+        bounds[i] = glm::vec4(m.position, m.radius);
+    }
+    frustum.cullSpheres(bounds, visible);
+
+    meshInstanceCount = impostorInstanceCount = 0;
+    if (visible.empty()) return;
+
+    // Either path could take every visible marble, so room for both up front;
+    // instances are written straight into the mapped stream
+    size_t bytes = visible.size() * sizeof(MarbleInstance);
+    size_t meshOffset = 0, impostorOffset = 0;
+    MarbleInstance* meshInstances = (MarbleInstance*)stream.allocate(bytes, sizeof(glm::vec4), meshOffset);
+    MarbleInstance* impostorInstances = (MarbleInstance*)stream.allocate(bytes, sizeof(glm::vec4), impostorOffset);
+    if (!meshInstances || !impostorInstances) {
+        std::cerr << "MarbleRenderer: stream buffer too small for " << visible.size() << " marbles\n";
+        return;
+    }
+
+    // Nearest marble of each kind, used as the packet's sort depth
+    float meshDistance2 = meshDistance * meshDistance;
+    float nearestMesh2 = INFINITY, nearestImpostor2 = INFINITY;
+    for (int i : visible) {
+        const Marble& m = marbles[i].renderable;
+
+        glm::vec3 d = m.position - cameraPos;
+        float distance2 = glm::dot(d, d);
+        bool useMesh = mode == MarbleLodMode::Mesh ||
+                       (mode == MarbleLodMode::Auto && distance2 < meshDistance2);
+
+        MarbleInstance* inst;
+        if (useMesh) {
+            inst = &meshInstances[meshInstanceCount++];
+            nearestMesh2 = std::min(nearestMesh2, distance2);
+        } else {
+            inst = &impostorInstances[impostorInstanceCount++];
+            nearestImpostor2 = std::min(nearestImpostor2, distance2);
+        }
+        inst->positionRadius = glm::vec4(m.position, m.radius);
+        inst->rotation = glm::vec4(m.rotation.x, m.rotation.y, m.rotation.z, m.rotation.w);
+        inst->colorHighlight = glm::vec4(m.color, &marbles[i] == highlighted ? 1.0f : 0.0f);
+    }
+
+    if (meshInstanceCount > 0) {
+        glBindVertexArray(VAO);
+        setInstanceOffset(stream.id(), meshOffset);
+
+        DrawPacket packet;
+        packet.program = &meshShader;
+        packet.vao = VAO;
+        packet.depth = std::sqrt(nearestMesh2);
+        packet.pass = RenderPass::Marbles;
+        packet.command.kind = DrawKind::ElementsInstanced;
+        packet.command.count = indexCount;
+        packet.command.instanceCount = (GLsizei)meshInstanceCount;
+        queue.submit(packet);
+    }
+
+    if (impostorInstanceCount > 0) {
+        glBindVertexArray(impostorVAO);
+        setInstanceOffset(stream.id(), impostorOffset);
+
+        DrawPacket packet;
+        packet.program = &impostorShader;
+        packet.vao = impostorVAO;
+        packet.depth = std::sqrt(nearestImpostor2);
+        packet.pass = RenderPass::Marbles;
+        packet.command.kind = DrawKind::ArraysInstanced;
+        packet.command.mode = GL_TRIANGLE_STRIP;
+        packet.command.count = 4;
+        packet.command.instanceCount = (GLsizei)impostorInstanceCount;
+        queue.submit(packet);
+    }
+    glBindVertexArray(0);
+}
@@ -0,0 +1,66 @@
+#include "marble_spawn.h"
+#include <algorithm>
+
+std::vector<glm::vec3> packSpawnPositions(const std::vector<float>& radii,
+                                          const glm::vec3& base,
+                                          const glm::vec2& footprint,
+                                          float gap)
+{
+    size_t count = radii.size();
+    std::vector<glm::vec3> positions(count);
+
+    struct Row {
+        size_t first = 0, count = 0;
+        float maxRadius = 0.0f;
+        float z = 0.0f;         // centre line, from the front of the layer
+    };
+    std::vector<Row> rows;
+
+    float layerY = base.y;
+    float previousLayerRadius = -1.0f;
+    size_t next = 0;
+    while (next < count) {
+        // Fill one layer row by row; a row that doesn't fit starts the next layer
+        rows.clear();
+        float depth = 0.0f, layerRadius = 0.0f;
+        while (next < count) {
+            Row row;
+            row.first = next;
+            float x = 0.0f, lastRadius = 0.0f;
+            for (size_t i = next; i < count; ++i) {
+                float r = radii[i];
+                float cx = row.count ? x + lastRadius + gap + r : r;
+                if (row.count && cx + r > footprint.x) break;
+                positions[i].x = cx;
+                x = cx;
+                lastRadius = r;
+                row.count++;
+                row.maxRadius = std::max(row.maxRadius, r);
+            }
+
+            float front = rows.empty() ? 0.0f : depth + gap;
+            if (!rows.empty() && front + 2.0f * row.maxRadius > footprint.y) break;
+
+            float width = x + lastRadius;
+            for (size_t i = row.first; i < row.first + row.count; ++i)
+                positions[i].x += base.x - 0.5f * width;
+            row.z = front + row.maxRadius;
+            depth = front + 2.0f * row.maxRadius;
+            layerRadius = std::max(layerRadius, row.maxRadius);
+            rows.push_back(row);
+            next += row.count;
+        }
+
+        if (previousLayerRadius >= 0.0f)
+            layerY += previousLayerRadius + gap + layerRadius;
+        previousLayerRadius = layerRadius;
+
+        for (const Row& row : rows) {
+            for (size_t i = row.first; i < row.first + row.count; ++i) {
+                positions[i].y = layerY;
+                positions[i].z = base.z - 0.5f * depth + row.z;
+            }
+        }
+    }
+    return positions;
+}
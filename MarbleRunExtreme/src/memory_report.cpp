@@ -0,0 +1,163 @@
+#include "memory_report.h"
+#include "race.h"
+#include <fstream>
+#include <iostream>
+
+template <class T> static size_t capacityBytes(const std::vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+template <class T> static size_t capacityBytes(const btAlignedObjectArray<T>& a) {
+    return (size_t)a.capacity() * sizeof(T);
+}
+
+MemoryBytes& MemoryBytes::operator+=(const MemoryBytes& o) {
+    geometry += o.geometry;
+    triangleMesh += o.triangleMesh;
+    bvh += o.bvh;
+    shapes += o.shapes;
+    bodies += o.bodies;
+    gpu += o.gpu;
+    return *this;
+}
+
+MemoryBytes& MemoryReport::subsystem(const std::string& name) {
+    for (auto& s : subsystems)
+        if (s.first == name)
+            return s.second;
+    subsystems.emplace_back(name, MemoryBytes());
+    return subsystems.back().second;
+}
+
+MemoryBytes MemoryReport::total() const {
+    MemoryBytes sum;
+    for (const auto& s : subsystems)
+        sum += s.second;
+    return sum;
+}
+
+static void writeBytes(std::ostream& out, const MemoryBytes& b) {
+    out << "{\"geometry\": " << b.geometry
+        << ", \"triangle_mesh\": " << b.triangleMesh
+        << ", \"bvh\": " << b.bvh
+        << ", \"shapes\": " << b.shapes
+        << ", \"bodies\": " << b.bodies
+        << ", \"gpu\": " << b.gpu
+        << ", \"cpu\": " << b.cpu()
+        << ", \"total\": " << b.total() << "}";
+}
+
+void MemoryReport::writeJson(std::ostream& out) const {
+    out << "{\n  \"track_revision\": " << trackRevision << ",\n  \"total\": ";
+    writeBytes(out, total());
+    out << ",\n  \"subsystems\": {\n";
+    for (size_t i = 0; i < subsystems.size(); ++i) {
+        out << "    \"" << subsystems[i].first << "\": ";
+        writeBytes(out, subsystems[i].second);
+        out << (i + 1 < subsystems.size() ? "," : "") << "\n";
+    }
+    out << "  },\n  \"segments\": [\n";
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const SegmentMemory& s = segments[i];
+        out << "    {\"index\": " << s.index
+            << ", \"kind\": \"" << (s.sweep ? "sweep" : "straight") << "\""
+            << ", \"grid\": [" << s.gridU << ", " << s.gridV << "]"
+            << ", \"vertices\": " << s.vertices
+            << ", \"triangles\": " << s.triangles
+            << ", \"bytes\": ";
+        writeBytes(out, s.bytes);
+        out << "}" << (i + 1 < segments.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+bool MemoryReport::writeJson(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open " << path << " for writing\n";
+        return false;
+    }
+    writeJson(file);
+    return true;
+}
+
+MemoryBytes measureRigidBody(const RigidBody& body) {
+    MemoryBytes b;
+    if (body) {
+        b.bodies += sizeof(btRigidBody);
+        if (body->getMotionState())
+            b.bodies += sizeof(btDefaultMotionState);
+    }
+
+    if (btCollisionShape* shape = body.collisionShape()) {
+        switch (shape->getShapeType()) {
+        case TRIANGLE_MESH_SHAPE_PROXYTYPE: {
+            auto* meshShape = static_cast<btBvhTriangleMeshShape*>(shape);
+            b.shapes += sizeof(btBvhTriangleMeshShape);
+            if (btOptimizedBvh* bvh = meshShape->getOptimizedBvh()) {
+                b.bvh += sizeof(btOptimizedBvh);
+                // Leaves are kept after the build alongside the tree
+                if (bvh->isQuantized())
+                    b.bvh += capacityBytes(bvh->getQuantizedNodeArray())
+                           + capacityBytes(bvh->getLeafNodeArray())
+                           + capacityBytes(bvh->getSubtreeInfoArray());
+                else
+                    b.bvh += bvh->calculateSerializeBufferSize();
+            }
+            break;
+        }
+        case BOX_SHAPE_PROXYTYPE:    b.shapes += sizeof(btBoxShape); break;
+        case SPHERE_SHAPE_PROXYTYPE: b.shapes += sizeof(btSphereShape); break;
+        case STATIC_PLANE_PROXYTYPE: b.shapes += sizeof(btStaticPlaneShape); break;
+        default:                     b.shapes += sizeof(btCollisionShape); break;
+        }
+    }
+
+    // A btTriangleIndexVertexArray only points at arrays someone else owns,
+    // which are counted there (for track segments, as geometry)
+    if (auto* mesh = dynamic_cast<btTriangleMesh*>(body.meshInterface())) {
+        b.triangleMesh += sizeof(btTriangleMesh)
+                        + capacityBytes(mesh->m_4componentVertices)
+                        + capacityBytes(mesh->m_3componentVertices)
+                        + capacityBytes(mesh->m_32bitIndices)
+                        + capacityBytes(mesh->m_16bitIndices);
+    } else if (auto* arrays = dynamic_cast<btTriangleIndexVertexArray*>(body.meshInterface())) {
+        b.triangleMesh += sizeof(btTriangleIndexVertexArray) + capacityBytes(arrays->getIndexedMeshArray());
+    }
+    return b;
+}
+
+SegmentMemory measureSegment(const TrackSegment& seg) {
+    SegmentMemory m;
+    m.sweep = seg.centerline.kind == TrackCenterline::Kind::Sweep;
+    m.gridU = seg.gridU;
+    m.gridV = seg.gridV;
+    m.vertices = seg.vertices.size();
+    m.triangles = seg.indices.size() / 3;
+    m.bytes = measureRigidBody(seg.body);
+    m.bytes.geometry = capacityBytes(seg.vertices) + capacityBytes(seg.normals) + capacityBytes(seg.indices);
+    return m;
+}
+
+MemoryReport measureMemory(const Race& race) {
+    MemoryReport report;
+    report.trackRevision = race.trackRevision;
+
+    MemoryBytes track, obstacles, marbles;
+    for (size_t i = 0; i < race.track.segments.size(); ++i) {
+        SegmentMemory seg = measureSegment(race.track.segments[i]);
+        seg.index = (long)(race.track.retired + i);
+        track += seg.bytes;
+        report.segments.push_back(seg);
+    }
+    for (const Obstacle& o : race.obstacles)
+        obstacles += measureRigidBody(o.box.body);
+    for (const MarbleEntity& m : race.marbles)
+        marbles += measureRigidBody(m.body);
+
+    // subsystem() may grow the list, so no references are held across calls
+    report.subsystem("track") = track;
+    report.subsystem("obstacles") = obstacles;
+    report.subsystem("marbles") = marbles;
+    return report;
+}
@@ -1,4 +1,48 @@
 #include "physics.h"
+#include <utility>
+
+RigidBody::RigidBody(btDiscreteDynamicsWorld* world, btRigidBody* body, btCollisionShape* shape,
+                     btStridingMeshInterface* mesh)
+    : world(world), body(body), shape(shape), mesh(mesh) {}
+
+RigidBody::RigidBody(btRigidBody* body, SharedShape shape)
+    : body(body), sharedShape(std::move(shape)) {}
+
+RigidBody::RigidBody(RigidBody&& other) noexcept
+    : world(std::exchange(other.world, nullptr)),
+      body(std::exchange(other.body, nullptr)),
+      shape(std::exchange(other.shape, nullptr)),
+      mesh(std::exchange(other.mesh, nullptr)),
+      sharedShape(std::move(other.sharedShape)) {}
+
+RigidBody& RigidBody::operator=(RigidBody&& other) noexcept {
+    if (this != &other) {
+        reset();
+        world = std::exchange(other.world, nullptr);
+        body = std::exchange(other.body, nullptr);
+        shape = std::exchange(other.shape, nullptr);
+        mesh = std::exchange(other.mesh, nullptr);
+        sharedShape = std::move(other.sharedShape);
+    }
+    return *this;
+}
+
+void RigidBody::reset() {
+    if (body) {
+        if (world)
+            world->removeRigidBody(body);
+        delete body->getMotionState();
+        delete body;
+    }
+    // The shape references the mesh, so it goes first
+    delete shape;
+    delete mesh;
+    sharedShape.reset();
+    world = nullptr;
+    body = nullptr;
+    shape = nullptr;
+    mesh = nullptr;
+}
 
 PhysicsWorld::PhysicsWorld() {
     collisionConfiguration = new btDefaultCollisionConfiguration();
@@ -35,6 +79,10 @@ void PhysicsWorld::step(float deltaTime) {
     dynamicsWorld->stepSimulation(deltaTime, 10);
 }
 
+void PhysicsWorld::stepFixed(float tick) {
+    dynamicsWorld->stepSimulation(tick, 1, tick);
+}
+
 void PhysicsWorld::addGround() {
     btCollisionShape* groundShape = new btStaticPlaneShape(btVector3(0, 1, 0), 0);
     collisionShapes.push_back(groundShape);
@@ -47,9 +95,8 @@ void PhysicsWorld::addGround() {
     dynamicsWorld->addRigidBody(groundBody);
 }
 
-btRigidBody* PhysicsWorld::addSphere(float radius, const glm::vec3& startPos, float mass) {
+RigidBody PhysicsWorld::addSphere(float radius, const glm::vec3& startPos, float mass) {
     btCollisionShape* sphereShape = new btSphereShape(radius);
-    collisionShapes.push_back(sphereShape);
 
     btDefaultMotionState* sphereMotion =
         new btDefaultMotionState(btTransform(btQuaternion(0, 0, 0, 1),
@@ -63,14 +110,13 @@ btRigidBody* PhysicsWorld::addSphere(float radius, const glm::vec3& startPos, fl
     btRigidBody* body = new btRigidBody(sphereCI);
     dynamicsWorld->addRigidBody(body);
 
-    return body;
+    return RigidBody(dynamicsWorld, body, sphereShape);
 }
 
-btRigidBody* PhysicsWorld::addInclinedPlane(const glm::vec3& normal, float constant,
+RigidBody PhysicsWorld::addInclinedPlane(const glm::vec3& normal, float constant,
                                             const glm::vec3& position, const glm::vec3& rotation) {
     // Create plane
     btCollisionShape* planeShape = new btStaticPlaneShape(btVector3(normal.x, normal.y, normal.z), constant);
-    collisionShapes.push_back(planeShape);
 
     // Create transform
     btQuaternion quat;
@@ -82,13 +128,19 @@ btRigidBody* PhysicsWorld::addInclinedPlane(const glm::vec3& normal, float const
     btRigidBody* body = new btRigidBody(planeCI);
 
     dynamicsWorld->addRigidBody(body);
+    return RigidBody(dynamicsWorld, body, planeShape);
+}
+
+RigidBody PhysicsWorld::addBox(const glm::vec3& halfExtents, const glm::vec3& position,
+                                const glm::vec3& rotation, bool isStatic) {
+    RigidBody body = createBox(halfExtents, position, rotation, isStatic);
+    add(body);
     return body;
 }
 
-btRigidBody* PhysicsWorld::addBox(const glm::vec3& halfExtents, const glm::vec3& position,
+RigidBody PhysicsWorld::createBox(const glm::vec3& halfExtents, const glm::vec3& position,
                                   const glm::vec3& rotation, bool isStatic) {
     btCollisionShape* boxShape = new btBoxShape(btVector3(halfExtents.x, halfExtents.y, halfExtents.z));
-    collisionShapes.push_back(boxShape);
 
     btQuaternion quat;
     quat.setEuler(rotation.y, rotation.x, rotation.z); // yaw, pitch, roll
@@ -102,10 +154,13 @@ btRigidBody* PhysicsWorld::addBox(const glm::vec3& halfExtents, const glm::vec3&
         boxShape->calculateLocalInertia(mass, inertia);
 
     btRigidBody::btRigidBodyConstructionInfo boxCI(mass, motionState, boxShape, inertia);
-    btRigidBody* body = new btRigidBody(boxCI);
-    dynamicsWorld->addRigidBody(body);
+    return RigidBody(nullptr, new btRigidBody(boxCI), boxShape);
+}
 
-    return body;
+void PhysicsWorld::add(RigidBody& body) {
+    if (!body || body.world) return;
+    dynamicsWorld->addRigidBody(body.get());
+    body.world = dynamicsWorld;
 }
 
 glm::vec3 PhysicsWorld::getObjectPosition(btRigidBody* body) const {
@@ -115,28 +170,55 @@ glm::vec3 PhysicsWorld::getObjectPosition(btRigidBody* body) const {
     return glm::vec3(pos.getX(), pos.getY(), pos.getZ());
 }
 
+glm::quat PhysicsWorld::getObjectRotation(btRigidBody* body) const {
+    btTransform trans;
+    body->getMotionState()->getWorldTransform(trans);
+    btQuaternion rot = trans.getRotation();
+    return glm::quat(rot.getW(), rot.getX(), rot.getY(), rot.getZ());
+}
+
 void PhysicsWorld::addRigidBody(btRigidBody* body) {
     dynamicsWorld->addRigidBody(body);
 }
 
-btRigidBody* PhysicsWorld::addTriangleMesh(const std::vector<glm::vec3>& vertices,
+RigidBody PhysicsWorld::addTriangleMesh(const std::vector<glm::vec3>& vertices,
+                                        const std::vector<unsigned int>& indices,
+                                        const glm::vec3& position,
+                                        const glm::vec3& rotation)
+{
+    RigidBody body = createTriangleMesh(vertices, indices, position, rotation);
+    add(body);
+    return body;
+}
+
+static btTriangleIndexVertexArray* referenceMesh(const std::vector<glm::vec3>& vertices,
+                                                 const std::vector<unsigned int>& indices)
+{
+    // Bullet reads the caller's arrays in place: no per-triangle copies
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "vertices must be tightly packed floats");
+    static_assert(sizeof(unsigned int) == sizeof(int), "indices are read as PHY_INTEGER");
+    btIndexedMesh part;
+    part.m_numTriangles = (int)(indices.size() / 3);
+    part.m_triangleIndexBase = reinterpret_cast<const unsigned char*>(indices.data());
+    part.m_triangleIndexStride = 3 * sizeof(unsigned int);
+    part.m_numVertices = (int)vertices.size();
+    part.m_vertexBase = reinterpret_cast<const unsigned char*>(vertices.data());
+    part.m_vertexStride = sizeof(glm::vec3);
+    part.m_indexType = PHY_INTEGER;
+    part.m_vertexType = PHY_FLOAT;
+
+    auto* triMesh = new btTriangleIndexVertexArray();
+    triMesh->addIndexedMesh(part, PHY_INTEGER);
+    return triMesh;
+}
+
+RigidBody PhysicsWorld::createTriangleMesh(const std::vector<glm::vec3>& vertices,
                                            const std::vector<unsigned int>& indices,
                                            const glm::vec3& position,
                                            const glm::vec3& rotation)
 {
-    auto* triMesh = new btTriangleMesh();
-
-    for (size_t i = 0; i < indices.size(); i += 3) {
-        const glm::vec3& a = vertices[indices[i]];
-        const glm::vec3& b = vertices[indices[i + 1]];
-        const glm::vec3& c = vertices[indices[i + 2]];
-        triMesh->addTriangle(btVector3(a.x, a.y, a.z),
-                             btVector3(b.x, b.y, b.z),
-                             btVector3(c.x, c.y, c.z));
-    }
-
+    btTriangleIndexVertexArray* triMesh = referenceMesh(vertices, indices);
     btCollisionShape* shape = new btBvhTriangleMeshShape(triMesh, true);
-    collisionShapes.push_back(shape); // now valid
 
     btQuaternion quat;
     quat.setEuler(rotation.y, rotation.x, rotation.z);
@@ -144,9 +226,21 @@ btRigidBody* PhysicsWorld::addTriangleMesh(const std::vector<glm::vec3>& vertice
 
     auto* motion = new btDefaultMotionState(transform);
     btRigidBody::btRigidBodyConstructionInfo ci(0.0f, motion, shape);
-    auto* body = new btRigidBody(ci);
-    dynamicsWorld->addRigidBody(body);
+    return RigidBody(nullptr, new btRigidBody(ci), shape, triMesh);
+}
 
-    return body;
+SharedShape PhysicsWorld::createTriangleMeshShape(const std::vector<glm::vec3>& vertices,
+                                                  const std::vector<unsigned int>& indices)
+{
+    btTriangleIndexVertexArray* triMesh = referenceMesh(vertices, indices);
+    return SharedShape(new btBvhTriangleMeshShape(triMesh, true), [triMesh](btCollisionShape* shape) {
+        delete shape;
+        delete triMesh;
+    });
 }
 
+RigidBody PhysicsWorld::createStatic(const SharedShape& shape) {
+    auto* motion = new btDefaultMotionState(btTransform::getIdentity());
+    btRigidBody::btRigidBodyConstructionInfo ci(0.0f, motion, shape.get());
+    return RigidBody(new btRigidBody(ci), shape);
+}
@@ -0,0 +1,318 @@
+#include "race.h"
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include "state_hash.h"
+#include "marble_spawn.h"
+
+// Under the spawn point, so marbles drop into the first piece
+static const glm::vec3 TRACK_START_OFFSET(0.0f, -17.0f, -10.0f);
+
+Race::Race(const RaceSettings& settings)
+    : Race(settings, nullptr) {}
+
+Race::Race(const RaceSettings& settings, std::shared_ptr<const BuiltTrack> shared)
+    : sharedTrack(std::move(shared)), settings(settings)
+{
+    std::mt19937 seeder(settings.seed);
+    unsigned int trackSeed = seeder();
+    unsigned int marbleSeed = seeder();
+
+    if (sharedTrack) {
+        layTrack(sharedTrack->description, trackSeed, [&](size_t i) {
+            TrackSegment seg = sharedTrack->segments[i].copyGeometry();
+            seg.body = PhysicsWorld::createStatic(sharedTrack->shapes[i]);
+            return seg;
+        });
+    } else if (settings.endless) {
+        buildEndlessStart(seeder());
+    } else {
+        buildTrack(trackSeed);
+    }
+    spawnMarbles(settings.marbleCount, marbleSeed);
+
+    trackIndex.build(track);
+    if (settings.standingsSpread > 0 || settings.endless)
+        leaderboard.update(trackIndex, marbles, finishOrder);
+}
+
+void Race::buildTrack(unsigned int seed) {
+    const TrackDescription& standard = standardTrackDescription();
+    layTrack(standard, seed, [&](size_t i) {
+        TrackSegment seg = makeTrackPiece(standard.pieces[i]);
+        addSegmentBody(physics, seg);
+        return seg;
+    });
+}
+
+// Pieces end to end from under the spawn point, the last one the finish.
+// The k-th piece with obstacles seeds them with seed + k.
+template <class MakeSegment>
+void Race::layTrack(const TrackDescription& description, unsigned int seed, MakeSegment&& segmentFor) {
+    unsigned int obstacleSeed = seed;
+    for (size_t i = 0; i < description.pieces.size(); ++i) {
+        TrackSegment& seg = track.addSegment(segmentFor(i));
+        physics.add(seg.body);
+        if (i == 0)
+            track.setStartTransform(glm::translate(glm::mat4(1.0f), settings.spawnCenter + TRACK_START_OFFSET));
+
+        for (Obstacle& o : makeTrackPieceObstacles(description.pieces[i], seg, obstacleSeed)) {
+            physics.add(o.box.body);
+            o.segment = (long)i;
+            obstacles.push_back(std::move(o));
+        }
+        if (description.pieces[i].obstacles > 0)
+            ++obstacleSeed;
+    }
+
+    // Finish trigger
+    if (!track.segments.empty()) {
+        btRigidBody* finish = finishSegment().body.get();
+        finish->setCollisionFlags(finish->getCollisionFlags() | btCollisionObject::CF_NO_CONTACT_RESPONSE);
+    }
+}
+
+// The usual start funnel and a turn each way, then the generator takes over
+void Race::buildEndlessStart(unsigned int seed) {
+    track.addSegment(buildFunnelSegment(physics, 180.0f, 10.0f, 30.0f, 20.0f, 3.0f, 5.0f));
+    track.setStartTransform(glm::translate(glm::mat4(1.0f), settings.spawnCenter + TRACK_START_OFFSET));
+
+    track.addSegment(buildCurvedSegment(physics, 360.0f, 15.0f));
+    track.addSegment(buildCurvedSegment(physics, -360.0f, 15.0f, -40.0f));
+
+    TrackGeneratorSettings generatorSettings;
+    generatorSettings.seed = seed;
+    generatorSettings.deterministic = settings.deterministic;
+    generator = std::make_unique<TrackGenerator>(track, generatorSettings);
+}
+
+void Race::spawnMarbles(int count, unsigned int seed) {
+    if (count <= 0) return;
+
+    // Random engine setup
+    std::mt19937 gen(seed);
+
+    // Random property distributions
+    std::uniform_real_distribution<float> colorDist(0.2f, 1.0f);
+    std::uniform_real_distribution<float> radiusDist(0.3f, 0.7f);
+    std::uniform_real_distribution<float> massDist(0.5f, 4.0f);
+
+    // The player marble first, then random ones
+    std::vector<glm::vec3> colors(count);
+    std::vector<float> radii(count), masses(count);
+    colors[0] = glm::vec3(0.2f, 0.6f, 1.0f);
+    radii[0] = 0.5f;
+    masses[0] = 1.0f;
+    for (int i = 1; i < count; ++i) {
+        float r = colorDist(gen);
+        float g = colorDist(gen);
+        float b = colorDist(gen);
+        colors[i] = glm::vec3(r, g, b);
+        radii[i] = radiusDist(gen);
+        masses[i] = massDist(gen);
+    }
+
+    // Packed over the funnel entry, so nothing starts inside anything else
+    std::vector<glm::vec3> positions = packSpawnPositions(radii, settings.spawnCenter, settings.spawnFootprint);
+
+    marbles.reserve(count);
+    finished.assign(count, false);
+    eliminated.assign(count, false);
+    for (int i = 0; i < count; ++i)
+        marbles.emplace_back(positions[i], colors[i], radii[i], masses[i], physics);
+}
+
+void Race::step(float deltaTime) {
+    if (settings.deterministic)
+        physics.stepFixed(deltaTime);
+    else
+        physics.step(deltaTime);
+    elapsed += deltaTime;
+    ++ticks;
+
+    // Update all marbles
+    for (auto& m : marbles)
+        m.updateFromPhysics(physics);
+
+    if (!settings.endless)
+        checkFinish();
+    if (generator)
+        leaderboard.update(trackIndex, marbles, finishOrder);
+    else if (settings.standingsSpread > 0)
+        leaderboard.update(trackIndex, marbles, finishOrder, settings.standingsSpread);
+
+    if (generator)
+        advanceTrack();
+}
+
+void Race::advanceTrack() {
+    const std::vector<int>& order = leaderboard.order();
+    float leader = order.empty() ? track.startDistance : leaderboard.progressOf(order.front()).distance;
+
+    int added = generator->attach(track, physics, obstacles, leader);
+    int removed = generator->retire(track, obstacles, leader);
+
+    // Anything behind the retired track has nothing left to roll on
+    float line = generator->retireLine(leader);
+    for (size_t i = 0; i < marbles.size(); ++i) {
+        if (eliminated[i] || leaderboard.progressOf((int)i).distance >= line) continue;
+
+        eliminated[i] = true;
+        ++eliminatedCount;
+        MarbleEntity& m = marbles[i];
+        m.body->setLinearVelocity(btVector3(0,0,0));
+        m.body->setAngularVelocity(btVector3(0,0,0));
+        m.body->setActivationState(DISABLE_SIMULATION);
+    }
+
+    if (removed > 0)
+        leaderboard.rebase(removed);
+    if (added > 0 || removed > 0) {
+        trackIndex.build(track);
+        ++trackRevision;
+    }
+}
+
+int Race::checkFinish() {
+    struct FinishCallback : public btCollisionWorld::ContactResultCallback {
+        btCollisionObject* targetSegment;
+        bool hit = false;
+        FinishCallback(btCollisionObject* seg) : targetSegment(seg) {}
+        btScalar addSingleResult(btManifoldPoint& cp,
+                                 const btCollisionObjectWrapper* colObj0Wrap, int partId0, int index0,
+                                 const btCollisionObjectWrapper* colObj1Wrap, int partId1, int index1) override
+        {
+            // Only trigger if collision is with the target segment
+            if (colObj0Wrap->getCollisionObject() == targetSegment ||
+                colObj1Wrap->getCollisionObject() == targetSegment)
+            {
+                hit = true;
+            }
+            return 0; // continue
+        }
+    };
+
+    if (track.segments.empty()) return 0;
+    btRigidBody* finishBody = finishSegment().body.get();
+    int newlyFinished = 0;
+
+    for (size_t i = 0; i < marbles.size(); ++i) {
+        if (finished[i]) continue;
+
+        MarbleEntity& m = marbles[i];
+        FinishCallback callback(finishBody);
+        physics.getWorld()->contactTest(m.body.get(), callback);
+        if (!callback.hit) continue;
+
+        finished[i] = true;
+        finishOrder.push_back({ (int)i, elapsed });
+        ++newlyFinished;
+
+        // Stop the marble on the finish line
+        m.body->setLinearVelocity(btVector3(0,0,0));
+        m.body->setAngularVelocity(btVector3(0,0,0));
+        m.body->setActivationState(DISABLE_SIMULATION);
+    }
+
+    return newlyFinished;
+}
+
+uint64_t Race::stateHash() const {
+    StateHash hash;
+    hash.add((int64_t)ticks);
+    hash.add((int64_t)track.retired);
+    for (size_t i = 0; i < marbles.size(); ++i) {
+        const btRigidBody* body = marbles[i].body.get();
+        const btTransform& transform = body->getWorldTransform();
+        hash.add(transform.getOrigin());
+        hash.add(transform.getRotation());
+        hash.add(body->getLinearVelocity());
+        hash.add(body->getAngularVelocity());
+        hash.add((int64_t)body->getActivationState());
+        hash.add((int64_t)((finished[i] ? 1 : 0) | (eliminated[i] ? 2 : 0)));
+    }
+    return hash.value();
+}
+
+// Obstacles are tied to segments by run-wide index, which an edit can
+// shift, so they are matched up again by segment id afterwards. The same
+// goes for the finish: whatever ends up last takes the finish flag.
+template <class Edit> void Race::editTrack(Edit&& edit) {
+    if (generator) {
+        std::cerr << "Race: the endless track can't be edited\n";
+        return;
+    }
+    uint64_t oldFinish = track.segments.empty() ? 0 : finishSegment().id;
+
+    std::unordered_map<uint64_t, glm::mat4> before;
+    for (const TrackSegment& seg : track.segments)
+        before[seg.id] = seg.worldTransform;
+    std::vector<uint64_t> obstacleSegment(obstacles.size(), 0);
+    for (size_t i = 0; i < obstacles.size(); ++i) {
+        long s = obstacles[i].segment - (long)track.retired;
+        if (s >= 0 && s < (long)track.segments.size())
+            obstacleSegment[i] = track.segments[s].id;
+    }
+
+    edit();
+
+    std::unordered_map<uint64_t, size_t> index;
+    for (size_t i = 0; i < track.segments.size(); ++i)
+        index[track.segments[i].id] = i;
+
+    std::vector<Obstacle> kept;
+    kept.reserve(obstacles.size());
+    for (size_t i = 0; i < obstacles.size(); ++i) {
+        Obstacle& o = obstacles[i];
+        if (obstacleSegment[i] != 0) {
+            auto it = index.find(obstacleSegment[i]);
+            if (it == index.end())
+                continue;
+            const TrackSegment& seg = track.segments[it->second];
+            const glm::mat4& old = before[seg.id];
+            if (seg.worldTransform != old)
+                transformObstacle(o, seg.worldTransform * glm::inverse(old));
+            o.segment = (long)(track.retired + it->second);
+        }
+        kept.push_back(std::move(o));
+    }
+    obstacles = std::move(kept);
+
+    auto finishing = index.find(oldFinish);
+    if (finishing != index.end() && finishing->second + 1 != track.segments.size()) {
+        btRigidBody* body = track.segments[finishing->second].body.get();
+        body->setCollisionFlags(body->getCollisionFlags() & ~btCollisionObject::CF_NO_CONTACT_RESPONSE);
+    }
+    if (!track.segments.empty()) {
+        btRigidBody* body = finishSegment().body.get();
+        body->setCollisionFlags(body->getCollisionFlags() | btCollisionObject::CF_NO_CONTACT_RESPONSE);
+    }
+
+    trackIndex.build(track);
+    ++trackRevision;
+}
+
+void Race::insertSegment(size_t index, TrackSegment&& seg) {
+    editTrack([&] { physics.add(track.insertSegment(index, std::move(seg)).body); });
+}
+
+void Race::removeSegment(size_t index) {
+    if (index < track.segments.size() && track.segments.size() == 1) {
+        std::cerr << "Race: can't remove the last segment of the track\n";
+        return;
+    }
+    editTrack([&] { track.removeSegment(index); });
+}
+
+void Race::replaceSegment(size_t index, TrackSegment&& seg) {
+    editTrack([&] { physics.add(track.replaceSegment(index, std::move(seg)).body); });
+}
+
+void Race::setTrackStart(const glm::mat4& transform) {
+    editTrack([&] { track.setStartTransform(transform); });
+}
+
+MarbleEntity* Race::winner() {
+    if (finishOrder.empty()) return nullptr;
+    return &marbles[finishOrder.front().marble];
+}
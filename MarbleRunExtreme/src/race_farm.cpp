@@ -0,0 +1,321 @@
+#include "race_farm.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Bounds on a job, on top of the track limits in parseTrackDescription.
+// The work a job can ask for is marbles times ticks, so that product is
+// capped too: 1e9 is some 5000 default jobs (25 marbles, two minutes at
+// 60 Hz), around a quarter of an hour of one worker at a microsecond of
+// physics per marble tick. The other caps only keep the numbers sane.
+// Anything a job still fails to build comes back to it as an ERROR.
+static const uint32_t MAX_MARBLES = 100000;
+static const float MAX_TICK_RATE = 10000.0f;
+static const float MAX_RACE_TIME = 24.0f * 3600.0f;
+static const long long MAX_MARBLE_TICKS = 1000LL * 1000 * 1000;
+
+RaceFarm::Connection::~Connection() {
+    if (fd >= 0)
+        ::close(fd);
+}
+
+bool RaceFarm::Connection::send(const std::vector<uint8_t>& bytes) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (closed) return false;
+    if (!sendAll(fd, bytes))
+        closed = true;
+    return !closed;
+}
+
+RaceFarm::RaceFarm(const RaceFarmSettings& settings)
+    : settings(settings), cache(settings.cachedTracks) {}
+
+RaceFarm::~RaceFarm() {
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        ::unlink(settings.socketPath.c_str());
+    }
+    for (int fd : wakeFds)
+        if (fd >= 0)
+            ::close(fd);
+}
+
+bool RaceFarm::listen() {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (settings.socketPath.empty() || settings.socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "RaceFarm: bad socket path '" << settings.socketPath << "'\n";
+        return false;
+    }
+    std::strncpy(addr.sun_path, settings.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    // stop() has to be able to write without blocking, even from a signal handler
+    if (::pipe(wakeFds) < 0) {
+        std::cerr << "RaceFarm: pipe: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    for (int fd : wakeFds)
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    // A socket left by a server that didn't get to clean up; anything else stays
+    struct stat st;
+    if (::stat(settings.socketPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+        ::unlink(settings.socketPath.c_str());
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || ::bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(listenFd, SOMAXCONN) < 0) {
+        std::cerr << "RaceFarm: can't listen on " << settings.socketPath << ": " << std::strerror(errno) << "\n";
+        if (listenFd >= 0)
+            ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    return true;
+}
+
+void RaceFarm::serve() {
+    if (listenFd < 0) return;
+
+    int workerCount = settings.workers > 0 ? settings.workers : (int)std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < workerCount; ++i)
+        workers.emplace_back(&RaceFarm::workerLoop, this);
+
+    while (!stopping) {
+        pollfd fds[2] = { { listenFd, POLLIN, 0 }, { wakeFds[0], POLLIN, 0 } };
+        int ready = ::poll(fds, 2, 1000);
+        reapClients(false);
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "RaceFarm: poll: " << std::strerror(errno) << "\n";
+            break;
+        }
+        if (ready <= 0 || stopping || (fds[1].revents & POLLIN)) continue;
+
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        auto connection = std::make_shared<Connection>();
+        connection->fd = fd;
+
+        Client client;
+        client.connection = connection;
+        client.finished = std::make_shared<std::atomic<bool>>(false);
+        client.reader = std::thread([this, connection, finished = client.finished] {
+            readLoop(connection);
+            *finished = true;
+        });
+        clients.push_back(std::move(client));
+    }
+
+    // Wake everything: readers through their sockets, workers through the
+    // queue. Write sides stay open so cut-off jobs can still report.
+    stopping = true;
+    ::close(listenFd);
+    listenFd = -1;
+    ::unlink(settings.socketPath.c_str());
+    for (Client& c : clients)
+        ::shutdown(c.connection->fd, SHUT_RD);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobsFailed += (long)queue.size();
+        queue.clear();
+    }
+    jobReady.notify_all();
+
+    for (std::thread& w : workers)
+        w.join();
+    workers.clear();
+    reapClients(true);
+}
+
+void RaceFarm::stop() {
+    stopping = true;
+    if (wakeFds[1] >= 0) {
+        char byte = 1;
+        ssize_t ignored = ::write(wakeFds[1], &byte, 1);
+        (void)ignored;
+    }
+}
+
+RaceFarmStats RaceFarm::stats() const {
+    RaceFarmStats s;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        s.jobsDone = jobsDone;
+        s.jobsFailed = jobsFailed;
+    }
+    s.cache = cache.stats();
+    return s;
+}
+
+void RaceFarm::reapClients(bool all) {
+    for (auto it = clients.begin(); it != clients.end();) {
+        if (all || *it->finished) {
+            it->reader.join();
+            it = clients.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void RaceFarm::readLoop(std::shared_ptr<Connection> connection) {
+    FarmDecoder decoder;
+    FarmMessage type;
+    std::vector<uint8_t> payload;
+
+    while (!stopping && receiveSome(connection->fd, decoder)) {
+        bool malformed = false;
+        while (!malformed && decoder.next(type, payload)) {
+            Job job;
+            job.connection = connection;
+            if (type != FarmMessage::Job || !decodeFarmMessage(payload, job.request)) {
+                malformed = true;
+                break;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.push_back(std::move(job));
+            }
+            jobReady.notify_one();
+        }
+
+        // Out of step with the client: say so and hang up
+        if (malformed || decoder.failed()) {
+            std::vector<uint8_t> bytes;
+            encodeFarmMessage(FarmError{ 0, "malformed message" }, bytes);
+            connection->send(bytes);
+            connection->closed = true;
+            ::shutdown(connection->fd, SHUT_RDWR);
+            return;
+        }
+    }
+}
+
+void RaceFarm::workerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [&] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        run(job);
+    }
+}
+
+void RaceFarm::fail(const Job& job, const std::string& message) {
+    std::vector<uint8_t> bytes;
+    encodeFarmMessage(FarmError{ job.request.id, message }, bytes);
+    job.connection->send(bytes);
+    std::lock_guard<std::mutex> lock(mutex);
+    ++jobsFailed;
+}
+
+void RaceFarm::run(const Job& job) {
+    using Clock = std::chrono::steady_clock;
+    const FarmJob& request = job.request;
+    if (job.connection->closed) {
+        fail(job, "connection closed");
+        return;
+    }
+
+    auto t0 = Clock::now();
+    if (request.marbleCount == 0 || request.marbleCount > MAX_MARBLES ||
+        !(request.tickRate > 0.0f && request.tickRate <= MAX_TICK_RATE) ||
+        !(request.maxTime > 0.0f && request.maxTime <= MAX_RACE_TIME)) {
+        fail(job, "marble count, tick rate or max time out of range");
+        return;
+    }
+
+    // Counted in ticks: a float clock stops advancing long before 24 h at
+    // high tick rates
+    const long long tickLimit = std::llround((double)request.maxTime * request.tickRate);
+    if (tickLimit * request.marbleCount > MAX_MARBLE_TICKS) {
+        fail(job, "marbles times ticks over " + std::to_string(MAX_MARBLE_TICKS));
+        return;
+    }
+
+    TrackDescription parsed;
+    const TrackDescription* description = &standardTrackDescription();
+    if (!request.track.empty()) {
+        std::string error;
+        if (!parseTrackDescription(request.track, parsed, error)) {
+            fail(job, "track " + error);
+            return;
+        }
+        description = &parsed;
+    }
+
+    bool cached = false;
+    RaceSettings raceSettings;
+    raceSettings.seed = request.seed;
+    raceSettings.marbleCount = (int)request.marbleCount;
+    raceSettings.deterministic = true;
+    raceSettings.standingsSpread = 0;
+    std::unique_ptr<Race> built;
+    try {
+        built = std::make_unique<Race>(raceSettings, cache.get(*description, &cached));
+    } catch (const std::exception& e) {
+        fail(job, std::string("can't build race: ") + e.what());
+        return;
+    }
+    Race& race = *built;
+
+    auto t1 = Clock::now();
+
+    // Finishers go out in batches, in place order
+    size_t sent = 0;
+    auto sendFinishers = [&] {
+        if (race.finishOrder.size() == sent) return;
+        FarmFinish finish;
+        finish.id = request.id;
+        finish.firstPlace = (uint32_t)sent;
+        finish.entries.assign(race.finishOrder.begin() + sent, race.finishOrder.end());
+        sent = race.finishOrder.size();
+        std::vector<uint8_t> bytes;
+        encodeFarmMessage(finish, bytes);
+        job.connection->send(bytes);
+    };
+
+    const float dt = 1.0f / request.tickRate;
+    int sinceSent = 0;
+    while (race.ticks < tickLimit && !race.allFinished()) {
+        if (stopping || job.connection->closed) {
+            fail(job, "server stopping");
+            return;
+        }
+        race.step(dt);
+        if (++sinceSent >= settings.finishBatchTicks) {
+            sendFinishers();
+            sinceSent = 0;
+        }
+    }
+    sendFinishers();
+
+    auto t2 = Clock::now();
+
+    FarmDone done;
+    done.id = request.id;
+    done.ticks = (uint64_t)race.ticks;
+    done.simTime = (float)((double)race.ticks / request.tickRate);
+    done.setupMs = (float)std::chrono::duration<double, std::milli>(t1 - t0).count();
+    done.runMs = (float)std::chrono::duration<double, std::milli>(t2 - t1).count();
+    done.trackCached = cached;
+    done.stateHash = race.stateHash();
+    std::vector<uint8_t> bytes;
+    encodeFarmMessage(done, bytes);
+    job.connection->send(bytes);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ++jobsDone;
+}
@@ -0,0 +1,138 @@
+#include "race_view.h"
+#include <iostream>
+
+std::vector<RaceView::ProgramFiles> RaceView::programFiles() {
+    return {
+        { &skyboxProgram,         "shaders/skybox.vert",          "shaders/skybox.frag",          {} },
+        { &marbleProgram,         "shaders/marble.vert",          "shaders/marble.frag",          { "shaders/marble_shading.frag" } },
+        { &marbleImpostorProgram, "shaders/marble_impostor.vert", "shaders/marble_impostor.frag", { "shaders/marble_shading.frag" } },
+        { &obstacleProgram,       "shaders/obstacle.vert",        "shaders/track.frag",           {} },
+        { &trackBatchProgram,     "shaders/track_batch.vert",     "shaders/track.frag",           {} },
+    };
+}
+
+void RaceView::load(const Race& race, const std::string& skyboxPath) {
+    for (const auto& files : programFiles())
+        *files.program = ShaderProgram(files.vertexPath, files.fragmentPath, files.sharedFragmentPaths);
+    setProgramConstants();
+
+    skybox = std::make_unique<Skybox>(skyboxPath);
+    trackBatch.build(race.track);
+
+    finishLoading(race);
+}
+
+void RaceView::setProgramConstants() {
+    // Track colour never changes, so set it once
+    obstacleProgram.use();
+    obstacleProgram.set("objectColor", glm::vec3(1.0f, 0.5f, 0.2f));
+    trackBatchProgram.use();
+    trackBatchProgram.set("objectColor", glm::vec3(1.0f, 0.5f, 0.2f));
+    trackBatchProgram.set("segmentBounds", (int)TRACK_BOUNDS_TEXTURE_UNIT);
+}
+
+void RaceView::finishLoading(const Race& race) {
+    frameUniforms = std::make_unique<FrameUniformBuffer>();
+    marbleRenderer = std::make_unique<MarbleRenderer>();
+    instanceStream = std::make_unique<StreamBuffer>(marbleStreamBytes(race));
+    cube = std::make_unique<CubeMesh>();
+    obstacleRenderer = std::make_unique<ObstacleRenderer>(*cube);
+    syncTrack(race);
+
+    glEnable(GL_DEPTH_TEST);
+}
+
+void RaceView::syncTrack(const Race& race) {
+    obstacleRenderer->build(race.obstacles);
+
+    segmentBounds.clear();
+    obstacleBounds.clear();
+    for (const auto& seg : race.track.segments)
+        segmentBounds.add(seg.worldBounds);
+    for (const auto& o : race.obstacles)
+        obstacleBounds.add(o.bounds);
+
+    trackRevision = race.trackRevision;
+}
+
+void RaceView::measureMemory(MemoryReport& report) const {
+    // The batch is rebuilt on the first frame after the track changes, so
+    // it can be a revision behind; then there is only the total
+    const std::vector<size_t>& perSegment = trackBatch.segmentGpuBytes();
+    if (report.trackRevision == trackRevision && perSegment.size() == report.segments.size())
+        for (size_t i = 0; i < perSegment.size(); ++i)
+            report.segments[i].bytes.gpu += perSegment[i];
+
+    report.subsystem("track").gpu += trackBatch.gpuBytes();
+    if (obstacleRenderer)
+        report.subsystem("obstacles").gpu += obstacleRenderer->gpuBytes() + CubeMesh::gpuBytes();
+    if (marbleRenderer)
+        report.subsystem("marbles").gpu += marbleRenderer->gpuBytes() + instanceStream->gpuBytes();
+    if (skybox)
+        report.subsystem("skybox").gpu += skybox->gpuBytes();
+}
+
+// Worst case for MarbleRenderer: every marble could land on either path,
+// plus alignment
+size_t RaceView::marbleStreamBytes(const Race& race) {
+    return 2 * (race.marbles.size() * sizeof(MarbleInstance) + sizeof(glm::vec4));
+}
+
+void RaceView::render(const Race& race, const ViewParams& params, const MarbleEntity* highlighted,
+                      GpuTimer* timer) {
+    if (!frameUniforms) {
+        std::cerr << "RaceView: render() before finishLoading()\n";
+        return;
+    }
+
+    // The endless track grew or shrank since the last frame
+    if (race.trackRevision != trackRevision) {
+        trackBatch.build(race.track);
+        syncTrack(race);
+    }
+
+    // ---------------- Clear screen ----------------
+    glClearColor(0.1f, 0.1f, 0.2f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // ---------------- Per-frame uniforms ----------------
+    FrameUniforms frame;
+    frame.view = params.view;
+    frame.projection = params.projection;
+    frame.lightPos = glm::vec4(params.lightPos, 1.0f);
+    frame.viewPos = glm::vec4(params.position, 1.0f);
+    frameUniforms->update(frame);
+
+    // ---------------- Frustum culling ----------------
+    Frustum frustum(params.projection * params.view);
+    frustum.cull(segmentBounds, visibleSegments);
+    frustum.cull(obstacleBounds, visibleObstacles);
+
+    // ---------------- Render scene ----------------
+    // Everything is submitted to the queue, which sorts and draws it in one go
+    queue.begin(params.position);
+    instanceStream->beginFrame(marbleStreamBytes(race));
+
+    // --- MARBLES ---
+    // Visible marbles, meshes up close and impostors further out, winner highlighted
+    marbleRenderer->submit(queue, *instanceStream, marbleProgram, marbleImpostorProgram, race.marbles,
+                           highlighted, frustum);
+
+    // --- TRACK ---
+    // The visible track pieces in one multi-draw, curves at distance-based LOD
+    TrackLodView lodView;
+    lodView.cameraPos = params.position;
+    lodView.pixelScale = 0.5f * params.viewportHeight * params.projection[1][1];
+    trackBatch.submit(queue, trackBatchProgram, visibleSegments, lodView);
+
+    // Obstacles, one instanced draw of the shared cube
+    obstacleRenderer->submit(queue, obstacleProgram, race.obstacles, visibleObstacles);
+
+    // --- SKYBOX ---
+    if (skybox)
+        skybox->submit(queue, skyboxProgram);
+
+    instanceStream->flush();
+    queue.flush(timer);
+    instanceStream->endFrame();
+}
@@ -0,0 +1,131 @@
+#include "render_queue.h"
+#include <algorithm>
+
+const char* renderPassName(RenderPass pass) {
+    switch (pass) {
+    case RenderPass::Marbles:   return "marbles";
+    case RenderPass::Track:     return "track";
+    case RenderPass::Obstacles: return "obstacles";
+    case RenderPass::Sky:       return "skybox";
+    case RenderPass::Count:     break;
+    }
+    return "?";
+}
+
+void RenderQueue::begin(const glm::vec3& cameraPos) {
+    camera = cameraPos;
+    packets.clear();
+}
+
+void RenderQueue::flush(GpuTimer* timer) {
+    frameStats = RenderStats();
+
+    // Sort indices rather than the packets themselves, which carry a matrix each
+    order.resize(packets.size());
+    for (uint32_t i = 0; i < (uint32_t)packets.size(); ++i)
+        order[i] = i;
+
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        const DrawPacket& pa = packets[a];
+        const DrawPacket& pb = packets[b];
+        if (pa.layer != pb.layer) return pa.layer < pb.layer;
+        if (pa.pass != pb.pass) return pa.pass < pb.pass;
+        GLuint progA = pa.program->id(), progB = pb.program->id();
+        if (progA != progB) return progA < progB;
+        if (pa.depth != pb.depth) return pa.depth < pb.depth;
+        if (pa.vao != pb.vao) return pa.vao < pb.vao;
+        return pa.material < pb.material;
+    });
+
+    // Bound state is unknown at the start of the frame, so the first packet sets everything
+    const ShaderProgram* program = nullptr;
+    GLuint vao = 0;
+    bool vaoKnown = false;
+    const Material* material = nullptr;
+    GLenum depthFunc = GL_LESS;
+    glDepthFunc(depthFunc);
+
+    bool timing = false;
+    RenderPass pass = RenderPass::Count;
+
+    for (uint32_t i : order) {
+        const DrawPacket& p = packets[i];
+
+        if (timer && (!timing || p.pass != pass)) {
+            timer->beginPass((int)p.pass);
+            pass = p.pass;
+            timing = true;
+        }
+
+        if (!program || p.program->id() != program->id()) {
+            p.program->use();
+            ++frameStats.programChanges;
+        }
+        program = p.program;
+
+        if (!vaoKnown || p.vao != vao) {
+            glBindVertexArray(p.vao);
+            vao = p.vao;
+            vaoKnown = true;
+            ++frameStats.vaoChanges;
+        }
+
+        // Material: texture binding and depth function; no material means GL_LESS
+        if (p.material != material) {
+            const Material* m = p.material;
+            bool sameTexture = m && material && m->textureTarget == material->textureTarget &&
+                               m->texture == material->texture && m->textureUnit == material->textureUnit;
+            if (m && m->textureTarget && !sameTexture) {
+                glActiveTexture(GL_TEXTURE0 + m->textureUnit);
+                glBindTexture(m->textureTarget, m->texture);
+                glActiveTexture(GL_TEXTURE0);
+            }
+
+            GLenum func = m ? m->depthFunc : GL_LESS;
+            if (func != depthFunc) {
+                depthFunc = func;
+                glDepthFunc(depthFunc);
+            }
+
+            material = m;
+            ++frameStats.materialChanges;
+        }
+
+        if (p.hasModel) {
+            p.program->set("model", p.model);
+            ++frameStats.uniformUploads;
+        }
+
+        issue(p.command);
+        ++frameStats.draws;
+    }
+
+    if (timing)
+        timer->endPass();
+
+    glBindVertexArray(0);
+    if (depthFunc != GL_LESS)
+        glDepthFunc(GL_LESS);
+    packets.clear();
+}
+
+void RenderQueue::issue(const DrawCommand& c) {
+    switch (c.kind) {
+    case DrawKind::Arrays:
+        glDrawArrays(c.mode, c.first, c.count);
+        break;
+    case DrawKind::Elements:
+        glDrawElements(c.mode, c.count, c.indexType, c.indexOffset);
+        break;
+    case DrawKind::ArraysInstanced:
+        glDrawArraysInstanced(c.mode, c.first, c.count, c.instanceCount);
+        break;
+    case DrawKind::ElementsInstanced:
+        glDrawElementsInstanced(c.mode, c.count, c.indexType, c.indexOffset, c.instanceCount);
+        break;
+    case DrawKind::MultiElementsBaseVertex:
+        glMultiDrawElementsBaseVertex(c.mode, c.counts, c.indexType, c.offsets, c.drawCount,
+                                      const_cast<GLint*>(c.baseVertices));
+        break;
+    }
+}
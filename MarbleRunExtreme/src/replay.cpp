@@ -0,0 +1,66 @@
+#include "replay.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const uint8_t REPLAY_VERSION = 1;
+
+ReplayRecorder::ReplayRecorder(int marbleCount, float tickRate, float positionStep)
+    : marbleCount(marbleCount), positionStep(positionStep), previous(marbleCount * 3, 0)
+{
+    const char magic[4] = { 'M', 'R', 'R', 'P' };
+    data.assign(magic, magic + 4);
+    data.push_back(REPLAY_VERSION);
+    writeVarint((uint64_t)marbleCount);
+    writeFloat(tickRate);
+    writeFloat(positionStep);
+}
+
+void ReplayRecorder::recordFrame(const std::vector<MarbleEntity>& marbles) {
+    for (int i = 0; i < marbleCount; ++i)
+        writePosition(i, marbles[i].renderable.position);
+    ++frames;
+}
+
+void ReplayRecorder::recordFrame(const std::vector<glm::vec3>& positions) {
+    for (int i = 0; i < marbleCount; ++i)
+        writePosition(i, positions[i]);
+    ++frames;
+}
+
+bool ReplayRecorder::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open replay file: " << path << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
+    return (bool)file;
+}
+
+void ReplayRecorder::writeVarint(uint64_t v) {
+    while (v >= 0x80) {
+        data.push_back(uint8_t(v) | 0x80);
+        v >>= 7;
+    }
+    data.push_back(uint8_t(v));
+}
+
+void ReplayRecorder::writeFloat(float f) {
+    uint8_t bytes[4];
+    std::memcpy(bytes, &f, 4);
+    data.insert(data.end(), bytes, bytes + 4);
+}
+
+void ReplayRecorder::writePosition(int marble, const glm::vec3& p) {
+    int32_t* prev = &previous[marble * 3];
+    for (int axis = 0; axis < 3; ++axis) {
+        int32_t q = (int32_t)std::lround(p[axis] / positionStep);
+        int64_t delta = (int64_t)q - prev[axis];
+        prev[axis] = q;
+
+        // Zigzag so small negative deltas stay small
+        writeVarint((uint64_t)((delta << 1) ^ (delta >> 63)));
+    }
+}
@@ -0,0 +1,79 @@
+#include "shader_program.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <vector>
+
+ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath,
+                             const std::vector<std::string>& sharedFragmentPaths)
+    : program(createShaderProgram(vertexPath, fragmentPath, sharedFragmentPaths))
+{
+    reflect();
+}
+
+ShaderProgram::ShaderProgram(const ShaderSources& sources)
+    : program(createShaderProgram(sources))
+{
+    reflect();
+}
+
+void ShaderProgram::reflect() {
+    uniforms.clear();
+    if (!program) return;
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<char> nameBuf(maxLength > 0 ? maxLength : 1);
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, (GLuint)i, (GLsizei)nameBuf.size(), &length, &size, &type, nameBuf.data());
+
+        std::string name(nameBuf.data(), length);
+        GLint location = glGetUniformLocation(program, name.c_str());
+        if (location < 0) continue; // block members have no location
+
+        // Arrays are reported as "name[0]"; allow lookup by the bare name too
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            uniforms[name.substr(0, name.size() - 3)] = location;
+        uniforms[name] = location;
+    }
+
+    GLuint frameBlock = glGetUniformBlockIndex(program, "FrameData");
+    if (frameBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, frameBlock, FRAME_UNIFORM_BINDING);
+}
+
+GLint ShaderProgram::uniform(const std::string& name) const {
+    auto it = uniforms.find(name);
+    return it != uniforms.end() ? it->second : -1;
+}
+
+void ShaderProgram::set(const std::string& name, int value) const {
+    glUniform1i(uniform(name), value);
+}
+
+void ShaderProgram::set(const std::string& name, const glm::vec3& value) const {
+    glUniform3fv(uniform(name), 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::set(const std::string& name, const glm::mat4& value) const {
+    glUniformMatrix4fv(uniform(name), 1, GL_FALSE, glm::value_ptr(value));
+}
+
+FrameUniformBuffer::FrameUniformBuffer()
+    : UBO(GlBuffer::create())
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, UBO);
+}
+
+void FrameUniformBuffer::update(const FrameUniforms& data) {
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, UBO);
+}
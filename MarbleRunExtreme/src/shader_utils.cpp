@@ -1,4 +1,7 @@
 #include "shader_utils.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -16,47 +19,217 @@ std::string loadShaderSource(const std::string& filePath)
     return buffer.str();
 }
 
-GLuint createShaderProgram(const std::string& vertexPath, const std::string& fragmentPath)
+ShaderSources loadShaderSources(const std::string& vertexPath, const std::string& fragmentPath,
+                                const std::vector<std::string>& sharedFragmentPaths)
 {
-    std::string vertexCode = loadShaderSource(vertexPath);
-    std::string fragmentCode = loadShaderSource(fragmentPath);
+    ShaderSources sources;
+    sources.vertex = { vertexPath, loadShaderSource(vertexPath) };
+    sources.fragment = { fragmentPath, loadShaderSource(fragmentPath) };
+    for (const auto& path : sharedFragmentPaths)
+        sources.sharedFragments.push_back({ path, loadShaderSource(path) });
+    return sources;
+}
 
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+static GLuint compileShader(GLenum type, const ShaderSources::Stage& stage)
+{
+    const char* codePtr = stage.code.c_str();
 
-    GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, nullptr);
-    glCompileShader(vertex);
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &codePtr, nullptr);
+    glCompileShader(shader);
 
     GLint success;
     char infoLog[512];
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success) {
-        glGetShaderInfoLog(vertex, 512, nullptr, infoLog);
-        std::cerr << "Vertex Shader compilation failed:\n" << infoLog << std::endl;
+        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+        std::cerr << (type == GL_VERTEX_SHADER ? "Vertex" : "Fragment")
+                  << " Shader compilation failed (" << stage.path << "):\n" << infoLog << std::endl;
     }
+    return shader;
+}
 
-    GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, nullptr);
-    glCompileShader(fragment);
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragment, 512, nullptr, infoLog);
-        std::cerr << "Fragment Shader compilation failed:\n" << infoLog << std::endl;
-    }
+GLuint createShaderProgram(const std::string& vertexPath, const std::string& fragmentPath,
+                           const std::vector<std::string>& sharedFragmentPaths)
+{
+    return createShaderProgram(loadShaderSources(vertexPath, fragmentPath, sharedFragmentPaths));
+}
+
+static GLuint compileAndLink(const ShaderSources& sources, bool retrievable)
+{
+    std::vector<GLuint> shaders;
+    shaders.push_back(compileShader(GL_VERTEX_SHADER, sources.vertex));
+    shaders.push_back(compileShader(GL_FRAGMENT_SHADER, sources.fragment));
+    for (const auto& stage : sources.sharedFragments)
+        shaders.push_back(compileShader(GL_FRAGMENT_SHADER, stage));
 
     GLuint program = glCreateProgram();
-    glAttachShader(program, vertex);
-    glAttachShader(program, fragment);
+    for (GLuint shader : shaders)
+        glAttachShader(program, shader);
+    if (retrievable)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(program);
+
+    GLint success;
+    char infoLog[512];
     glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success) {
         glGetProgramInfoLog(program, 512, nullptr, infoLog);
         std::cerr << "Shader Program linking failed:\n" << infoLog << std::endl;
     }
 
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    // Detached so the shader objects are freed now rather than with the program
+    for (GLuint shader : shaders) {
+        glDetachShader(program, shader);
+        glDeleteShader(shader);
+    }
 
     return program;
 }
+
+// ---------------- Program binary cache ----------------
+
+static std::string cacheDir = "shader_cache";
+static ProgramCacheStats cacheStats;
+
+void setProgramCacheDir(const std::string& dir) { cacheDir = dir; }
+const std::string& programCacheDir() { return cacheDir; }
+const ProgramCacheStats& programCacheStats() { return cacheStats; }
+
+static const char PROGRAM_BINARY_MAGIC[4] = { 'M', 'R', 'P', 'B' };
+static const uint32_t PROGRAM_BINARY_VERSION = 1;
+
+struct ProgramBinaryHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;               // repeated from the file name to catch renames
+    uint32_t format;            // from glGetProgramBinary
+    uint32_t length;            // bytes of binary after the header
+};
+
+// FNV-1a, with a terminator so ("ab", "c") and ("a", "bc") differ
+static uint64_t hashString(uint64_t h, const std::string& s) {
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    h ^= 0xFF;
+    h *= 1099511628211ull;
+    return h;
+}
+
+static std::string glString(GLenum name) {
+    const GLubyte* s = glGetString(name);
+    return s ? (const char*)s : "";
+}
+
+static uint64_t programCacheKey(const ShaderSources& sources) {
+    uint64_t h = 14695981039346656037ull;
+    h = hashString(h, glString(GL_VENDOR));
+    h = hashString(h, glString(GL_RENDERER));
+    h = hashString(h, glString(GL_VERSION));
+    h = hashString(h, sources.vertex.code);
+    h = hashString(h, sources.fragment.code);
+    for (const auto& stage : sources.sharedFragments)
+        h = hashString(h, stage.code);
+    return h;
+}
+
+static std::string programCachePath(uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return (std::filesystem::path(cacheDir) / name).string();
+}
+
+// 0 if there is no usable entry
+static GLuint loadCachedProgram(uint64_t key) {
+    std::ifstream file(programCachePath(key), std::ios::binary);
+    if (!file.is_open()) return 0;
+
+    ProgramBinaryHeader header;
+    if (!file.read((char*)&header, sizeof(header))) return 0;
+    if (std::memcmp(header.magic, PROGRAM_BINARY_MAGIC, 4) != 0 ||
+        header.version != PROGRAM_BINARY_VERSION || header.key != key || header.length == 0)
+        return 0;
+
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size())) return 0;
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glDeleteProgram(program);
+        while (glGetError() != GL_NO_ERROR) {}  // an unknown format is also an error
+        ++cacheStats.rejected;
+        return 0;
+    }
+    return program;
+}
+
+static void storeCachedProgram(uint64_t key, GLuint program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    if (length <= 0) return;
+
+    ProgramBinaryHeader header;
+    std::memcpy(header.magic, PROGRAM_BINARY_MAGIC, 4);
+    header.version = PROGRAM_BINARY_VERSION;
+    header.key = key;
+    header.format = format;
+    header.length = (uint32_t)length;
+
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir, ec);
+
+    // Write then rename, so a crash never leaves a half-written entry
+    std::string path = programCachePath(key);
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        if (!file.is_open()) return;
+        file.write((const char*)&header, sizeof(header));
+        file.write(binary.data(), length);
+        if (!file) return;
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return;
+    }
+    ++cacheStats.stores;
+}
+
+static bool programBinariesSupported() {
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+GLuint createShaderProgram(const ShaderSources& sources)
+{
+    if (cacheDir.empty() || !programBinariesSupported())
+        return compileAndLink(sources, false);
+
+    uint64_t key = programCacheKey(sources);
+    if (GLuint program = loadCachedProgram(key)) {
+        ++cacheStats.hits;
+        return program;
+    }
+
+    ++cacheStats.misses;
+    GLuint program = compileAndLink(sources, true);
+
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success)
+        storeCachedProgram(key, program);
+    return program;
+}
@@ -1,8 +1,7 @@
 #include "skybox.h"
-#include <glm/gtc/type_ptr.hpp>
+#include "cubemap_cache.h"
 #include <iostream>
 
-#define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 static float skyboxVertices[] = {
@@ -20,33 +19,70 @@ static float skyboxVertices[] = {
      1.0f, -1.0f, -1.0f,  -1.0f, -1.0f,  1.0f,   1.0f, -1.0f,  1.0f
 };
 
+// Upload every level and face of a cubemap in the cache layout
+static GlTexture uploadCubemap(const CubemapView& cubemap, size_t& bytes) {
+    GlTexture texture = GlTexture::create();
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+
+    // Faces are tightly packed RGB, so rows are not 4-byte aligned below 4x4
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int level = 0; level < cubemap.mipCount; ++level) {
+        int size = cubemap.levelSize(level);
+        for (int face = 0; face < 6; ++face) {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB, size, size, 0,
+                         GL_RGB, GL_UNSIGNED_BYTE, cubemap.face(level, face));
+            bytes += (size_t)size * size * 3;
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, cubemap.mipCount - 1);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
 Skybox::Skybox(const std::string& atlasPath) {
     cubemapTexture = loadCubemapFromAtlas(atlasPath);
+    createGeometry();
+}
+
+Skybox::Skybox(const CubemapView& cubemap) {
+    if (cubemap.payload)
+        cubemapTexture = uploadCubemap(cubemap, textureBytes);
+    createGeometry();
+}
+
+void Skybox::createGeometry() {
+    material.textureTarget = GL_TEXTURE_CUBE_MAP;
+    material.texture = cubemapTexture;
+    material.textureUnit = 0;
+    material.depthFunc = GL_LEQUAL;
 
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+    VAO = GlVertexArray::create();
+    VBO = GlBuffer::create();
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW);
+    vertexBytes = sizeof(skyboxVertices);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 }
 
-Skybox::~Skybox() {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-}
-
-GLuint Skybox::loadCubemap(const std::vector<std::string>& faces) {
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+GlTexture Skybox::loadCubemap(const std::vector<std::string>& faces) {
+    GlTexture texture = GlTexture::create();
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
 
     int width, height, nrChannels;
     for (GLuint i = 0; i < faces.size(); i++) {
         unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
         if (data) {
             glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+            textureBytes += (size_t)width * height * 3;
             stbi_image_free(data);
         } else {
             std::cerr << "Failed to load cubemap face: " << faces[i] << std::endl;
@@ -60,79 +96,24 @@ GLuint Skybox::loadCubemap(const std::vector<std::string>& faces) {
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
-    return textureID;
+    return texture;
 }
 
-void Skybox::draw(const glm::mat4& view, const glm::mat4& projection, GLuint shaderProgram) {
-    glDepthFunc(GL_LEQUAL);
-    glUseProgram(shaderProgram);
-
-    glm::mat4 viewNoTrans = glm::mat4(glm::mat3(view));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(viewNoTrans));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-
-    glBindVertexArray(VAO);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glDepthFunc(GL_LESS);
+void Skybox::submit(RenderQueue& queue, const ShaderProgram& shader) {
+    DrawPacket packet;
+    packet.program = &shader;
+    packet.vao = VAO;
+    packet.material = &material;
+    packet.layer = RenderLayer::Sky;
+    packet.pass = RenderPass::Sky;
+    packet.command.kind = DrawKind::Arrays;
+    packet.command.count = 36;
+    queue.submit(packet);
 }
 
-GLuint Skybox::loadCubemapFromAtlas(const std::string& atlasPath) {
-    int width, height, channels;
-    unsigned char* data = stbi_load(atlasPath.c_str(), &width, &height, &channels, 3);
-    if (!data) {
-        std::cerr << "Failed to load atlas: " << atlasPath << std::endl;
-        return 0;
-    }
-
-    // Calculate each face’s size
-    int faceSize = width / 4; // assuming 4 faces horizontally
-    if (height != 3 * faceSize) {
-        std::cerr << "Unexpected atlas aspect ratio!" << std::endl;
-        stbi_image_free(data);
-        return 0;
-    }
-
-    auto getFace = [&](int x, int y) -> std::vector<unsigned char> {
-        std::vector<unsigned char> face(faceSize * faceSize * 3);
-        for (int row = 0; row < faceSize; ++row) {
-            int srcY = y * faceSize + row;
-            int dstY = row;
-            memcpy(
-                &face[dstY * faceSize * 3],
-                &data[(srcY * width + x * faceSize) * 3],
-                faceSize * 3
-            );
-        }
-        return face;
-    };
-
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    // Extract faces based on the standard cross layout
-    auto posX = getFace(2, 1);
-    auto negX = getFace(0, 1);
-    auto posY = getFace(1, 0);
-    auto negY = getFace(1, 2);
-    auto posZ = getFace(1, 1);
-    auto negZ = getFace(3, 1);
-
-    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_RGB, faceSize, faceSize, 0, GL_RGB, GL_UNSIGNED_BYTE, posX.data());
-    glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_X, 0, GL_RGB, faceSize, faceSize, 0, GL_RGB, GL_UNSIGNED_BYTE, negX.data());
-    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Y, 0, GL_RGB, faceSize, faceSize, 0, GL_RGB, GL_UNSIGNED_BYTE, posY.data());
-    glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, 0, GL_RGB, faceSize, faceSize, 0, GL_RGB, GL_UNSIGNED_BYTE, negY.data());
-    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Z, 0, GL_RGB, faceSize, faceSize, 0, GL_RGB, GL_UNSIGNED_BYTE, posZ.data());
-    glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, 0, GL_RGB, faceSize, faceSize, 0, GL_RGB, GL_UNSIGNED_BYTE, negZ.data());
-
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    stbi_image_free(data);
-    return textureID;
+GlTexture Skybox::loadCubemapFromAtlas(const std::string& atlasPath) {
+    LoadedCubemap cubemap;
+    if (!::loadCubemap(atlasPath, cubemap))
+        return GlTexture();
+    return uploadCubemap(cubemap.view(), textureBytes);
 }
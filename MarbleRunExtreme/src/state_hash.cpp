@@ -0,0 +1,35 @@
+#include "state_hash.h"
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+std::string formatStateHash(uint64_t hash) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016" PRIx64, hash);
+    return text;
+}
+
+bool loadStateHashLog(const std::string& path, std::vector<uint64_t>& hashes) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Failed to open hash log " << path << "\n";
+        return false;
+    }
+
+    hashes.clear();
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        long tick = 0;
+        std::string hex;
+        if (!(fields >> tick >> hex)) continue;
+        if (tick != (long)hashes.size()) {
+            std::cerr << "Hash log " << path << " skips from tick " << hashes.size() << " to " << tick << "\n";
+            return false;
+        }
+        hashes.push_back(std::strtoull(hex.c_str(), nullptr, 16));
+    }
+    return true;
+}
@@ -0,0 +1,119 @@
+#include "stream_buffer.h"
+#include <algorithm>
+#include <iostream>
+
+StreamBuffer::StreamBuffer(size_t bytesPerFrame, StreamMode requested, int frames)
+    : mode(requested), regionSize(std::max<size_t>(bytesPerFrame, 256)),
+      frameCount(std::max(1, frames)), fences(frameCount, nullptr)
+{
+    if (mode == StreamMode::Auto)
+        mode = (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) ? StreamMode::Persistent : StreamMode::Orphaning;
+    create();
+}
+
+StreamBuffer::~StreamBuffer() {
+    destroy();
+}
+
+void StreamBuffer::create() {
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (mode == StreamMode::Persistent) {
+        size_t size = regionSize * frameCount;
+        glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+        persistentBase = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+        if (!persistentBase) {
+            std::cerr << "StreamBuffer: persistent mapping failed, falling back to orphaning\n";
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glDeleteBuffers(1, &buffer);
+            mode = StreamMode::Orphaning;
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        }
+    }
+    if (mode == StreamMode::Orphaning)
+        glBufferData(GL_ARRAY_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamBuffer::destroy() {
+    for (GLsync& fence : fences)
+        wait(fence);
+    if (buffer && (persistentBase || frameBase)) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    persistentBase = frameBase = nullptr;
+    region = -1;
+}
+
+void StreamBuffer::wait(GLsync& fence) {
+    if (!fence) return;
+
+    // Poll first so only real waits count as stalls
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        ++stalls;
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while (status == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void StreamBuffer::beginFrame(size_t bytes) {
+    if (bytes > regionSize) {
+        destroy();
+        regionSize = std::max(bytes, regionSize * 2);
+        create();
+    }
+
+    region = (region + 1) % frameCount;
+    cursor = 0;
+
+    if (mode == StreamMode::Persistent) {
+        wait(fences[region]);
+        frameOffset = (size_t)region * regionSize;
+        frameBase = persistentBase + frameOffset;
+    } else {
+        frameOffset = 0;
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        frameBase = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, regionSize,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void* StreamBuffer::allocate(size_t bytes, size_t alignment, size_t& offset) {
+    if (!frameBase) return nullptr;
+
+    size_t start = (cursor + alignment - 1) / alignment * alignment;
+    if (start + bytes > regionSize) return nullptr;
+
+    cursor = start + bytes;
+    offset = frameOffset + start;
+    return frameBase + start;
+}
+
+void StreamBuffer::flush() {
+    // Coherent persistent writes are seen by GL as they happen; a
+    // regular mapping has to be closed before anything draws from it
+    if (mode == StreamMode::Orphaning && frameBase) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    frameBase = nullptr;
+}
+
+void StreamBuffer::endFrame() {
+    flush();
+    if (mode == StreamMode::Persistent && region >= 0)
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,161 @@
+#include "task_graph.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+TaskGraph::TaskGraph(int workerCount)
+    : workerCount(workerCount)
+{
+    if (this->workerCount <= 0)
+        this->workerCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+}
+
+TaskGraph::~TaskGraph() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workerWake.notify_all();
+    for (auto& t : workers)
+        t.join();
+}
+
+TaskGraph::TaskId TaskGraph::add(const std::string& name, std::function<void()> work,
+                                 const std::vector<TaskId>& dependencies, TaskThread thread) {
+    if (started) {
+        std::cerr << "TaskGraph: cannot add '" << name << "' after start()\n";
+        return -1;
+    }
+
+    TaskId id = (TaskId)tasks.size();
+    Task task;
+    task.name = name;
+    task.work = std::move(work);
+    task.thread = thread;
+    for (TaskId dep : dependencies) {
+        if (dep < 0 || dep >= id) continue;     // only earlier tasks, so no cycles
+        tasks[dep].dependents.push_back(id);
+        ++task.pendingDependencies;
+    }
+    tasks.push_back(std::move(task));
+    return id;
+}
+
+void TaskGraph::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (started) return;
+    started = true;
+    startTime = Clock::now();
+
+    for (TaskId id = 0; id < (TaskId)tasks.size(); ++id) {
+        if (tasks[id].pendingDependencies == 0)
+            enqueueLocked(id);
+    }
+
+    for (int i = 0; i < workerCount; ++i)
+        workers.emplace_back(&TaskGraph::workerLoop, this);
+}
+
+void TaskGraph::enqueueLocked(TaskId id) {
+    if (tasks[id].thread == TaskThread::Main) {
+        mainQueue.push_back(id);
+        mainWake.notify_all();
+    } else {
+        workerQueue.push_back(id);
+        workerWake.notify_one();
+    }
+}
+
+double TaskGraph::msSinceStart() const {
+    return std::chrono::duration<double, std::milli>(Clock::now() - startTime).count();
+}
+
+void TaskGraph::run(TaskId id) {
+    Task& task = tasks[id];
+    double begin = msSinceStart();
+    task.work();
+    double end = msSinceStart();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    task.startMs = begin;
+    task.endMs = end;
+    task.done = true;
+    ++doneCount;
+    for (TaskId next : task.dependents) {
+        if (--tasks[next].pendingDependencies == 0)
+            enqueueLocked(next);
+    }
+    mainWake.notify_all();
+}
+
+void TaskGraph::workerLoop() {
+    for (;;) {
+        TaskId id;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workerWake.wait(lock, [&] { return stopping || !workerQueue.empty(); });
+            if (stopping) return;
+            id = workerQueue.front();
+            workerQueue.pop_front();
+        }
+        run(id);
+    }
+}
+
+int TaskGraph::runMainThreadTasks(double budgetMs) {
+    auto begin = Clock::now();
+    int ran = 0;
+    for (;;) {
+        TaskId id;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (mainQueue.empty()) break;
+            id = mainQueue.front();
+            mainQueue.pop_front();
+        }
+        run(id);
+        ++ran;
+
+        double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+        if (elapsed >= budgetMs) break;
+    }
+    return ran;
+}
+
+void TaskGraph::wait() {
+    for (;;) {
+        runMainThreadTasks(1e9);
+        std::unique_lock<std::mutex> lock(mutex);
+        if (doneCount == (int)tasks.size()) return;
+        mainWake.wait(lock, [&] { return !mainQueue.empty() || doneCount == (int)tasks.size(); });
+    }
+}
+
+bool TaskGraph::finished(TaskId id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return id >= 0 && id < (TaskId)tasks.size() && tasks[id].done;
+}
+
+bool TaskGraph::allFinished() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return doneCount == (int)tasks.size();
+}
+
+int TaskGraph::finishedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return doneCount;
+}
+
+void TaskGraph::report(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const Task& task : tasks) {
+        out << "  " << std::left << std::setw(24) << task.name
+            << (task.thread == TaskThread::Main ? " main  " : " worker")
+            << std::right << std::fixed << std::setprecision(1);
+        if (task.done)
+            out << std::setw(9) << task.startMs << " -> " << std::setw(7) << task.endMs << " ms\n";
+        else
+            out << "  not run\n";
+    }
+    out.unsetf(std::ios::floatfield);
+}
@@ -0,0 +1,162 @@
+#include "text_overlay.h"
+#include <algorithm>
+#include <cctype>
+
+// Glyph cells are 6x8 font pixels: 5x7 of glyph plus spacing
+static const int CELL_WIDTH = 6, CELL_HEIGHT = 8;
+// Glyph i in the font texture is ASCII 32 + i; 32..95 covers digits, upper case and punctuation
+static const int FIRST_CHAR = 32, GLYPH_COUNT = 64;
+
+struct Glyph {
+    char c;
+    uint8_t rows[7];    // top to bottom, bit 4 = leftmost pixel
+};
+
+static const Glyph FONT[] = {
+    { '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+    { '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+    { '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+    { '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+    { '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+    { '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+    { '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+    { '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+    { '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+    { '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+    { 'A', { 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 } },
+    { 'B', { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E } },
+    { 'C', { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E } },
+    { 'D', { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C } },
+    { 'E', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F } },
+    { 'F', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 } },
+    { 'G', { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F } },
+    { 'H', { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+    { 'I', { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+    { 'J', { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C } },
+    { 'K', { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 } },
+    { 'L', { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F } },
+    { 'M', { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 } },
+    { 'N', { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 } },
+    { 'O', { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+    { 'P', { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } },
+    { 'Q', { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D } },
+    { 'R', { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 } },
+    { 'S', { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E } },
+    { 'T', { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 } },
+    { 'U', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+    { 'V', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 } },
+    { 'W', { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A } },
+    { 'X', { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 } },
+    { 'Y', { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 } },
+    { 'Z', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F } },
+    { '.', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C } },
+    { ',', { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 } },
+    { ':', { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 } },
+    { '-', { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+    { '+', { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 } },
+    { '=', { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 } },
+    { '/', { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 } },
+    { '%', { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 } },
+    { '(', { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 } },
+    { ')', { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 } },
+    { '[', { 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E } },
+    { ']', { 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E } },
+    { '_', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F } },
+};
+
+TextOverlay::TextOverlay() {
+    // One row of glyph cells, 255 where a pixel is set
+    std::vector<uint8_t> pixels(GLYPH_COUNT * CELL_WIDTH * CELL_HEIGHT, 0);
+    int texWidth = GLYPH_COUNT * CELL_WIDTH;
+    for (const Glyph& g : FONT) {
+        int index = g.c - FIRST_CHAR;
+        for (int y = 0; y < 7; ++y)
+            for (int x = 0; x < 5; ++x)
+                if (g.rows[y] & (0x10 >> x))
+                    pixels[y * texWidth + index * CELL_WIDTH + x] = 255;
+    }
+
+    fontTexture = GlTexture::create();
+    glBindTexture(GL_TEXTURE_2D, fontTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, texWidth, CELL_HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    const float corners[] = { 0.0f, 0.0f,  1.0f, 0.0f,  0.0f, 1.0f,  1.0f, 1.0f };
+
+    VAO = GlVertexArray::create();
+    quadVBO = GlBuffer::create();
+    instanceVBO = GlBuffer::create();
+
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Per glyph: column, row, glyph index (location 1)
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TextOverlay::setText(const std::vector<std::string>& lines) {
+    std::vector<glm::vec3> glyphs;
+    columns = 0;
+    rows = (int)lines.size();
+    for (int row = 0; row < rows; ++row) {
+        const std::string& line = lines[row];
+        columns = std::max(columns, (int)line.size());
+        for (int col = 0; col < (int)line.size(); ++col) {
+            int c = std::toupper((unsigned char)line[col]);
+            if (c <= FIRST_CHAR || c >= FIRST_CHAR + GLYPH_COUNT) continue;    // spaces and unknowns stay blank
+            glyphs.push_back(glm::vec3((float)col, (float)row, (float)(c - FIRST_CHAR)));
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    if (glyphs.size() > instanceCapacity) {
+        instanceCapacity = glyphs.size();
+        glBufferData(GL_ARRAY_BUFFER, glyphs.size() * sizeof(glm::vec3), glyphs.data(), GL_DYNAMIC_DRAW);
+    } else if (!glyphs.empty()) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, glyphs.size() * sizeof(glm::vec3), glyphs.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glyphCount = (GLsizei)glyphs.size();
+}
+
+void TextOverlay::draw(const ShaderProgram& shader, int screenWidth, int screenHeight) const {
+    if (rows == 0) return;
+
+    // Panel behind the text, with a cell of margin
+    int cellW = CELL_WIDTH * scale, cellH = CELL_HEIGHT * scale;
+    int panelW = (columns + 2) * cellW, panelH = (rows + 2) * cellH;
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, screenHeight - panelH, panelW, panelH);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+
+    if (glyphCount == 0) return;
+
+    glDisable(GL_DEPTH_TEST);
+    shader.use();
+    shader.set("screenSize", glm::vec3((float)screenWidth, (float)screenHeight, (float)scale));
+    glActiveTexture(GL_TEXTURE0 + TEXT_FONT_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, fontTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindVertexArray(VAO);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, glyphCount);
+    glBindVertexArray(0);
+    glEnable(GL_DEPTH_TEST);
+}
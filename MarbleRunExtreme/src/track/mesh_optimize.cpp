@@ -0,0 +1,165 @@
+#include "mesh_optimize.h"
+#include <cmath>
+
+static float vertexScore(int cachePosition, unsigned int remainingTriangles) {
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        // The last triangle's vertices get a fixed score so it isn't re-used straight away
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - float(cachePosition - 3) / float(VERTEX_CACHE_SIZE - 3), 1.5f);
+    }
+
+    // Prefer vertices with few triangles left, to finish them off
+    score += 2.0f / std::sqrt(float(remainingTriangles));
+    return score;
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount) {
+    const size_t triCount = indices.size() / 3;
+    if (triCount == 0 || vertexCount == 0) return;
+
+    // Vertex -> triangle adjacency, packed per vertex
+    std::vector<unsigned int> adjOffset(vertexCount + 1, 0);
+    for (unsigned int v : indices)
+        adjOffset[v + 1]++;
+    for (size_t v = 0; v < vertexCount; ++v)
+        adjOffset[v + 1] += adjOffset[v];
+
+    std::vector<unsigned int> adjTris(indices.size());
+    std::vector<unsigned int> fill(adjOffset.begin(), adjOffset.end() - 1);
+    for (size_t t = 0; t < triCount; ++t)
+        for (int k = 0; k < 3; ++k)
+            adjTris[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+
+    std::vector<unsigned int> remaining(vertexCount);
+    std::vector<int> cachePos(vertexCount, -1);
+    std::vector<float> vScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        remaining[v] = adjOffset[v + 1] - adjOffset[v];
+        vScore[v] = vertexScore(-1, remaining[v]);
+    }
+
+    std::vector<float> tScore(triCount);
+    std::vector<char> emitted(triCount, 0);
+    int best = -1;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < triCount; ++t) {
+        tScore[t] = vScore[indices[t * 3]] + vScore[indices[t * 3 + 1]] + vScore[indices[t * 3 + 2]];
+        if (tScore[t] > bestScore) {
+            bestScore = tScore[t];
+            best = (int)t;
+        }
+    }
+
+    std::vector<unsigned int> out;
+    out.reserve(indices.size());
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(VERTEX_CACHE_SIZE + 3);
+    nextCache.reserve(VERTEX_CACHE_SIZE + 3);
+    size_t scanCursor = 0;
+
+    while (best >= 0) {
+        emitted[best] = 1;
+        const unsigned int* tri = &indices[(size_t)best * 3];
+
+        // Emit, and drop the triangle from its vertices' active lists
+        for (int k = 0; k < 3; ++k) {
+            unsigned int v = tri[k];
+            out.push_back(v);
+
+            unsigned int* list = &adjTris[adjOffset[v]];
+            for (unsigned int i = 0; i < remaining[v]; ++i) {
+                if (list[i] == (unsigned int)best) {
+                    list[i] = list[remaining[v] - 1];
+                    break;
+                }
+            }
+            remaining[v]--;
+        }
+
+        // LRU cache update: this triangle's vertices move to the front
+        nextCache.assign(tri, tri + 3);
+        for (unsigned int v : cache)
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                nextCache.push_back(v);
+
+        for (size_t i = 0; i < nextCache.size(); ++i) {
+            unsigned int v = nextCache[i];
+            cachePos[v] = i < (size_t)VERTEX_CACHE_SIZE ? (int)i : -1;
+            vScore[v] = vertexScore(cachePos[v], remaining[v]);
+        }
+
+        // Rescore triangles touching the cache; the next pick comes from those still in it
+        best = -1;
+        bestScore = -1.0f;
+        for (size_t i = 0; i < nextCache.size(); ++i) {
+            unsigned int v = nextCache[i];
+            const unsigned int* list = &adjTris[adjOffset[v]];
+            for (unsigned int j = 0; j < remaining[v]; ++j) {
+                unsigned int t = list[j];
+                tScore[t] = vScore[indices[t * 3]] + vScore[indices[t * 3 + 1]] + vScore[indices[t * 3 + 2]];
+                if (i < (size_t)VERTEX_CACHE_SIZE && tScore[t] > bestScore) {
+                    bestScore = tScore[t];
+                    best = (int)t;
+                }
+            }
+        }
+
+        if (nextCache.size() > (size_t)VERTEX_CACHE_SIZE)
+            nextCache.resize(VERTEX_CACHE_SIZE);
+        cache.swap(nextCache);
+
+        // Nothing connected left in the cache: continue with the next unused triangle
+        if (best < 0) {
+            while (scanCursor < triCount && emitted[scanCursor])
+                ++scanCursor;
+            if (scanCursor < triCount)
+                best = (int)scanCursor;
+        }
+    }
+
+    indices.swap(out);
+}
+
+std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int>& indices, size_t vertexCount) {
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertexCount, unused);
+
+    unsigned int next = 0;
+    for (unsigned int& v : indices) {
+        if (remap[v] == unused)
+            remap[v] = next++;
+        v = remap[v];
+    }
+
+    // Unreferenced vertices go to the end
+    for (unsigned int& r : remap)
+        if (r == unused)
+            r = next++;
+
+    return remap;
+}
+
+float averageCacheMissRatio(const std::vector<unsigned int>& indices, size_t vertexCount, int cacheSize) {
+    size_t triCount = indices.size() / 3;
+    if (triCount == 0) return 0.0f;
+
+    // FIFO cache, stamped with the time each vertex entered it
+    std::vector<long> entered(vertexCount, -1);
+    long clock = 0;
+    size_t misses = 0;
+
+    for (unsigned int v : indices) {
+        if (entered[v] < 0 || clock - entered[v] >= cacheSize) {
+            entered[v] = clock++;
+            ++misses;
+        }
+    }
+
+    return float(misses) / float(triCount);
+}
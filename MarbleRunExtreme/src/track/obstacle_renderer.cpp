@@ -0,0 +1,64 @@
+#include "obstacle_renderer.h"
+#include <algorithm>
+#include <cmath>
+
+ObstacleRenderer::ObstacleRenderer(const CubeMesh& cube)
+    : VAO(GlVertexArray::create()), instanceVBO(GlBuffer::create())
+{
+    glBindVertexArray(VAO);
+    cube.bindVertexAttributes();
+
+    // Per-instance attributes (locations 2-4), advanced once per obstacle
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    for (GLuint i = 0; i < 3; ++i) {
+        GLuint loc = 2 + i;
+        glVertexAttribPointer(loc, 4, GL_FLOAT, GL_FALSE, sizeof(ObstacleInstance),
+                              (void*)(i * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(loc);
+        glVertexAttribDivisor(loc, 1);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ObstacleRenderer::build(const std::vector<Obstacle>& obstacles) {
+    std::vector<ObstacleInstance> instances;
+    instances.reserve(obstacles.size());
+    for (const Obstacle& o : obstacles) {
+        glm::quat q = o.box.rotation();
+
+        ObstacleInstance inst;
+        inst.position = glm::vec4(o.box.position(), 1.0f);
+        inst.rotation = glm::vec4(q.x, q.y, q.z, q.w);
+        inst.halfExtents = glm::vec4(o.box.renderable.size, 0.0f);
+        instances.push_back(inst);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(ObstacleInstance), instances.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    count = instances.size();
+}
+
+void ObstacleRenderer::submit(RenderQueue& queue, const ShaderProgram& shader,
+                              const std::vector<Obstacle>& obstacles, const std::vector<int>& visible) const {
+    if (count == 0 || visible.empty())
+        return;
+
+    float nearest = INFINITY;
+    for (int i : visible) {
+        const Aabb& b = obstacles[i].bounds;
+        nearest = std::min(nearest, queue.depthOf(0.5f * (b.min + b.max)));
+    }
+
+    DrawPacket packet;
+    packet.program = &shader;
+    packet.vao = VAO;
+    packet.depth = nearest;
+    packet.pass = RenderPass::Obstacles;
+    packet.command.kind = DrawKind::ArraysInstanced;
+    packet.command.count = CubeMesh::VERTEX_COUNT;
+    packet.command.instanceCount = (GLsizei)count;
+    queue.submit(packet);
+}
@@ -0,0 +1,562 @@
+#include "track_batch.h"
+#include "mesh_optimize.h"
+#include "track_lod.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <unordered_set>
+#include <glm/gtc/packing.hpp>
+
+static uint16_t quantize(float value, float min, float extent) {
+    if (extent <= 0.0f) return 0;
+    float t = glm::clamp((value - min) / extent, 0.0f, 1.0f);
+    return (uint16_t)std::lround(t * 65535.0f);
+}
+
+// Keys for segments without a usable id, only ever seen by a full build
+static const uint64_t ANONYMOUS_KEY = 1ull << 63;
+
+// Room left for edits and endless track when buffers are (re)allocated
+static size_t withSlack(size_t n, size_t minimum) {
+    return std::max(n + n / 2, minimum);
+}
+
+static void shiftRange(SegmentDrawRange& r, long vertices, long indices) {
+    r.baseVertex += (GLint)vertices;
+    r.firstIndex += indices;
+}
+
+static void shiftRanges(SegmentDrawRange& full, std::vector<ChunkDrawRanges>& chunks, long vertices, long indices) {
+    shiftRange(full, vertices, indices);
+    for (auto& c : chunks) {
+        for (auto& r : c.body) shiftRange(r, vertices, indices);
+        for (auto& level : c.startEdge)
+            for (auto& r : level) shiftRange(r, vertices, indices);
+        for (auto& level : c.endEdge)
+            for (auto& r : level) shiftRange(r, vertices, indices);
+    }
+}
+
+bool TrackBatch::hasUniqueIds(const Track& track) {
+    std::unordered_set<uint64_t> seen;
+    for (const auto& seg : track.segments)
+        if (seg.id == 0 || !seen.insert(seg.id).second)
+            return false;
+    return true;
+}
+
+TrackBatch::PackedSegment TrackBatch::pack(const TrackSegment& seg, uint64_t key) {
+    PackedSegment p;
+    p.key = key;
+    p.transform = seg.worldTransform;
+    size_t segVertexCount = seg.vertices.size();
+
+    auto appendIndices = [&](const std::vector<unsigned int>& list) {
+        SegmentDrawRange range;
+        range.indexCount = (GLsizei)list.size();
+        range.firstIndex = p.indices.size();
+        p.indices.insert(p.indices.end(), list.begin(), list.end());
+        return range;
+    };
+
+    // Sweep segments get every LOD chunk; anything else is drawn whole
+    GridLod lod = buildGridLod(seg);
+
+    // Reorder for the post-transform cache, then renumber vertices by first
+    // use of the full-resolution mesh
+    std::vector<unsigned int> remap;
+    std::vector<unsigned int> idx;
+    if (lod.chunks.empty()) {
+        idx = seg.indices;
+        optimizeVertexCache(idx, segVertexCount);
+        remap = optimizeVertexFetch(idx, segVertexCount);
+    } else {
+        for (auto& chunk : lod.chunks) {
+            for (int level = 0; level < lod.levels; ++level) {
+                optimizeVertexCache(chunk.body[level], segVertexCount);
+                for (int boundary = 0; boundary < lod.levels; ++boundary) {
+                    optimizeVertexCache(chunk.startEdge[level][boundary], segVertexCount);
+                    optimizeVertexCache(chunk.endEdge[level][boundary], segVertexCount);
+                }
+            }
+        }
+
+        std::vector<unsigned int> full;
+        for (const auto& chunk : lod.chunks)
+            for (const auto* list : { &chunk.startEdge[0][0], &chunk.body[0], &chunk.endEdge[0][0] })
+                full.insert(full.end(), list->begin(), list->end());
+        remap = optimizeVertexFetch(full, segVertexCount);
+
+        for (auto& chunk : lod.chunks) {
+            for (int level = 0; level < lod.levels; ++level) {
+                for (auto& i : chunk.body[level]) i = remap[i];
+                for (int boundary = 0; boundary < lod.levels; ++boundary) {
+                    for (auto& i : chunk.startEdge[level][boundary]) i = remap[i];
+                    for (auto& i : chunk.endEdge[level][boundary]) i = remap[i];
+                }
+            }
+        }
+    }
+
+    for (const auto& v : seg.vertices)
+        p.localBounds.expand(v);
+    if (seg.vertices.empty())
+        p.localBounds.min = p.localBounds.max = glm::vec3(0.0f);
+    glm::vec3 bmin = p.localBounds.min;
+    glm::vec3 extent = p.localBounds.max - bmin;
+
+    p.vertices.resize(segVertexCount);
+    for (size_t i = 0; i < segVertexCount; ++i) {
+        PackedTrackVertex& v = p.vertices[remap[i]];
+        const glm::vec3& pos = seg.vertices[i];
+        v.position[0] = quantize(pos.x, bmin.x, extent.x);
+        v.position[1] = quantize(pos.y, bmin.y, extent.y);
+        v.position[2] = quantize(pos.z, bmin.z, extent.z);
+        v.segment = 0;
+        v.normal = glm::packSnorm3x10_1x2(glm::vec4(glm::normalize(seg.normals[i]), 0.0f));
+    }
+
+    if (lod.chunks.empty()) {
+        p.full = appendIndices(idx);
+        return p;
+    }
+
+    // Level 0 first and in chunk order, so together it is the full mesh in one range
+    p.chunks.resize(lod.chunks.size());
+    p.full.firstIndex = p.indices.size();
+    for (size_t c = 0; c < lod.chunks.size(); ++c) {
+        const LodChunk& chunk = lod.chunks[c];
+        ChunkDrawRanges& ranges = p.chunks[c];
+        ranges.body.resize(lod.levels);
+        ranges.startEdge.assign(lod.levels, std::vector<SegmentDrawRange>(lod.levels));
+        ranges.endEdge.assign(lod.levels, std::vector<SegmentDrawRange>(lod.levels));
+
+        ranges.startEdge[0][0] = appendIndices(chunk.startEdge[0][0]);
+        ranges.body[0] = appendIndices(chunk.body[0]);
+        ranges.endEdge[0][0] = appendIndices(chunk.endEdge[0][0]);
+    }
+    p.full.indexCount = (GLsizei)(p.indices.size() - p.full.firstIndex);
+
+    for (size_t c = 0; c < lod.chunks.size(); ++c) {
+        const LodChunk& chunk = lod.chunks[c];
+        ChunkDrawRanges& ranges = p.chunks[c];
+        ranges.error = chunk.error;
+        ranges.localBounds = chunk.localBounds;
+
+        for (int level = 0; level < lod.levels; ++level) {
+            if (level > 0)
+                ranges.body[level] = appendIndices(chunk.body[level]);
+            for (int boundary = 0; boundary < lod.levels; ++boundary) {
+                if (level == 0 && boundary == 0) continue;
+                ranges.startEdge[level][boundary] = appendIndices(chunk.startEdge[level][boundary]);
+                ranges.endEdge[level][boundary] = appendIndices(chunk.endEdge[level][boundary]);
+            }
+        }
+    }
+    return p;
+}
+
+void TrackBatch::build(const Track& track) {
+    // First build, an index type that no longer fits, or segments that
+    // can't be told apart: start over
+    bool fits = VAO && hasUniqueIds(track) && track.segments.size() <= 0xFFFF;
+    if (fits && indexType == GL_UNSIGNED_SHORT)
+        for (const auto& seg : track.segments)
+            if (seg.vertices.size() > 0x10000 && !blocks.count(seg.id))
+                fits = false;
+    if (!fits) {
+        prepare(track);
+        upload();
+        return;
+    }
+
+    // Drop what left the track
+    std::unordered_set<uint64_t> ids;
+    for (const auto& seg : track.segments)
+        ids.insert(seg.id);
+    for (auto it = blocks.begin(); it != blocks.end();) {
+        if (!ids.count(it->first)) {
+            release(it->second);
+            it = blocks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Pack and place what joined it
+    std::vector<PackedSegment> packed;
+    size_t vertices = 0, indices = 0;
+    for (const auto& seg : track.segments) {
+        if (blocks.count(seg.id)) continue;
+        packed.push_back(pack(seg, seg.id));
+        vertices += packed.back().vertices.size();
+        indices += packed.back().indices.size();
+    }
+    lastPacked = packed.size();
+    reserve(vertices, indices, packed.size());
+    for (auto& p : packed)
+        place(std::move(p));
+
+    std::vector<uint64_t> keys;
+    std::vector<glm::mat4> transforms;
+    keys.reserve(track.segments.size());
+    transforms.reserve(track.segments.size());
+    for (const auto& seg : track.segments) {
+        keys.push_back(seg.id);
+        transforms.push_back(seg.worldTransform);
+    }
+    arrange(keys, transforms);
+}
+
+void TrackBatch::prepare(const Track& track) {
+    pending.clear();
+    hasPending = false;
+
+    if (track.segments.size() > 0xFFFF) {
+        std::cerr << "TrackBatch: too many segments for 16-bit segment slots\n";
+        return;
+    }
+
+    // 16-bit indices are enough when every segment fits, since indices stay segment-local
+    pendingShortIndices = true;
+    for (const auto& seg : track.segments)
+        if (seg.vertices.size() > 0x10000)
+            pendingShortIndices = false;
+
+    bool useIds = hasUniqueIds(track);
+    pending.reserve(track.segments.size());
+    for (size_t s = 0; s < track.segments.size(); ++s) {
+        const TrackSegment& seg = track.segments[s];
+        pending.push_back(pack(seg, useIds ? seg.id : ANONYMOUS_KEY | s));
+    }
+    lastPacked = pending.size();
+    hasPending = true;
+}
+
+void TrackBatch::upload() {
+    if (!hasPending) return;
+
+    blocks.clear();
+    freeSlots.clear();
+    nextSlot = 0;
+    indexType = pendingShortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    indexSize = pendingShortIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+
+    size_t vertices = 0, indices = 0;
+    for (const auto& p : pending) {
+        vertices += p.vertices.size();
+        indices += p.indices.size();
+    }
+    createBuffers(withSlack(vertices, 4096), withSlack(indices, 16384), withSlack(pending.size(), 64));
+
+    std::vector<uint64_t> keys;
+    std::vector<glm::mat4> transforms;
+    for (auto& p : pending) {
+        keys.push_back(p.key);
+        transforms.push_back(p.transform);
+        place(std::move(p));
+    }
+    arrange(keys, transforms);
+
+    // The GL copies are all that is needed from here on
+    pending = {};
+    hasPending = false;
+}
+
+void TrackBatch::createBuffers(size_t vertices, size_t indices, size_t slots) {
+    // Replacing the handles frees the previous build's objects
+    VBO = GlBuffer::create();
+    EBO = GlBuffer::create();
+    vertexCapacity = vertices;
+    indexCapacity = indices;
+    vertexEnd = liveVertices = 0;
+    indexEnd = liveIndices = 0;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexBytes(), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexBytes(), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    setVertexLayout();
+
+    slotCapacity = 0;
+    slotTexels.clear();
+    growSlots(slots);
+}
+
+void TrackBatch::setVertexLayout() {
+    VAO = GlVertexArray::create();
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+    // Quantized position + segment slot, read as integers
+    glEnableVertexAttribArray(0);
+    glVertexAttribIPointer(0, 4, GL_UNSIGNED_SHORT, sizeof(PackedTrackVertex),
+                           (void*)offsetof(PackedTrackVertex, position));
+    // Normal
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedTrackVertex),
+                          (void*)offsetof(PackedTrackVertex, normal));
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Make room at the end of the buffers, compacting and growing them if needed
+void TrackBatch::reserve(size_t vertices, size_t indices, size_t slots) {
+    if (vertexEnd + vertices > vertexCapacity || indexEnd + indices > indexCapacity)
+        repack(std::max(vertexCapacity, withSlack(liveVertices + vertices, 4096)),
+               std::max(indexCapacity, withSlack(liveIndices + indices, 16384)));
+
+    size_t newSlots = slots > freeSlots.size() ? slots - freeSlots.size() : 0;
+    if (nextSlot + newSlots > slotCapacity)
+        growSlots(withSlack(nextSlot + newSlots, 64));
+}
+
+// Copy every live block to the front of new buffers, on the GPU
+void TrackBatch::repack(size_t vertices, size_t indices) {
+    GlBuffer oldVBO = std::move(VBO), oldEBO = std::move(EBO);
+    VBO = GlBuffer::create();
+    EBO = GlBuffer::create();
+    vertexCapacity = vertices;
+    indexCapacity = indices;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexBytes(), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, oldVBO);
+    size_t end = 0;
+    for (auto& entry : blocks) {
+        Block& b = entry.second;
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, b.firstVertex * sizeof(PackedTrackVertex),
+                            end * sizeof(PackedTrackVertex), b.vertexCount * sizeof(PackedTrackVertex));
+        shiftRanges(b.full, b.chunks, (long)end - (long)b.firstVertex, 0);
+        b.firstVertex = end;
+        end += b.vertexCount;
+    }
+    vertexEnd = end;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexBytes(), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, oldEBO);
+    end = 0;
+    for (auto& entry : blocks) {
+        Block& b = entry.second;
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, b.firstIndex * indexSize,
+                            end * indexSize, b.indexCount * indexSize);
+        shiftRanges(b.full, b.chunks, 0, (long)end - (long)b.firstIndex);
+        b.firstIndex = end;
+        end += b.indexCount;
+    }
+    indexEnd = end;
+
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    setVertexLayout();
+}
+
+void TrackBatch::growSlots(size_t slots) {
+    slotCapacity = std::min<size_t>(std::max(slots, slotCapacity), 0x10000);
+    slotTexels.resize(slotCapacity * TRACK_TEXELS_PER_SLOT, glm::vec4(0.0f));
+
+    boundsBuffer = GlBuffer::create();
+    glBindBuffer(GL_TEXTURE_BUFFER, boundsBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, slotTexels.size() * sizeof(glm::vec4), slotTexels.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    boundsTexture = GlTexture::create();
+    glBindTexture(GL_TEXTURE_BUFFER, boundsTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, boundsBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    material.textureTarget = GL_TEXTURE_BUFFER;
+    material.texture = boundsTexture;
+    material.textureUnit = TRACK_BOUNDS_TEXTURE_UNIT;
+
+    // Everything is in the new buffer already
+    dirtyFirst = SIZE_MAX;
+    dirtyEnd = 0;
+}
+
+// Append a packed segment; reserve() must have made room
+void TrackBatch::place(PackedSegment&& p) {
+    Block b;
+    if (!freeSlots.empty()) {
+        b.slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        b.slot = nextSlot++;
+    }
+    b.firstVertex = vertexEnd;
+    b.vertexCount = p.vertices.size();
+    b.firstIndex = indexEnd;
+    b.indexCount = p.indices.size();
+    b.full = p.full;
+    b.chunks = std::move(p.chunks);
+    shiftRanges(b.full, b.chunks, (long)b.firstVertex, (long)b.firstIndex);
+
+    for (auto& v : p.vertices)
+        v.segment = b.slot;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, b.firstVertex * sizeof(PackedTrackVertex),
+                    b.vertexCount * sizeof(PackedTrackVertex), p.vertices.data());
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+    if (indexType == GL_UNSIGNED_SHORT) {
+        std::vector<uint16_t> shortIndices(p.indices.begin(), p.indices.end());
+        glBufferSubData(GL_COPY_WRITE_BUFFER, b.firstIndex * indexSize, b.indexCount * indexSize, shortIndices.data());
+    } else {
+        glBufferSubData(GL_COPY_WRITE_BUFFER, b.firstIndex * indexSize, b.indexCount * indexSize, p.indices.data());
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    glm::vec4* texels = &slotTexels[b.slot * TRACK_TEXELS_PER_SLOT];
+    texels[0] = glm::vec4(p.localBounds.min, 0.0f);
+    texels[1] = glm::vec4(p.localBounds.max - p.localBounds.min, 0.0f);
+    dirtyFirst = std::min(dirtyFirst, (size_t)b.slot);
+    dirtyEnd = std::max(dirtyEnd, (size_t)b.slot + 1);
+
+    vertexEnd += b.vertexCount;
+    indexEnd += b.indexCount;
+    liveVertices += b.vertexCount;
+    liveIndices += b.indexCount;
+    blocks[p.key] = std::move(b);
+}
+
+void TrackBatch::release(Block& b) {
+    freeSlots.push_back(b.slot);
+    liveVertices -= b.vertexCount;
+    liveIndices -= b.indexCount;
+}
+
+// Put blocks in track order and move any whose transform changed
+void TrackBatch::arrange(const std::vector<uint64_t>& keys, const std::vector<glm::mat4>& transforms) {
+    order.clear();
+    segmentRanges.clear();
+    segmentBytes.clear();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        Block& b = blocks.at(keys[i]);
+        const glm::mat4& t = transforms[i];
+        if (b.transform != t) {
+            b.transform = t;
+            glm::mat4 rows = glm::transpose(t);
+            glm::vec4* texels = &slotTexels[b.slot * TRACK_TEXELS_PER_SLOT];
+            texels[2] = rows[0];
+            texels[3] = rows[1];
+            texels[4] = rows[2];
+            dirtyFirst = std::min(dirtyFirst, (size_t)b.slot);
+            dirtyEnd = std::max(dirtyEnd, (size_t)b.slot + 1);
+
+            // World bounds from the corners of the local box
+            for (auto& chunk : b.chunks) {
+                chunk.bounds = Aabb();
+                for (int corner = 0; corner < 8; ++corner) {
+                    glm::vec3 p((corner & 1) ? chunk.localBounds.max.x : chunk.localBounds.min.x,
+                                (corner & 2) ? chunk.localBounds.max.y : chunk.localBounds.min.y,
+                                (corner & 4) ? chunk.localBounds.max.z : chunk.localBounds.min.z);
+                    chunk.bounds.expand(glm::vec3(t * glm::vec4(p, 1.0f)));
+                }
+            }
+        }
+        order.push_back(&b);
+        segmentRanges.push_back(b.full);
+        segmentBytes.push_back(b.vertexCount * sizeof(PackedTrackVertex) + b.indexCount * indexSize
+                               + TRACK_TEXELS_PER_SLOT * sizeof(glm::vec4));
+    }
+    flushTexels();
+}
+
+void TrackBatch::flushTexels() {
+    if (dirtyFirst >= dirtyEnd) return;
+    size_t first = dirtyFirst * TRACK_TEXELS_PER_SLOT;
+    size_t count = (dirtyEnd - dirtyFirst) * TRACK_TEXELS_PER_SLOT;
+    glBindBuffer(GL_TEXTURE_BUFFER, boundsBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, first * sizeof(glm::vec4), count * sizeof(glm::vec4), &slotTexels[first]);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    dirtyFirst = SIZE_MAX;
+    dirtyEnd = 0;
+}
+
+void TrackBatch::clearRanges() const {
+    counts.clear();
+    offsets.clear();
+    baseVertices.clear();
+    triangleCount = 0;
+}
+
+void TrackBatch::addRange(const SegmentDrawRange& r) const {
+    if (r.indexCount == 0) return;
+    counts.push_back(r.indexCount);
+    offsets.push_back((const void*)(r.firstIndex * indexSize));
+    baseVertices.push_back(r.baseVertex);
+    triangleCount += r.indexCount / 3;
+}
+
+void TrackBatch::submit(RenderQueue& queue, const ShaderProgram& shader) const {
+    clearRanges();
+    for (const auto& r : segmentRanges)
+        addRange(r);
+    submitRanges(queue, shader);
+}
+
+void TrackBatch::submit(RenderQueue& queue, const ShaderProgram& shader, const std::vector<int>& segments) const {
+    clearRanges();
+    for (int s : segments)
+        addRange(segmentRanges[s]);
+    submitRanges(queue, shader);
+}
+
+static float distanceToBox(const glm::vec3& p, const Aabb& box) {
+    glm::vec3 d = glm::max(glm::max(box.min - p, p - box.max), glm::vec3(0.0f));
+    return glm::length(d);
+}
+
+void TrackBatch::submit(RenderQueue& queue, const ShaderProgram& shader, const std::vector<int>& segments,
+                        const TrackLodView& view) const
+{
+    clearRanges();
+    for (int s : segments) {
+        const auto& chunks = order[s]->chunks;
+        if (chunks.empty()) {
+            addRange(segmentRanges[s]);
+            continue;
+        }
+
+        chunkLevels.resize(chunks.size());
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            float distance = distanceToBox(view.cameraPos, chunks[c].bounds);
+            chunkLevels[c] = selectLodLevel(chunks[c].error, distance, view.pixelScale, view.maxPixelError);
+        }
+
+        // Shared rows use the coarser of the two chunks' levels. The segment's
+        // own ends stay at full resolution to match the neighbouring segment.
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            int level = chunkLevels[c];
+            int startLevel = c > 0 ? std::max(level, chunkLevels[c - 1]) : 0;
+            int endLevel = c + 1 < chunks.size() ? std::max(level, chunkLevels[c + 1]) : 0;
+
+            addRange(chunks[c].startEdge[level][startLevel]);
+            addRange(chunks[c].body[level]);
+            addRange(chunks[c].endEdge[level][endLevel]);
+        }
+    }
+    submitRanges(queue, shader);
+}
+
+void TrackBatch::submitRanges(RenderQueue& queue, const ShaderProgram& shader) const {
+    if (counts.empty()) return;
+
+    DrawPacket packet;
+    packet.program = &shader;
+    packet.vao = VAO;
+    packet.material = &material;
+    packet.pass = RenderPass::Track;
+    packet.command.kind = DrawKind::MultiElementsBaseVertex;
+    packet.command.indexType = indexType;
+    packet.command.counts = counts.data();
+    packet.command.offsets = offsets.data();
+    packet.command.baseVertices = baseVertices.data();
+    packet.command.drawCount = (GLsizei)counts.size();
+    queue.submit(packet);
+}
@@ -0,0 +1,77 @@
+#include "track_cache.h"
+#include <algorithm>
+#include <chrono>
+
+std::shared_ptr<const BuiltTrack> BuiltTrack::build(const TrackDescription& description) {
+    auto t0 = std::chrono::steady_clock::now();
+
+    auto built = std::make_shared<BuiltTrack>();
+    built->description = description;
+    built->key = formatTrackDescription(description);
+    built->segments.reserve(description.pieces.size());
+    built->shapes.reserve(description.pieces.size());
+    for (const TrackPiece& piece : description.pieces) {
+        built->segments.push_back(makeTrackPiece(piece));
+        const TrackSegment& seg = built->segments.back();
+        built->shapes.push_back(PhysicsWorld::createTriangleMeshShape(seg.vertices, seg.indices));
+    }
+
+    built->buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return built;
+}
+
+TrackCache::TrackCache(size_t capacity)
+    : capacity(std::max<size_t>(capacity, 1)) {}
+
+std::shared_ptr<const BuiltTrack> TrackCache::get(const TrackDescription& description, bool* hit) {
+    std::string key = formatTrackDescription(description);
+    std::promise<std::shared_ptr<const BuiltTrack>> building;
+    Result result;
+    long build = 0;
+    bool found;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        found = it != entries.end();
+        if (found) {
+            ++counters.hits;
+            recent.splice(recent.begin(), recent, it->second.recent);
+            result = it->second.track;
+        } else {
+            ++counters.misses;
+            result = building.get_future().share();
+            recent.push_front(key);
+            build = ++builds;
+            entries[key] = Entry{ result, recent.begin(), build };
+            while (entries.size() > capacity) {
+                entries.erase(recent.back());
+                recent.pop_back();
+                ++counters.evictions;
+            }
+        }
+    }
+    if (hit)
+        *hit = found;
+
+    // Built outside the lock, so other tracks are served meanwhile
+    if (!found) {
+        try {
+            building.set_value(BuiltTrack::build(description));
+        } catch (...) {
+            // Waiters get the error; the next get() tries again
+            building.set_exception(std::current_exception());
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(key);
+            if (it != entries.end() && it->second.build == build) {
+                recent.erase(it->second.recent);
+                entries.erase(it);
+            }
+        }
+    }
+    return result.get();
+}
+
+TrackCacheStats TrackCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
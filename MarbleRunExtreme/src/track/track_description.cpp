@@ -0,0 +1,227 @@
+#include "track_description.h"
+#include "track_utils.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+struct KindInfo {
+    TrackPiece::Kind kind;
+    const char* name;
+    size_t minArgs, maxArgs;    // the builder's required and total parameters
+    size_t firstGridArg;        // segU, segV for sweeps
+};
+
+const KindInfo KINDS[] = {
+    { TrackPiece::Kind::Funnel,   "funnel",   1, 8, 6 },
+    { TrackPiece::Kind::Curve,    "curve",    1, 7, 5 },
+    { TrackPiece::Kind::Straight, "straight", 2, 5, 5 },
+};
+
+// Sweep tessellation; past this a single piece runs to hundreds of MB
+const float MAX_GRID = 1024.0f;
+
+// Whole-track limits, so no description can build more than a few dozen
+// standard courses' worth of geometry and bodies (a vertex costs ~200 bytes
+// once its triangles and BVH nodes are counted)
+const size_t MAX_PIECES = 1000;
+const size_t MAX_VERTICES = 1 << 19;
+const int MAX_OBSTACLES = 5000;
+
+const KindInfo& infoFor(TrackPiece::Kind kind) {
+    for (const KindInfo& k : KINDS)
+        if (k.kind == kind)
+            return k;
+    return KINDS[0];
+}
+
+// Shortest text that reads back as the same float
+std::string formatFloat(float v) {
+    char buf[32];
+    for (int precision = 6; precision <= 9; ++precision) {
+        std::snprintf(buf, sizeof(buf), "%.*g", precision, v);
+        if (std::strtof(buf, nullptr) == v)
+            break;
+    }
+    return buf;
+}
+
+bool parseNumber(const std::string& token, float& out) {
+    char* end = nullptr;
+    out = std::strtof(token.c_str(), &end);
+    return end && *end == '\0' && !token.empty() && std::isfinite(out);
+}
+
+float arg(const TrackPiece& piece, size_t i, float fallback) {
+    return i < piece.args.size() ? piece.args[i] : fallback;
+}
+
+// What makeTrackPiece will build, without building it
+size_t vertexCount(const TrackPiece& piece) {
+    const KindInfo& info = infoFor(piece.kind);
+    if (piece.kind == TrackPiece::Kind::Straight)
+        return 4;
+    size_t segU = (size_t)arg(piece, info.firstGridArg, 240.0f);
+    size_t segV = (size_t)arg(piece, info.firstGridArg + 1, 60.0f);
+    return (segU + 1) * (segV + 1);
+}
+
+} // namespace
+
+bool parseTrackDescription(const std::string& text, TrackDescription& out, std::string& error) {
+    out.pieces.clear();
+    std::istringstream lines(text);
+    std::string line;
+    int lineNumber = 0;
+    size_t vertices = 0;
+    int obstacles = 0;
+
+    auto fail = [&](const std::string& message) {
+        error = "line " + std::to_string(lineNumber) + ": " + message;
+        out.pieces.clear();
+        return false;
+    };
+
+    while (std::getline(lines, line)) {
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+        std::istringstream tokens(line);
+        std::string word;
+        if (!(tokens >> word))
+            continue;
+
+        const KindInfo* info = nullptr;
+        for (const KindInfo& k : KINDS)
+            if (word == k.name)
+                info = &k;
+        if (!info)
+            return fail("unknown piece '" + word + "'");
+
+        TrackPiece piece;
+        piece.kind = info->kind;
+        while (tokens >> word) {
+            size_t eq = word.find('=');
+            float value = 0.0f;
+            if (!parseNumber(eq == std::string::npos ? word : word.substr(eq + 1), value))
+                return fail("bad number in '" + word + "'");
+
+            if (eq == std::string::npos) {
+                if (piece.obstacles > 0 || piece.spread != 0.0f)
+                    return fail("arguments must come before options");
+                piece.args.push_back(value);
+            } else if (word.compare(0, eq, "obstacles") == 0) {
+                if (value < 0.0f || value > 1000.0f || value != std::floor(value))
+                    return fail("obstacles must be a whole number from 0 to 1000");
+                piece.obstacles = (int)value;
+            } else if (word.compare(0, eq, "spread") == 0) {
+                if (value < 0.0f)
+                    return fail("spread can't be negative");
+                piece.spread = value;
+            } else {
+                return fail("unknown option '" + word.substr(0, eq) + "'");
+            }
+        }
+
+        if (piece.args.size() < info->minArgs || piece.args.size() > info->maxArgs)
+            return fail(std::string(info->name) + " takes " + std::to_string(info->minArgs) + " to "
+                        + std::to_string(info->maxArgs) + " arguments");
+        for (size_t i = info->firstGridArg; i < piece.args.size(); ++i) {
+            float g = piece.args[i];
+            if (g < 1.0f || g > MAX_GRID || g != std::floor(g))
+                return fail("grid sizes must be whole numbers from 1 to " + std::to_string((int)MAX_GRID));
+        }
+        if (piece.obstacles > 0 && piece.kind != TrackPiece::Kind::Straight)
+            return fail("only straights carry obstacles");
+
+        vertices += vertexCount(piece);
+        obstacles += piece.obstacles;
+        if (out.pieces.size() >= MAX_PIECES)
+            return fail("more than " + std::to_string(MAX_PIECES) + " pieces");
+        if (vertices > MAX_VERTICES)
+            return fail("track over " + std::to_string(MAX_VERTICES) + " vertices");
+        if (obstacles > MAX_OBSTACLES)
+            return fail("track over " + std::to_string(MAX_OBSTACLES) + " obstacles");
+        out.pieces.push_back(std::move(piece));
+    }
+
+    if (out.pieces.empty()) {
+        error = "no pieces";
+        return false;
+    }
+    return true;
+}
+
+std::string formatTrackDescription(const TrackDescription& description) {
+    std::string text;
+    for (const TrackPiece& piece : description.pieces) {
+        text += infoFor(piece.kind).name;
+        for (float a : piece.args)
+            text += " " + formatFloat(a);
+        if (piece.obstacles > 0) {
+            text += " obstacles=" + std::to_string(piece.obstacles);
+            if (piece.spread != 0.0f)
+                text += " spread=" + formatFloat(piece.spread);
+        }
+        text += "\n";
+    }
+    return text;
+}
+
+const TrackDescription& standardTrackDescription() {
+    static const TrackDescription standard = [] {
+        using Kind = TrackPiece::Kind;
+        TrackDescription d;
+        auto add = [&](Kind kind, std::vector<float> args, int obstacles = 0) {
+            TrackPiece piece;
+            piece.kind = kind;
+            piece.args = std::move(args);
+            piece.obstacles = obstacles;
+            d.pieces.push_back(std::move(piece));
+        };
+
+        add(Kind::Funnel, { 180.0f, 10.0f, 30.0f, 20.0f, 3.0f, 5.0f });
+        add(Kind::Curve, { 360.0f, 15.0f });
+        add(Kind::Curve, { -360.0f, 15.0f, -40.0f });
+        add(Kind::Curve, { 100.0f });
+        add(Kind::Curve, { -100.0f, 15.0f, -40.0f });
+
+        // The slot machine, then a short ramp
+        add(Kind::Straight, { 60.0f, -10.0f, 1.0f, 30.0f }, 15);
+        add(Kind::Straight, { 10.0f, 10.0f, 2.0f, 30.0f });
+
+        // A flight of steps
+        add(Kind::Straight, { 5.0f, -90.0f, 4.0f, 30.0f });
+        for (int i = 0; i < 13; ++i)
+            add(Kind::Straight, { 5.0f, (i % 2 == 0) ? 90.0f : -90.0f, 2.0f, 30.0f });
+
+        // Finish
+        add(Kind::Straight, { 40.0f, 0.0f, 2.0f, 30.0f });
+        return d;
+    }();
+    return standard;
+}
+
+TrackSegment makeTrackPiece(const TrackPiece& piece) {
+    switch (piece.kind) {
+    case TrackPiece::Kind::Funnel:
+        return makeFunnelSegment(arg(piece, 0, 0.0f), arg(piece, 1, 10.0f), arg(piece, 2, 30.0f), arg(piece, 3, 5.0f),
+                                 arg(piece, 4, 3.0f), arg(piece, 5, 2.5f),
+                                 (int)arg(piece, 6, 240.0f), (int)arg(piece, 7, 60.0f));
+    case TrackPiece::Kind::Curve:
+        return makeCurvedSegment(arg(piece, 0, 0.0f), arg(piece, 1, 10.0f), arg(piece, 2, 30.0f), arg(piece, 3, 5.0f),
+                                 arg(piece, 4, 3.0f), (int)arg(piece, 5, 240.0f), (int)arg(piece, 6, 60.0f));
+    case TrackPiece::Kind::Straight:
+    default:
+        return makeStraightSegment(arg(piece, 0, 0.0f), arg(piece, 1, 0.0f), arg(piece, 2, 0.0f), arg(piece, 3, 5.0f),
+                                   arg(piece, 4, 2.0f));
+    }
+}
+
+std::vector<Obstacle> makeTrackPieceObstacles(const TrackPiece& piece, const TrackSegment& segment, unsigned int seed) {
+    if (piece.obstacles <= 0 || piece.kind != TrackPiece::Kind::Straight)
+        return {};
+    float spread = piece.spread > 0.0f ? piece.spread : 0.5f * arg(piece, 3, 5.0f);
+    return makeSlotMachineObstacles(segment, arg(piece, 0, 0.0f), spread, piece.obstacles, seed);
+}
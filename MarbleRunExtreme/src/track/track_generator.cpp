@@ -0,0 +1,449 @@
+#include "track_generator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+// Sweep chunks span this many grid rows, about 24 degrees of a 240-row turn
+static const int ROWS_PER_CHUNK = 16;
+
+// Grid cell edge, in metres
+static const float CELL_SIZE = 32.0f;
+
+// Chunks closer than this along the track are neighbours, not a crossing.
+// Covers the join between pieces and the inside of a tight turn.
+static const float NEIGHBOUR_GAP = 60.0f;
+
+// Chunks are kept this far behind the generated end on top of buildAhead and
+// retireBehind, so everything the live track can still hold is checked. The
+// rule only depends on what was generated, so a seed gives the same track
+// whatever the leader does.
+static const float CHUNK_KEEP_MARGIN = 300.0f;
+
+// Track widths (half the trough or surface width) at either end of a piece
+static const float NARROW_WIDTH = 5.0f;
+static const float WIDE_WIDTH = 20.0f;
+
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+static bool overlaps(const Aabb& a, const Aabb& b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+static uint64_t cellKey(int x, int y, int z) {
+    const uint64_t mask = (1u << 21) - 1;
+    return ((uint64_t)(x & mask) << 42) | ((uint64_t)(y & mask) << 21) | (uint64_t)(z & mask);
+}
+
+TrackGenerator::TrackGenerator(const Track& track, const TrackGeneratorSettings& settings)
+    : settings(settings), rng(settings.seed)
+{
+    cursor = Track::exitFrame(track.segments.back());
+
+    // Only wide straights leave the track wide; curves and funnels end narrow
+    const TrackSegment& last = track.segments.back();
+    if (last.centerline.kind == TrackCenterline::Kind::Straight && last.centerline.reach > WIDE_WIDTH)
+        tailWidth = Width::Wide;
+
+    std::vector<Chunk> existing;
+    endDistance = track.startDistance;
+    for (const TrackSegment& seg : track.segments) {
+        chunkSegment(seg, endDistance, existing);
+        endDistance += seg.length();
+    }
+    addChunks(existing);
+
+    wantedDistance = track.startDistance + settings.buildAhead;
+    worker = std::thread(&TrackGenerator::workerLoop, this);
+}
+
+TrackGenerator::~TrackGenerator() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    if (worker.joinable())
+        worker.join();
+}
+
+TrackGeneratorStats TrackGenerator::stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+// ---------------- Worker ----------------
+
+void TrackGenerator::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        changed.wait(lock, [&] {
+            return stopping || ((int)ready.size() < settings.readyPieces && endDistance < wantedDistance);
+        });
+        if (stopping) return;
+        lock.unlock();
+
+        auto t0 = Clock::now();
+        TrackGeneratorStats delta;
+        Piece piece = generatePiece(delta);
+        double ms = millisSince(t0);
+
+        lock.lock();
+        counters.piecesGenerated++;
+        counters.rejectedIntersect += delta.rejectedIntersect;
+        counters.rejectedDrop += delta.rejectedDrop;
+        counters.forcedDrops += delta.forcedDrops;
+        counters.maxGenerateMs = std::max(counters.maxGenerateMs, ms);
+        ready.push_back(std::move(piece));
+        changed.notify_all();
+    }
+}
+
+TrackGenerator::Piece TrackGenerator::generatePiece(TrackGeneratorStats& delta) {
+    pruneChunks(endDistance - settings.buildAhead - settings.retireBehind - CHUNK_KEEP_MARGIN);
+
+    Piece piece;
+    Width width = tailWidth;
+    glm::mat4 frame = cursor;
+    std::vector<Chunk> pieceChunks;
+
+    // The drop budget gives way before clearance does: the first candidate
+    // that only broke the budget is kept in case nothing fits
+    struct Placed {
+        Piece piece;
+        Width width = Width::Narrow;
+        glm::mat4 frame = glm::mat4(1.0f);
+        std::vector<Chunk> chunks;
+    };
+    std::unique_ptr<Placed> overBudget;
+
+    bool accepted = false;
+    for (int attempt = 0; attempt < settings.attempts && !accepted; ++attempt) {
+        piece = Piece();
+        width = tailWidth;
+        candidate(piece, width);
+
+        frame = cursor;
+        pieceChunks.clear();
+        place(piece, frame, endDistance, pieceChunks);
+
+        if (!clear(pieceChunks)) {
+            delta.rejectedIntersect++;
+            continue;
+        }
+
+        // Drop budget: the run's average slope stays near dropPerMetre
+        float drop = totalDrop + (cursor[3].y - frame[3].y);
+        float expected = settings.dropPerMetre * (dropDistance + piece.length);
+        if (std::abs(drop - expected) > settings.dropSlack) {
+            delta.rejectedDrop++;
+            if (!overBudget)
+                overBudget.reset(new Placed{ std::move(piece), width, frame, std::move(pieceChunks) });
+            continue;
+        }
+        accepted = true;
+    }
+
+    if (!accepted && overBudget) {
+        piece = std::move(overBudget->piece);
+        width = overBudget->width;
+        frame = overBudget->frame;
+        pieceChunks = std::move(overBudget->chunks);
+        accepted = true;
+    }
+
+    // Nothing cleared the track: fall straight down, away from the track
+    // above, and land wide so anything can follow
+    if (!accepted) {
+        delta.forcedDrops++;
+        piece = Piece();
+        piece.segments.push_back(makeStraightSegment(30.0f, -90.0f, 2.0f, WIDE_WIDTH));
+        piece.segments.push_back(makeStraightSegment(10.0f, 90.0f, 2.0f, WIDE_WIDTH));
+        width = Width::Wide;
+        frame = cursor;
+        pieceChunks.clear();
+        place(piece, frame, endDistance, pieceChunks);
+    }
+
+    // Collision meshes and their BVHs only for the piece that was kept
+    for (TrackSegment& seg : piece.segments) {
+        seg.body = PhysicsWorld::createTriangleMesh(seg.vertices, seg.indices, glm::vec3(0), glm::vec3(0));
+        seg.setWorldTransform(seg.worldTransform);
+    }
+
+    // Obstacles need the placed segment, and come after every rejection so
+    // those don't shift them
+    if (piece.obstacleSegment >= 0) {
+        const TrackSegment& seg = piece.segments[piece.obstacleSegment];
+        piece.obstacles = makeSlotMachineObstacles(seg, seg.length(), WIDE_WIDTH - 8.0f,
+                                                   (int)(seg.length() / 4.0f), rng());
+    }
+
+    totalDrop += cursor[3].y - frame[3].y;
+    dropDistance += piece.length;
+    cursor = frame;
+    tailWidth = width;
+    endDistance += piece.length;
+    addChunks(pieceChunks);
+    return piece;
+}
+
+// One random piece that can follow the current tail. `width` is what it leaves.
+void TrackGenerator::candidate(Piece& piece, Width& width) {
+    enum Kind { Curve, Funnel, Ramp, Stairs, ObstacleStraight };
+
+    // A curve's trough is narrow, so after a wide piece only a funnel or
+    // another wide piece will catch the marbles
+    static const float narrowWeights[] = { 45.0f, 10.0f, 15.0f, 15.0f, 15.0f };
+    static const float wideWeights[]   = {  0.0f, 40.0f, 20.0f, 20.0f, 20.0f };
+    const float* weights = tailWidth == Width::Narrow ? narrowWeights : wideWeights;
+    std::discrete_distribution<int> pick(weights, weights + 5);
+
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto between = [&](float lo, float hi) { return lo + (hi - lo) * unit(rng); };
+    float turn = unit(rng) < 0.5f ? 1.0f : -1.0f;
+
+    Kind kind = (Kind)pick(rng);
+    switch (kind) {
+    case Curve: {
+        float arcDeg = between(90.0f, 360.0f);
+        float radius = between(30.0f, 45.0f);
+        float drop = between(0.06f, 0.15f) * radius * glm::radians(arcDeg);
+        piece.segments.push_back(makeCurvedSegment(turn * arcDeg, drop, turn * radius, NARROW_WIDTH));
+        width = Width::Narrow;
+        break;
+    }
+    case Funnel:
+        piece.segments.push_back(makeFunnelSegment(turn * 180.0f, 10.0f, turn * 30.0f, WIDE_WIDTH, 3.0f,
+                                                   NARROW_WIDTH));
+        width = Width::Narrow;
+        break;
+    case Ramp: {
+        float pitch = between(8.0f, 20.0f);
+        piece.segments.push_back(makeStraightSegment(between(20.0f, 50.0f), -pitch, 1.0f, WIDE_WIDTH));
+        piece.segments.push_back(makeStraightSegment(10.0f, pitch, 1.0f, WIDE_WIDTH));
+        width = Width::Wide;
+        break;
+    }
+    case Stairs: {
+        int steps = 2 + (int)(unit(rng) * 5.0f);
+        for (int i = 0; i < steps; ++i) {
+            piece.segments.push_back(makeStraightSegment(5.0f, -90.0f, 2.0f, WIDE_WIDTH));
+            piece.segments.push_back(makeStraightSegment(5.0f, 90.0f, 2.0f, WIDE_WIDTH));
+        }
+        width = Width::Wide;
+        break;
+    }
+    case ObstacleStraight:
+        piece.segments.push_back(makeStraightSegment(between(40.0f, 60.0f), -10.0f, 1.0f, WIDE_WIDTH));
+        piece.segments.push_back(makeStraightSegment(10.0f, 10.0f, 1.0f, WIDE_WIDTH));
+        piece.obstacleSegment = 0;
+        width = Width::Wide;
+        break;
+    }
+}
+
+// Put the piece's segments end to end from `frame`, leaving `frame` at its exit
+void TrackGenerator::place(Piece& piece, glm::mat4& frame, float startDistance,
+                           std::vector<Chunk>& pieceChunks) const {
+    float distance = startDistance;
+    piece.length = 0.0f;
+    for (TrackSegment& seg : piece.segments) {
+        seg.setWorldTransform(Track::attachmentTransform(frame, seg));
+        frame = Track::exitFrame(seg);
+        chunkSegment(seg, distance, pieceChunks);
+        distance += seg.length();
+        piece.length += seg.length();
+    }
+}
+
+void TrackGenerator::chunkSegment(const TrackSegment& seg, float from, std::vector<Chunk>& out) const {
+    glm::vec3 margin(settings.clearance);
+    auto grow = [&](Chunk& c) {
+        c.bounds.min -= margin;
+        c.bounds.max += margin;
+        out.push_back(c);
+    };
+
+    if (seg.gridU <= 0) {
+        Chunk c;
+        c.bounds = seg.worldBounds;
+        c.from = from;
+        c.to = from + seg.length();
+        grow(c);
+        return;
+    }
+
+    int stride = seg.gridV + 1;
+    for (int u0 = 0; u0 < seg.gridU; u0 += ROWS_PER_CHUNK) {
+        int u1 = std::min(u0 + ROWS_PER_CHUNK, seg.gridU);
+        Chunk c;
+        for (int i = u0 * stride; i < (u1 + 1) * stride; ++i)
+            c.bounds.expand(glm::vec3(seg.worldTransform * glm::vec4(seg.vertices[i], 1.0f)));
+        c.from = from + seg.length() * (float)u0 / seg.gridU;
+        c.to = from + seg.length() * (float)u1 / seg.gridU;
+        grow(c);
+    }
+}
+
+template <class F>
+void TrackGenerator::forEachCell(const Aabb& bounds, F&& f) const {
+    glm::ivec3 lo = glm::ivec3(glm::floor(bounds.min / CELL_SIZE));
+    glm::ivec3 hi = glm::ivec3(glm::floor(bounds.max / CELL_SIZE));
+    for (int x = lo.x; x <= hi.x; ++x)
+        for (int y = lo.y; y <= hi.y; ++y)
+            for (int z = lo.z; z <= hi.z; ++z)
+                f(cellKey(x, y, z));
+}
+
+// No chunk comes near another that is far from it along the track
+bool TrackGenerator::clear(const std::vector<Chunk>& pieceChunks) const {
+    auto apart = [](const Chunk& a, const Chunk& b) {
+        return std::max(a.from, b.from) - std::min(a.to, b.to) >= NEIGHBOUR_GAP;
+    };
+
+    for (size_t i = 0; i < pieceChunks.size(); ++i) {
+        const Chunk& c = pieceChunks[i];
+        for (size_t j = 0; j < i; ++j)
+            if (apart(c, pieceChunks[j]) && overlaps(c.bounds, pieceChunks[j].bounds))
+                return false;
+
+        bool hit = false;
+        forEachCell(c.bounds, [&](uint64_t key) {
+            if (hit) return;
+            auto it = grid.find(key);
+            if (it == grid.end()) return;
+            for (uint64_t id : it->second) {
+                const Chunk& other = chunks[id - firstChunk];
+                if (apart(c, other) && overlaps(c.bounds, other.bounds)) {
+                    hit = true;
+                    return;
+                }
+            }
+        });
+        if (hit) return false;
+    }
+    return true;
+}
+
+void TrackGenerator::addChunks(const std::vector<Chunk>& pieceChunks) {
+    for (const Chunk& c : pieceChunks) {
+        uint64_t id = firstChunk + chunks.size();
+        chunks.push_back(c);
+        forEachCell(c.bounds, [&](uint64_t key) { grid[key].push_back(id); });
+    }
+}
+
+void TrackGenerator::pruneChunks(float before) {
+    while (!chunks.empty() && chunks.front().to < before) {
+        uint64_t id = firstChunk;
+        forEachCell(chunks.front().bounds, [&](uint64_t key) {
+            auto it = grid.find(key);
+            if (it == grid.end()) return;
+            auto& ids = it->second;
+            ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+            if (ids.empty())
+                grid.erase(it);
+        });
+        chunks.pop_front();
+        ++firstChunk;
+    }
+}
+
+// ---------------- Main thread ----------------
+
+int TrackGenerator::attach(Track& track, PhysicsWorld& physics, std::vector<Obstacle>& obstacles,
+                           float leaderDistance) {
+    auto t0 = Clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        wantedDistance = std::max(wantedDistance, leaderDistance + settings.buildAhead);
+    }
+    changed.notify_all();
+
+    float trackEnd = track.startDistance;
+    for (const TrackSegment& seg : track.segments)
+        trackEnd += seg.length();
+
+    int added = 0;
+    long attached = 0;
+    bool starved = false;
+    while (true) {
+        if (settings.deterministic && trackEnd - leaderDistance >= settings.buildAhead)
+            break;
+
+        Piece piece;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (ready.empty()) {
+                if (!settings.deterministic) {
+                    starved = trackEnd - leaderDistance < 0.25f * settings.buildAhead;
+                    break;
+                }
+                // The worker sums lengths in its own order, so ask for a
+                // clear margin more than rounding could hide
+                starved = true;
+                wantedDistance = std::max(wantedDistance, trackEnd + settings.buildAhead);
+                changed.notify_all();
+                changed.wait(lock, [&] { return !ready.empty(); });
+            }
+            piece = std::move(ready.front());
+            ready.pop_front();
+        }
+        changed.notify_all();
+
+        long base = (long)(track.retired + track.segments.size());
+        for (TrackSegment& seg : piece.segments) {
+            TrackSegment& placed = track.addSegment(std::move(seg));
+            physics.add(placed.body);
+        }
+        for (Obstacle& o : piece.obstacles) {
+            o.segment = base + piece.obstacleSegment;
+            physics.add(o.box.body);
+            obstacles.push_back(std::move(o));
+        }
+        trackEnd += piece.length;
+        added += (int)piece.segments.size();
+        ++attached;
+
+        if (!settings.deterministic && millisSince(t0) >= settings.attachBudgetMs)
+            break;
+    }
+
+    double ms = millisSince(t0);
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.piecesAttached += attached;
+    if (starved) counters.starvedUpdates++;
+    counters.maxAttachMs = std::max(counters.maxAttachMs, ms);
+    return added;
+}
+
+int TrackGenerator::retire(Track& track, std::vector<Obstacle>& obstacles, float leaderDistance) {
+    float line = retireLine(leaderDistance);
+
+    // Always leave at least one segment
+    size_t count = 0;
+    float end = track.startDistance;
+    while (count + 1 < track.segments.size() && end + track.segments[count].length() < line) {
+        end += track.segments[count].length();
+        ++count;
+    }
+    if (count == 0) return 0;
+
+    long firstKept = (long)(track.retired + count);
+    obstacles.erase(std::remove_if(obstacles.begin(), obstacles.end(),
+                                   [&](const Obstacle& o) { return o.segment >= 0 && o.segment < firstKept; }),
+                    obstacles.end());
+    track.retireFront(count);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.segmentsRetired += (long)count;
+    return (int)count;
+}
@@ -0,0 +1,159 @@
+#include "track_lod.h"
+#include <algorithm>
+
+namespace {
+
+struct Grid {
+    const TrackSegment& seg;
+    int rowSize;    // vertices per row, gridV + 1
+
+    unsigned int index(int u, int v) const { return (unsigned int)(u * rowSize + v); }
+    const glm::vec3& pos(int u, int v) const { return seg.vertices[index(u, v)]; }
+};
+
+// Emit (u,v) triangle keeping the builders' winding, which is counter-clockwise in (u, v)
+void triangle(std::vector<unsigned int>& out, const Grid& g,
+              glm::ivec2 a, glm::ivec2 b, glm::ivec2 c)
+{
+    int area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (area < 0) std::swap(b, c);
+    out.push_back(g.index(a.x, a.y));
+    out.push_back(g.index(b.x, b.y));
+    out.push_back(g.index(c.x, c.y));
+}
+
+// Quads between rows [uBegin, uEnd) at the given stride
+void emitBody(std::vector<unsigned int>& out, const Grid& g, int uBegin, int uEnd, int stride, int gridV) {
+    for (int u = uBegin; u < uEnd; u += stride) {
+        for (int v = 0; v < gridV; v += stride) {
+            triangle(out, g, { u, v }, { u + stride, v }, { u, v + stride });
+            triangle(out, g, { u, v + stride }, { u + stride, v }, { u + stride, v + stride });
+        }
+    }
+}
+
+// One row of quads between a coarse row, using every coarseStride-th vertex,
+// and a fine row using every fineStride-th. Each coarse edge fans out to the
+// fine vertices below it, so both rows keep exactly their own vertices.
+void emitEdge(std::vector<unsigned int>& out, const Grid& g, int uCoarse, int uFine,
+              int coarseStride, int fineStride, int gridV)
+{
+    int n = coarseStride / fineStride;
+    int half = n / 2;
+    for (int v = 0; v < gridV; v += coarseStride) {
+        for (int k = 0; k < n; ++k) {
+            glm::ivec2 corner = k < half ? glm::ivec2(uCoarse, v) : glm::ivec2(uCoarse, v + coarseStride);
+            triangle(out, g, { uFine, v + k * fineStride }, { uFine, v + (k + 1) * fineStride }, corner);
+        }
+        triangle(out, g, { uCoarse, v }, { uFine, v + half * fineStride }, { uCoarse, v + coarseStride });
+    }
+}
+
+// Largest deviation of the full-resolution vertices from the bilinear patch
+// through the coarse grid at this stride
+float levelError(const Grid& g, int firstRow, int lastRow, int stride, int gridV) {
+    float error = 0.0f;
+    for (int u = firstRow; u <= lastRow; ++u) {
+        int u0 = firstRow + ((u - firstRow) / stride) * stride;
+        int u1 = std::min(u0 + stride, lastRow);
+        float a = u1 > u0 ? float(u - u0) / float(u1 - u0) : 0.0f;
+
+        for (int v = 0; v <= gridV; ++v) {
+            int v0 = (v / stride) * stride;
+            int v1 = std::min(v0 + stride, gridV);
+            float b = v1 > v0 ? float(v - v0) / float(v1 - v0) : 0.0f;
+
+            glm::vec3 p = glm::mix(glm::mix(g.pos(u0, v0), g.pos(u0, v1), b),
+                                   glm::mix(g.pos(u1, v0), g.pos(u1, v1), b), a);
+            error = std::max(error, glm::length(g.pos(u, v) - p));
+        }
+    }
+    return error;
+}
+
+} // namespace
+
+GridLod buildGridLod(const TrackSegment& seg) {
+    GridLod lod;
+    int gridU = seg.gridU, gridV = seg.gridV;
+    if (gridU <= 0 || gridV <= 0) return lod;
+
+    Grid g{ seg, gridV + 1 };
+
+    // Row ranges for each chunk
+    std::vector<glm::ivec2> rows;
+    for (int u = 0; u < gridU; u += LOD_CHUNK_QUADS)
+        rows.push_back({ u, std::min(u + LOD_CHUNK_QUADS, gridU) });
+
+    // A stride is usable if it divides the cross-section and every chunk,
+    // and leaves each chunk at least two rows for its two edges
+    lod.levels = 1;
+    while (lod.levels < LOD_MAX_LEVELS) {
+        int stride = 1 << lod.levels;
+        bool ok = gridV % stride == 0;
+        for (const auto& r : rows)
+            ok = ok && (r.y - r.x) % stride == 0 && (r.y - r.x) / stride >= 2;
+        if (!ok) break;
+        ++lod.levels;
+    }
+
+    for (const auto& r : rows) {
+        LodChunk chunk;
+        chunk.firstRow = r.x;
+        chunk.lastRow = r.y;
+
+        for (int u = r.x; u <= r.y; ++u)
+            for (int v = 0; v <= gridV; ++v)
+                chunk.localBounds.expand(g.pos(u, v));
+
+        chunk.error.resize(lod.levels);
+        chunk.body.resize(lod.levels);
+        chunk.startEdge.resize(lod.levels);
+        chunk.endEdge.resize(lod.levels);
+
+        for (int level = 0; level < lod.levels; ++level) {
+            int stride = 1 << level;
+            chunk.error[level] = level == 0 ? 0.0f : levelError(g, r.x, r.y, stride, gridV);
+
+            if (r.y - r.x < 2 * stride) {
+                // Too short for separate edges (only possible at level 0)
+                emitBody(chunk.body[level], g, r.x, r.y, stride, gridV);
+                chunk.startEdge[level].resize(lod.levels);
+                chunk.endEdge[level].resize(lod.levels);
+                continue;
+            }
+
+            emitBody(chunk.body[level], g, r.x + stride, r.y - stride, stride, gridV);
+
+            chunk.startEdge[level].resize(lod.levels);
+            chunk.endEdge[level].resize(lod.levels);
+            for (int boundary = 0; boundary < lod.levels; ++boundary) {
+                int boundaryStride = 1 << boundary;
+                auto& start = chunk.startEdge[level][boundary];
+                auto& end = chunk.endEdge[level][boundary];
+                if (boundary >= level) {
+                    emitEdge(start, g, r.x, r.x + stride, boundaryStride, stride, gridV);
+                    emitEdge(end, g, r.y, r.y - stride, boundaryStride, stride, gridV);
+                } else {
+                    emitEdge(start, g, r.x + stride, r.x, stride, boundaryStride, gridV);
+                    emitEdge(end, g, r.y - stride, r.y, stride, boundaryStride, gridV);
+                }
+            }
+        }
+
+        lod.chunks.push_back(std::move(chunk));
+    }
+
+    return lod;
+}
+
+int selectLodLevel(const std::vector<float>& error, float distance, float pixelScale, float maxPixelError) {
+    distance = std::max(distance, 1e-3f);
+    int level = 0;
+    for (int l = 1; l < (int)error.size(); ++l) {
+        if (error[l] * pixelScale / distance > maxPixelError)
+            break;
+        level = l;
+    }
+    return level;
+}
@@ -0,0 +1,120 @@
+#include "track_progress.h"
+#include <algorithm>
+
+static bool contains(const Aabb& b, const glm::vec3& p) {
+    return p.x >= b.min.x && p.y >= b.min.y && p.z >= b.min.z &&
+           p.x <= b.max.x && p.y <= b.max.y && p.z <= b.max.z;
+}
+
+void TrackProgressIndex::build(const Track& t) {
+    track = &t;
+    size_t count = t.segments.size();
+
+    bounds.resize(count);
+    starts.assign(count + 1, 0.0f);
+    starts[0] = t.startDistance;
+    for (size_t i = 0; i < count; ++i) {
+        const TrackSegment& seg = t.segments[i];
+        glm::vec3 reach(seg.centerline.reach);
+        bounds[i].min = seg.worldBounds.min - reach;
+        bounds[i].max = seg.worldBounds.max + reach;
+        starts[i + 1] = starts[i] + seg.length();
+    }
+
+    nodes.clear();
+    leaves.resize(count);
+    for (size_t i = 0; i < count; ++i)
+        leaves[i] = (int)i;
+    if (count > 0)
+        buildNode(0, (int)count);
+}
+
+int TrackProgressIndex::buildNode(int first, int count) {
+    int index = (int)nodes.size();
+    nodes.emplace_back();
+
+    Aabb box;
+    for (int i = first; i < first + count; ++i)
+        box.expand(bounds[leaves[i]]);
+    nodes[index].bounds = box;
+
+    if (count <= 2) {
+        nodes[index].first = first;
+        nodes[index].count = count;
+        return index;
+    }
+
+    // Median split on the widest axis of the box centres
+    Aabb centres;
+    for (int i = first; i < first + count; ++i)
+        centres.expand(0.5f * (bounds[leaves[i]].min + bounds[leaves[i]].max));
+    glm::vec3 extent = centres.max - centres.min;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    int half = count / 2;
+    std::nth_element(leaves.begin() + first, leaves.begin() + first + half, leaves.begin() + first + count,
+                     [&](int a, int b) {
+                         return bounds[a].min[axis] + bounds[a].max[axis] < bounds[b].min[axis] + bounds[b].max[axis];
+                     });
+
+    int left = buildNode(first, half);
+    int right = buildNode(first + half, count - half);
+    nodes[index].left = left;
+    nodes[index].right = right;
+    return index;
+}
+
+bool TrackProgressIndex::test(int segment, const glm::vec3& pos, TrackPosition& best) const {
+    if (!contains(bounds[segment], pos)) return false;
+
+    // Segment transforms are rigid, so the offset can be measured locally
+    const TrackSegment& seg = track->segments[segment];
+    glm::vec3 local = glm::vec3(seg.inverseWorldTransform * glm::vec4(pos, 1.0f));
+    float offset;
+    float t = seg.centerline.closestT(local, offset);
+    if (offset > seg.centerline.reach) return false;
+    if (best.segment >= 0 && offset >= best.offset) return false;
+
+    best.segment = segment;
+    best.t = t;
+    best.offset = offset;
+    best.distance = starts[segment] + t * seg.length();
+    return true;
+}
+
+TrackPosition TrackProgressIndex::locate(const glm::vec3& pos, int hint) const {
+    TrackPosition best;
+    if (nodes.empty()) return best;
+
+    if (hint >= 0 && hint < (int)bounds.size()) {
+        // Well inside the hinted segment's trough, short of its end: nothing
+        // else can be closer in practice, the next segment included
+        auto settled = [&] {
+            return best.segment >= 0 && best.offset < 0.5f * track->segments[best.segment].centerline.reach;
+        };
+        if (test(hint, pos, best) && settled() &&
+            (1.0f - best.t) * track->segments[hint].length() > best.offset)
+            return best;
+        if (hint + 1 < (int)bounds.size())
+            test(hint + 1, pos, best);
+        if (settled())
+            return best;
+    }
+
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (!contains(node.bounds, pos)) continue;
+
+        if (node.left < 0) {
+            for (int i = node.first; i < node.first + node.count; ++i)
+                test(leaves[i], pos, best);
+        } else if (top + 2 <= 64) {
+            stack[top++] = node.left;
+            stack[top++] = node.right;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,737 @@
+// Benchmarks for the simulation hot paths. Every case uses a fixed seed so the
+// numbers are comparable between runs and machines.
+//
+// Usage: marblerun_bench [--format json|csv] [--out FILE] [--filter TEXT]
+//                        [--seed S] [--quick]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+#include "race.h"
+#include "replay.h"
+#include "track_utils.h"
+#include "mesh_optimize.h"
+#include "marble_spawn.h"
+#include "memory_report.h"
+#include "frustum.h"
+#include "race_farm.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+struct BenchResult {
+    std::string name;
+    std::vector<double> samplesMs;
+    std::vector<std::pair<std::string, double>> counters;
+};
+
+struct BenchOptions {
+    unsigned int seed = 1;
+    bool quick = false;
+};
+
+static const float TICK = 1.0f / 60.0f;
+
+// ---------------- Cases ----------------
+
+static BenchResult benchTrackGeneration(const BenchOptions& opt) {
+    BenchResult r{ "track_generation" };
+    int iterations = opt.quick ? 3 : 10;
+    size_t triangles = 0;
+
+    for (int i = 0; i < iterations; ++i) {
+        RaceSettings settings;
+        settings.seed = opt.seed;
+        settings.marbleCount = 0;
+
+        auto t0 = Clock::now();
+        Race race(settings);
+        r.samplesMs.push_back(msSince(t0));
+
+        triangles = 0;
+        for (auto& seg : race.track.segments)
+            triangles += seg.indices.size() / 3;
+    }
+
+    r.counters.push_back({ "triangles", (double)triangles });
+    return r;
+}
+
+static BenchResult benchBvhBuild(const BenchOptions& opt) {
+    BenchResult r{ "bvh_build_curved_240x60" };
+    int iterations = opt.quick ? 5 : 20;
+
+    // Full tessellation curved segment, same as the track uses
+    PhysicsWorld scratch;
+    TrackSegment seg = buildCurvedSegment(scratch, 360.0f, 15.0f);
+
+    PhysicsWorld physics;
+    for (int i = 0; i < iterations; ++i) {
+        auto t0 = Clock::now();
+        physics.addTriangleMesh(seg.vertices, seg.indices, glm::vec3(0), glm::vec3(0));
+        r.samplesMs.push_back(msSince(t0));
+    }
+
+    r.counters.push_back({ "triangles", (double)(seg.indices.size() / 3) });
+    return r;
+}
+
+static BenchResult benchVertexCacheOptimize(const BenchOptions& opt) {
+    BenchResult r{ "vertex_cache_optimize_240x60" };
+    int iterations = opt.quick ? 3 : 10;
+
+    PhysicsWorld scratch;
+    TrackSegment seg = buildCurvedSegment(scratch, 360.0f, 15.0f);
+    size_t vertexCount = seg.vertices.size();
+
+    std::vector<unsigned int> optimized;
+    for (int i = 0; i < iterations; ++i) {
+        optimized = seg.indices;
+        auto t0 = Clock::now();
+        optimizeVertexCache(optimized, vertexCount);
+        optimizeVertexFetch(optimized, vertexCount);
+        r.samplesMs.push_back(msSince(t0));
+    }
+
+    r.counters.push_back({ "acmr_before", averageCacheMissRatio(seg.indices, vertexCount) });
+    r.counters.push_back({ "acmr_after", averageCacheMissRatio(optimized, vertexCount) });
+    return r;
+}
+
+static BenchResult benchPhysicsStep(const BenchOptions& opt, int marbleCount) {
+    BenchResult r{ "physics_step_" + std::to_string(marbleCount) };
+
+    RaceSettings settings;
+    settings.seed = opt.seed;
+    settings.marbleCount = marbleCount;
+    Race race(settings);
+
+    int steps = marbleCount >= 10000 ? 30 : marbleCount >= 1000 ? 120 : 600;
+    if (opt.quick) steps /= 5;
+
+    for (int i = 0; i < steps; ++i) {
+        auto t0 = Clock::now();
+        race.physics.step(TICK);
+        r.samplesMs.push_back(msSince(t0));
+    }
+
+    r.counters.push_back({ "marbles", (double)marbleCount });
+    return r;
+}
+
+static void addMemoryCounters(BenchResult& r, const MemoryBytes& b) {
+    r.counters.push_back({ "geometry_bytes", (double)b.geometry });
+    r.counters.push_back({ "triangle_mesh_bytes", (double)b.triangleMesh });
+    r.counters.push_back({ "bvh_bytes", (double)b.bvh });
+    r.counters.push_back({ "shape_bytes", (double)b.shapes });
+    r.counters.push_back({ "body_bytes", (double)b.bodies });
+    r.counters.push_back({ "cpu_bytes", (double)b.cpu() });
+}
+
+// CPU cost of one full-resolution curved segment. GPU bytes need a context;
+// marblerun_capture --memory-report has those.
+static BenchResult benchMemoryCurved(const BenchOptions& opt) {
+    BenchResult r{ "memory_curved_240x60" };
+    int iterations = opt.quick ? 5 : 50;
+
+    PhysicsWorld physics;
+    TrackSegment seg = buildCurvedSegment(physics, 360.0f, 15.0f);
+
+    SegmentMemory m;
+    for (int i = 0; i < iterations; ++i) {
+        auto t0 = Clock::now();
+        m = measureSegment(seg);
+        r.samplesMs.push_back(msSince(t0));
+    }
+
+    r.counters.push_back({ "triangles", (double)m.triangles });
+    addMemoryCounters(r, m.bytes);
+    r.counters.push_back({ "cpu_bytes_per_triangle", m.triangles ? (double)m.bytes.cpu() / m.triangles : 0.0 });
+    return r;
+}
+
+// Whole race, CPU side, per subsystem
+static BenchResult benchMemoryRace(const BenchOptions& opt) {
+    BenchResult r{ "memory_race_1000" };
+    int iterations = opt.quick ? 5 : 50;
+
+    RaceSettings settings;
+    settings.seed = opt.seed;
+    settings.marbleCount = 1000;
+    Race race(settings);
+
+    MemoryReport report;
+    for (int i = 0; i < iterations; ++i) {
+        auto t0 = Clock::now();
+        report = measureMemory(race);
+        r.samplesMs.push_back(msSince(t0));
+    }
+
+    r.counters.push_back({ "segments", (double)report.segments.size() });
+    for (const auto& s : report.subsystems)
+        r.counters.push_back({ s.first + "_cpu_bytes", (double)s.second.cpu() });
+    addMemoryCounters(r, report.total());
+    return r;
+}
+
+static BenchResult benchSpawnPacking(const BenchOptions& opt) {
+    const int marbleCount = 10000;
+    BenchResult r{ "spawn_packing_" + std::to_string(marbleCount) };
+
+    std::mt19937 gen(opt.seed);
+    std::uniform_real_distribution<float> radiusDist(0.3f, 0.7f);
+    std::vector<float> radii(marbleCount);
+    for (float& radius : radii)
+        radius = radiusDist(gen);
+
+    RaceSettings settings;
+    std::vector<glm::vec3> positions;
+    int iterations = opt.quick ? 5 : 50;
+    for (int i = 0; i < iterations; ++i) {
+        auto t0 = Clock::now();
+        positions = packSpawnPositions(radii, settings.spawnCenter, settings.spawnFootprint);
+        r.samplesMs.push_back(msSince(t0));
+    }
+
+    // Every pair, once, outside the timing
+    long overlaps = 0;
+    float top = 0.0f;
+    for (int i = 0; i < marbleCount; ++i) {
+        top = std::max(top, positions[i].y + radii[i] - settings.spawnCenter.y);
+        for (int j = i + 1; j < marbleCount; ++j) {
+            float reach = radii[i] + radii[j];
+            glm::vec3 d = positions[i] - positions[j];
+            if (glm::dot(d, d) < reach * reach)
+                ++overlaps;
+        }
+    }
+
+    r.counters.push_back({ "marbles", (double)marbleCount });
+    r.counters.push_back({ "overlaps", (double)overlaps });
+    r.counters.push_back({ "stack_height_m", top });
+    return r;
+}
+
+static BenchResult benchFinishDetection(const BenchOptions& opt) {
+    const int marbleCount = 1000;
+    BenchResult r{ "finish_detection_" + std::to_string(marbleCount) };
+
+    RaceSettings settings;
+    settings.seed = opt.seed;
+    settings.marbleCount = marbleCount;
+    Race race(settings);
+
+    // Let the marbles settle onto the track first
+    for (int i = 0; i < 60; ++i)
+        race.physics.step(TICK);
+
+    int checks = opt.quick ? 20 : 120;
+    for (int i = 0; i < checks; ++i) {
+        race.physics.step(TICK);
+
+        auto t0 = Clock::now();
+        race.checkFinish();
+        r.samplesMs.push_back(msSince(t0));
+    }
+
+    r.counters.push_back({ "marbles", (double)marbleCount });
+    return r;
+}
+
+static BenchResult benchReplayEncode(const BenchOptions& opt) {
+    const int marbleCount = 1000;
+    BenchResult r{ "replay_encode_" + std::to_string(marbleCount) };
+
+    RaceSettings settings;
+    settings.seed = opt.seed;
+    settings.marbleCount = marbleCount;
+    Race race(settings);
+
+    ReplayRecorder replay(marbleCount, 1.0f / TICK);
+
+    int frames = opt.quick ? 60 : 300;
+    for (int i = 0; i < frames; ++i) {
+        race.step(TICK);
+
+        auto t0 = Clock::now();
+        replay.recordFrame(race.marbles);
+        r.samplesMs.push_back(msSince(t0));
+    }
+
+    r.counters.push_back({ "marbles", (double)marbleCount });
+    r.counters.push_back({ "bytes_per_frame", (double)replay.bytes().size() / replay.frameCount() });
+    return r;
+}
+
+static BenchResult benchFrustumCull(const BenchOptions& opt) {
+    const int marbleCount = 10000;
+    BenchResult r{ "frustum_cull_" + std::to_string(marbleCount) };
+
+    RaceSettings settings;
+    settings.seed = opt.seed;
+    settings.marbleCount = marbleCount;
+    Race race(settings);
+
+    // Same projection as the game, looking down the track from above the spawn
+    glm::mat4 view = glm::lookAt(settings.spawnCenter + glm::vec3(0.0f, 10.0f, 20.0f),
+                                 settings.spawnCenter, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1200.0f / 1000.0f, 0.1f, 500.0f);
+    Frustum frustum(projection * view);
+
+    AabbList segmentBounds;
+    for (const auto& seg : race.track.segments)
+        segmentBounds.add(seg.worldBounds);
+
+    std::vector<glm::vec4> spheres(race.marbles.size());
+    for (size_t i = 0; i < race.marbles.size(); ++i)
+        spheres[i] = glm::vec4(race.marbles[i].renderable.position, race.marbles[i].renderable.radius);
+
+    std::vector<int> visibleMarbles, visibleSegments;
+    int iterations = opt.quick ? 50 : 500;
+    for (int i = 0; i < iterations; ++i) {
+        auto t0 = Clock::now();
+        frustum.cullSpheres(spheres, visibleMarbles);
+        frustum.cull(segmentBounds, visibleSegments);
+        r.samplesMs.push_back(msSince(t0));
+    }
+
+    r.counters.push_back({ "marbles", (double)marbleCount });
+    r.counters.push_back({ "visible_marbles", (double)visibleMarbles.size() });
+    r.counters.push_back({ "segments", (double)segmentBounds.size() });
+    r.counters.push_back({ "visible_segments", (double)visibleSegments.size() });
+    return r;
+}
+
+static BenchResult benchLeaderboard(const BenchOptions& opt) {
+    const int marbleCount = 10000;
+    BenchResult r{ "leaderboard_" + std::to_string(marbleCount) };
+
+    RaceSettings settings;
+    settings.seed = opt.seed;
+    settings.marbleCount = marbleCount;
+    Race race(settings);
+
+    // Spread the marbles over the whole track, a little off the centreline,
+    // and roll them forward at their own speeds; independent of physics
+    std::mt19937 gen(opt.seed);
+    std::uniform_real_distribution<float> distanceDist(0.0f, race.trackIndex.totalLength());
+    std::uniform_real_distribution<float> speedDist(5.0f, 15.0f);
+    std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+
+    std::vector<float> distance(marbleCount), speed(marbleCount);
+    std::vector<glm::vec3> offset(marbleCount);
+    for (int i = 0; i < marbleCount; ++i) {
+        distance[i] = distanceDist(gen);
+        speed[i] = speedDist(gen);
+        offset[i] = glm::vec3(jitter(gen), jitter(gen) + 0.5f, jitter(gen));
+    }
+
+    const auto& segments = race.track.segments;
+    auto place = [&](int i) {
+        float d = std::min(distance[i], race.trackIndex.totalLength() - 0.01f);
+        int s = 0;
+        while (s + 1 < (int)segments.size() && race.trackIndex.segmentStart(s + 1) <= d)
+            ++s;
+        float t = (d - race.trackIndex.segmentStart(s)) / segments[s].length();
+        race.marbles[i].renderable.position = segments[s].pointAt(t) + offset[i];
+    };
+
+    // Samples are what Race::step() pays for the standings by default
+    int ticks = opt.quick ? 20 : 120;
+    double error = 0.0;
+    for (int tick = 0; tick < ticks; ++tick) {
+        for (int i = 0; i < marbleCount; ++i) {
+            distance[i] = std::fmod(distance[i] + speed[i] * TICK, race.trackIndex.totalLength());
+            place(i);
+        }
+
+        auto t0 = Clock::now();
+        race.leaderboard.update(race.trackIndex, race.marbles, race.finishOrder, settings.standingsSpread);
+        r.samplesMs.push_back(msSince(t0));
+    }
+
+    // How far the located distances are from the ones the marbles were placed at
+    for (int i = 0; i < marbleCount; ++i)
+        error += std::abs(race.leaderboard.progressOf(i).distance - std::min(distance[i], race.trackIndex.totalLength()));
+
+    r.counters.push_back({ "marbles", (double)marbleCount });
+    r.counters.push_back({ "segments", (double)segments.size() });
+    r.counters.push_back({ "mean_error_m", error / marbleCount });
+    r.counters.push_back({ "spread", (double)settings.standingsSpread });
+    return r;
+}
+
+static BenchResult benchStateHash(const BenchOptions& opt) {
+    const int marbleCount = 10000;
+    BenchResult r{ "state_hash_" + std::to_string(marbleCount) };
+
+    RaceSettings settings;
+    settings.seed = opt.seed;
+    settings.marbleCount = marbleCount;
+    settings.deterministic = true;
+    Race race(settings);
+
+    int iterations = opt.quick ? 20 : 200;
+    uint64_t hash = 0;
+    for (int i = 0; i < iterations; ++i) {
+        auto t0 = Clock::now();
+        hash ^= race.stateHash();
+        r.samplesMs.push_back(msSince(t0));
+    }
+
+    r.counters.push_back({ "marbles", (double)marbleCount });
+    r.counters.push_back({ "hash_low_bits", (double)(hash & 0xffff) });
+    return r;
+}
+
+static BenchResult benchEndlessTrack(const BenchOptions& opt) {
+    BenchResult r{ "endless_track" };
+
+    RaceSettings settings;
+    settings.seed = opt.seed;
+    settings.marbleCount = 0;
+    settings.endless = true;
+    Race race(settings);
+
+    // A leader rolling at a steady 40 m/s, so the main-thread cost per tick
+    // (attach, retire, reindex) is measured without physics in the way.
+    // Ticks are paced in real time: the worker builds against the clock.
+    const float speed = 40.0f;
+    int ticks = opt.quick ? 180 : 900;
+    float leader = race.track.startDistance;
+    size_t maxSegments = 0, maxObstacles = 0;
+    auto nextTick = Clock::now();
+    for (int tick = 0; tick < ticks; ++tick) {
+        nextTick += std::chrono::microseconds((long)(TICK * 1e6f));
+        std::this_thread::sleep_until(nextTick);
+        leader += speed * TICK;
+
+        auto t0 = Clock::now();
+        int added = race.generator->attach(race.track, race.physics, race.obstacles, leader);
+        int removed = race.generator->retire(race.track, race.obstacles, leader);
+        if (added > 0 || removed > 0)
+            race.trackIndex.build(race.track);
+        r.samplesMs.push_back(msSince(t0));
+
+        maxSegments = std::max(maxSegments, race.track.segments.size());
+        maxObstacles = std::max(maxObstacles, race.obstacles.size());
+    }
+
+    TrackGeneratorStats g = race.generator->stats();
+    r.counters.push_back({ "distance_m", leader });
+    r.counters.push_back({ "pieces_generated", (double)g.piecesGenerated });
+    r.counters.push_back({ "segments_retired", (double)g.segmentsRetired });
+    r.counters.push_back({ "max_live_segments", (double)maxSegments });
+    r.counters.push_back({ "max_live_obstacles", (double)maxObstacles });
+    r.counters.push_back({ "rejected_intersect", (double)g.rejectedIntersect });
+    r.counters.push_back({ "rejected_drop", (double)g.rejectedDrop });
+    r.counters.push_back({ "forced_drops", (double)g.forcedDrops });
+    r.counters.push_back({ "starved_ticks", (double)g.starvedUpdates });
+    r.counters.push_back({ "max_generate_ms", g.maxGenerateMs });
+    r.counters.push_back({ "max_attach_ms", g.maxAttachMs });
+    return r;
+}
+
+// Replacing a segment near the start of a long track: only the new segment
+// is built (outside the timing), everything after it is moved to follow on.
+// One segment in ten is a full-resolution 240x60 curve.
+static BenchResult benchTrackEdit(const BenchOptions& opt) {
+    BenchResult r{ "track_edit_500" };
+    int iterations = opt.quick ? 10 : 50;
+
+    PhysicsWorld physics;
+    Track track;
+    for (int i = 0; i < 500; ++i) {
+        if (i % 10 == 0)
+            track.addSegment(buildCurvedSegment(physics, (i / 10) % 2 ? 90.0f : -90.0f));
+        else
+            track.addSegment(buildStraightSegment(physics, 10.0f, -5.0f, 0.0f, 5.0f));
+    }
+
+    size_t moved = 0;
+    for (int i = 0; i < iterations; ++i) {
+        TrackSegment seg = buildStraightSegment(physics, 10.0f + (i % 2), -5.0f, 0.0f, 5.0f);
+        glm::mat4 lastBefore = track.segments.back().worldTransform;
+
+        auto t0 = Clock::now();
+        track.replaceSegment(10, std::move(seg));
+        r.samplesMs.push_back(msSince(t0));
+
+        if (track.segments.back().worldTransform != lastBefore)
+            moved = track.segments.size() - 11;
+    }
+
+    r.counters.push_back({ "segments", (double)track.segments.size() });
+    r.counters.push_back({ "segments_moved", (double)moved });
+    size_t vertices = 0;
+    for (const TrackSegment& seg : track.segments)
+        vertices += seg.vertices.size();
+    r.counters.push_back({ "vertices", (double)vertices });
+    return r;
+}
+
+// Round trips through a race farm on a local socket, one job at a time:
+// the standard course and a small custom track, several seeds each. Only a
+// track's first job builds it; the rest take it from the cache.
+static BenchResult benchRaceFarm(const BenchOptions& opt) {
+    BenchResult r{ "race_farm" };
+    int seeds = opt.quick ? 3 : 8;
+
+    RaceFarmSettings settings;
+    settings.socketPath = "/tmp/marblerun_bench_" + std::to_string(::getpid()) + ".sock";
+    settings.workers = 2;
+    RaceFarm farm(settings);
+    if (!farm.listen()) return r;
+    std::thread server([&] { farm.serve(); });
+
+    int fd = connectRaceFarm(settings.socketPath);
+    const std::string tracks[] = {
+        "",
+        "funnel 60 10 20 12 3 5\ncurve 180 10 20 8 3 60 15\nstraight 30 -10 1 20 obstacles=5\nstraight 20 0 2 20\n",
+    };
+
+    FarmDecoder decoder;
+    double coldSetup = 0.0, cachedSetup = 0.0;
+    int cold = 0, cached = 0, failed = 0;
+    uint64_t id = 0;
+    for (int s = 0; fd >= 0 && s < seeds; ++s) {
+        for (const std::string& track : tracks) {
+            FarmJob job;
+            job.id = ++id;
+            job.seed = opt.seed + s;
+            job.marbleCount = 25;
+            job.maxTime = 2.0f;
+            job.track = track;
+            std::vector<uint8_t> bytes;
+            encodeFarmMessage(job, bytes);
+
+            auto t0 = Clock::now();
+            if (!sendAll(fd, bytes)) break;
+            FarmMessage type;
+            std::vector<uint8_t> payload;
+            bool answered = false;
+            while (!answered) {
+                while (!answered && decoder.next(type, payload)) {
+                    FarmDone done;
+                    if (type == FarmMessage::Done && decodeFarmMessage(payload, done)) {
+                        (done.trackCached ? cachedSetup : coldSetup) += done.setupMs;
+                        ++(done.trackCached ? cached : cold);
+                        answered = true;
+                    } else if (type == FarmMessage::Error) {
+                        ++failed;
+                        answered = true;
+                    }
+                }
+                if (!answered && !receiveSome(fd, decoder)) break;
+            }
+            if (!answered) break;
+            r.samplesMs.push_back(msSince(t0));
+        }
+    }
+    if (fd >= 0)
+        ::close(fd);
+    farm.stop();
+    server.join();
+
+    RaceFarmStats stats = farm.stats();
+    r.counters.push_back({ "jobs", (double)stats.jobsDone });
+    r.counters.push_back({ "jobs_failed", (double)(stats.jobsFailed + failed) });
+    r.counters.push_back({ "track_cache_hits", (double)stats.cache.hits });
+    r.counters.push_back({ "cold_setup_ms", cold ? coldSetup / cold : 0.0 });
+    r.counters.push_back({ "cached_setup_ms", cached ? cachedSetup / cached : 0.0 });
+    return r;
+}
+
+// Editing a live race's standard course: replacing its second curve is
+// timed, then appending, replacing and removing at the end check that the
+// finish always moves to the last segment and the track can't be emptied
+static BenchResult benchRaceEdit(const BenchOptions& opt) {
+    BenchResult r{ "race_edit" };
+    int iterations = opt.quick ? 5 : 20;
+
+    RaceSettings settings;
+    settings.seed = opt.seed;
+    Race race(settings);
+
+    auto built = [](TrackSegment seg) {
+        seg.body = PhysicsWorld::createTriangleMesh(seg.vertices, seg.indices, glm::vec3(0), glm::vec3(0));
+        return seg;
+    };
+
+    // Exactly the last segment lets marbles through
+    int finishErrors = 0;
+    auto checkFinish = [&] {
+        const auto& segments = race.track.segments;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            bool sensor = (segments[i].body->getCollisionFlags() & btCollisionObject::CF_NO_CONTACT_RESPONSE) != 0;
+            if (sensor != (i + 1 == segments.size()))
+                ++finishErrors;
+        }
+        race.step(TICK);
+    };
+
+    for (int i = 0; i < iterations; ++i) {
+        TrackSegment seg = built(makeCurvedSegment(i % 2 ? 350.0f : 360.0f, 15.0f));
+        auto t0 = Clock::now();
+        race.replaceSegment(1, std::move(seg));
+        r.samplesMs.push_back(msSince(t0));
+    }
+    checkFinish();
+
+    race.insertSegment(race.track.segments.size(), built(makeStraightSegment(20.0f, 0.0f, 2.0f, 30.0f)));
+    checkFinish();
+    race.replaceSegment(race.track.segments.size() - 1, built(makeStraightSegment(30.0f, 0.0f, 2.0f, 30.0f)));
+    checkFinish();
+    while (race.track.segments.size() > 1) {
+        race.removeSegment(race.track.segments.size() - 1);
+        checkFinish();
+    }
+    race.removeSegment(0);
+    checkFinish();
+
+    r.counters.push_back({ "finish_flag_errors", (double)finishErrors });
+    r.counters.push_back({ "segments_left", (double)race.track.segments.size() });
+    return r;
+}
+
+// ---------------- Reporting ----------------
+
+struct Summary {
+    double min, median, mean, p95, max;
+};
+
+static Summary summarize(std::vector<double> samples) {
+    Summary s{};
+    if (samples.empty()) return s;
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double v : samples) sum += v;
+
+    s.min = samples.front();
+    s.max = samples.back();
+    s.mean = sum / samples.size();
+    s.median = samples[samples.size() / 2];
+    s.p95 = samples[std::min(samples.size() - 1, (size_t)(samples.size() * 0.95))];
+    return s;
+}
+
+static void writeJson(std::ostream& out, const std::vector<BenchResult>& results, const BenchOptions& opt) {
+    out << "{\n  \"suite\": \"marblerun\",\n  \"seed\": " << opt.seed << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        Summary s = summarize(r.samplesMs);
+        out << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.samplesMs.size()
+            << ", \"min_ms\": " << s.min << ", \"median_ms\": " << s.median
+            << ", \"mean_ms\": " << s.mean << ", \"p95_ms\": " << s.p95
+            << ", \"max_ms\": " << s.max << ", \"counters\": {";
+        for (size_t c = 0; c < r.counters.size(); ++c)
+            out << (c ? ", " : "") << "\"" << r.counters[c].first << "\": " << r.counters[c].second;
+        out << "}}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+static void writeCsv(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "name,iterations,min_ms,median_ms,mean_ms,p95_ms,max_ms,counters\n";
+    for (const BenchResult& r : results) {
+        Summary s = summarize(r.samplesMs);
+        out << r.name << "," << r.samplesMs.size() << "," << s.min << "," << s.median << ","
+            << s.mean << "," << s.p95 << "," << s.max << ",";
+        for (size_t c = 0; c < r.counters.size(); ++c)
+            out << (c ? ";" : "") << r.counters[c].first << "=" << r.counters[c].second;
+        out << "\n";
+    }
+}
+
+static void printUsage() {
+    std::cerr << "Usage: marblerun_bench [--format json|csv] [--out FILE] [--filter TEXT]\n"
+                 "                       [--seed S] [--quick]\n";
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    std::string format = "json";
+    std::string outPath;
+    std::string filter;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--format" && hasValue)      format = argv[++i];
+        else if (arg == "--out" && hasValue)    outPath = argv[++i];
+        else if (arg == "--filter" && hasValue) filter = argv[++i];
+        else if (arg == "--seed" && hasValue)   opt.seed = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--quick")              opt.quick = true;
+        else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (format != "json" && format != "csv") {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<std::pair<std::string, std::function<BenchResult()>>> cases = {
+        { "track_generation",             [&] { return benchTrackGeneration(opt); } },
+        { "bvh_build_curved_240x60",      [&] { return benchBvhBuild(opt); } },
+        { "vertex_cache_optimize_240x60", [&] { return benchVertexCacheOptimize(opt); } },
+        { "memory_curved_240x60",         [&] { return benchMemoryCurved(opt); } },
+        { "memory_race_1000",             [&] { return benchMemoryRace(opt); } },
+        { "physics_step_25",              [&] { return benchPhysicsStep(opt, 25); } },
+        { "physics_step_1000",            [&] { return benchPhysicsStep(opt, 1000); } },
+        { "physics_step_10000",           [&] { return benchPhysicsStep(opt, 10000); } },
+        { "spawn_packing_10000",          [&] { return benchSpawnPacking(opt); } },
+        { "finish_detection_1000",        [&] { return benchFinishDetection(opt); } },
+        { "replay_encode_1000",           [&] { return benchReplayEncode(opt); } },
+        { "frustum_cull_10000",           [&] { return benchFrustumCull(opt); } },
+        { "leaderboard_10000",            [&] { return benchLeaderboard(opt); } },
+        { "state_hash_10000",             [&] { return benchStateHash(opt); } },
+        { "endless_track",                [&] { return benchEndlessTrack(opt); } },
+        { "track_edit_500",               [&] { return benchTrackEdit(opt); } },
+        { "race_farm",                    [&] { return benchRaceFarm(opt); } },
+        { "race_edit",                    [&] { return benchRaceEdit(opt); } },
+    };
+
+    std::vector<BenchResult> results;
+    for (auto& c : cases) {
+        if (!filter.empty() && c.first.find(filter) == std::string::npos)
+            continue;
+        std::cerr << "running " << c.first << "...\n";
+        results.push_back(c.second());
+    }
+
+    std::ofstream file;
+    if (!outPath.empty()) {
+        file.open(outPath);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open output file: " << outPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = outPath.empty() ? std::cout : file;
+
+    if (format == "csv")
+        writeCsv(out, results);
+    else
+        writeJson(out, results, opt);
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+// Converts skybox atlases into .mrcube caches next to them, so the game
+// never has to decode a PNG/JPG at startup.
+//
+// Usage: marblerun_bake_cubemaps [--force] [ATLAS...]
+//        (defaults to the three shipped skyboxes under assets/skybox)
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cubemap_cache.h"
+
+static void printUsage() {
+    std::cerr << "Usage: marblerun_bake_cubemaps [--force] [ATLAS...]\n";
+}
+
+int main(int argc, char** argv) {
+    bool force = false;
+    std::vector<std::string> atlases;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--force") force = true;
+        else if (arg == "--help") {
+            printUsage();
+            return 0;
+        }
+        else if (!arg.empty() && arg[0] == '-') {
+            printUsage();
+            return 1;
+        }
+        else atlases.push_back(arg);
+    }
+
+    if (atlases.empty()) {
+        atlases = { "assets/skybox/red_sky.png",
+                    "assets/skybox/canyon.jpg",
+                    "assets/skybox/galaxy.png" };
+    }
+
+    using Clock = std::chrono::steady_clock;
+    int failures = 0;
+
+    for (const std::string& atlas : atlases) {
+        std::string cachePath = cubemapCachePath(atlas);
+        if (!force && cubemapCacheIsFresh(cachePath, atlas)) {
+            std::cout << cachePath << " up to date\n";
+            continue;
+        }
+
+        auto t0 = Clock::now();
+        CubemapImage image;
+        if (!convertAtlasToCubemap(atlas, image) || !writeCubemapCache(cachePath, image)) {
+            std::cerr << "Failed to bake " << atlas << "\n";
+            ++failures;
+            continue;
+        }
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+        CubemapView view = image.view();
+        std::cout << cachePath << " face=" << view.faceSize << " mips=" << view.mipCount
+                  << " bytes=" << image.bytes.size() << " ms=" << ms << "\n";
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+// Renders a race offscreen at a fixed simulation step and writes every frame
+// out, for making race videos on machines with no display.
+//
+// Usage: marblerun_capture [--width W] [--height H] [--fps F] [--substeps N]
+//                          [--seconds S] [--marbles N] [--seed S] [--ring N]
+//                          [--skybox ATLAS] [--ppm DIR | --raw FILE | --pipe CMD | --no-output]
+//                          [--endless] [--memory-report FILE]
+//
+// Run from the directory holding shaders/ and assets/. Frames are top-down
+// RGB24; for example, to encode straight to video:
+//   marblerun_capture --pipe "ffmpeg -y -f rawvideo -pix_fmt rgb24 -s 1280x720 -r 60 -i - race.mp4"
+// With no GPU, Mesa's llvmpipe works: LIBGL_ALWAYS_SOFTWARE=1 marblerun_capture ...
+//
+// --memory-report writes CPU and GPU memory per segment and per subsystem,
+// as JSON, after the last frame.
+
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "race.h"
+#include "race_view.h"
+#include "offscreen.h"
+#include "frame_capture.h"
+
+static void printUsage() {
+    std::cerr << "Usage: marblerun_capture [--width W] [--height H] [--fps F] [--substeps N]\n"
+                 "                         [--seconds S] [--marbles N] [--seed S] [--ring N]\n"
+                 "                         [--skybox ATLAS] [--ppm DIR | --raw FILE | --pipe CMD | --no-output]\n"
+                 "                         [--endless] [--memory-report FILE]\n";
+}
+
+int main(int argc, char** argv) {
+    int width = 1280, height = 720;
+    float fps = 60.0f;
+    int substeps = 1;
+    float seconds = 30.0f;
+    int ringSize = 3;
+    std::string skyboxPath = "assets/skybox/red_sky.png";
+    RaceSettings settings;
+    settings.seed = 1;
+
+    bool writeFrames = true;
+    CaptureFormat format = CaptureFormat::PpmSequence;
+    std::string target = "capture";
+    std::string memoryPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--width" && hasValue)         width = std::atoi(argv[++i]);
+        else if (arg == "--height" && hasValue)   height = std::atoi(argv[++i]);
+        else if (arg == "--fps" && hasValue)      fps = (float)std::atof(argv[++i]);
+        else if (arg == "--substeps" && hasValue) substeps = std::atoi(argv[++i]);
+        else if (arg == "--seconds" && hasValue)  seconds = (float)std::atof(argv[++i]);
+        else if (arg == "--marbles" && hasValue)  settings.marbleCount = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue)     settings.seed = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--ring" && hasValue)     ringSize = std::atoi(argv[++i]);
+        else if (arg == "--skybox" && hasValue)   skyboxPath = argv[++i];
+        else if (arg == "--ppm" && hasValue)      { format = CaptureFormat::PpmSequence; target = argv[++i]; }
+        else if (arg == "--raw" && hasValue)      { format = CaptureFormat::RawStream; target = argv[++i]; }
+        else if (arg == "--pipe" && hasValue)     { format = CaptureFormat::Pipe; target = argv[++i]; }
+        else if (arg == "--no-output")            writeFrames = false;
+        else if (arg == "--endless")              settings.endless = true;
+        else if (arg == "--memory-report" && hasValue) memoryPath = argv[++i];
+        else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (width <= 0 || height <= 0 || fps <= 0.0f || substeps <= 0 || ringSize <= 0 ||
+        settings.marbleCount <= 0) {
+        printUsage();
+        return 1;
+    }
+
+    // A dead encoder should fail the write, not kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+
+    OffscreenContext context;
+    if (!context.create(4, 1))
+        return 1;
+    std::cout << "# renderer=" << glGetString(GL_RENDERER) << "\n";
+
+    using Clock = std::chrono::steady_clock;
+    auto t0 = Clock::now();
+
+    Race race(settings);
+    RaceView raceView;
+    raceView.load(race, skyboxPath);
+
+    Framebuffer framebuffer(width, height);
+    if (!framebuffer.complete())
+        return 1;
+
+    std::unique_ptr<FrameCapture> capture;
+    if (writeFrames) {
+        capture = std::make_unique<FrameCapture>(width, height, ringSize);
+        if (!capture->open(format, target))
+            return 1;
+    }
+
+    auto t1 = Clock::now();
+
+    // Chase the player marble; eased so the shot doesn't jitter with the physics
+    const float dt = 1.0f / (fps * substeps);
+    const glm::vec3 chaseOffset(0.0f, 6.0f, 14.0f);
+    glm::vec3 cameraPos = race.marbles[0].renderable.position + chaseOffset;
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 500.0f);
+
+    long frames = 0;
+    while (race.elapsed < seconds && !race.allFinished()) {
+        for (int s = 0; s < substeps; ++s)
+            race.step(dt);
+
+        glm::vec3 subject = race.marbles[0].renderable.position;
+        float ease = 1.0f - std::exp(-3.0f / fps);
+        cameraPos += (subject + chaseOffset - cameraPos) * ease;
+
+        ViewParams params;
+        params.view = glm::lookAt(cameraPos, subject, glm::vec3(0.0f, 1.0f, 0.0f));
+        params.projection = projection;
+        params.position = cameraPos;
+        params.viewportHeight = height;
+        // Same light orbit as the game, on simulated time
+        params.lightPos = glm::vec3(2.0f * std::sin(race.elapsed * 0.2f), 2.0f, 2.0f * std::cos(race.elapsed * 0.2f));
+
+        framebuffer.bind();
+        raceView.render(race, params, race.winner());
+        if (capture)
+            capture->capture();
+        ++frames;
+    }
+
+    if (capture)
+        capture->finish();
+    glFinish();
+
+    auto t2 = Clock::now();
+
+    double setupMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    double runMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+    std::cout << "frames=" << frames
+              << " sim_time=" << race.elapsed << "s"
+              << " setup_ms=" << setupMs
+              << " run_ms=" << runMs
+              << " fps=" << (runMs > 0.0 ? frames * 1000.0 / runMs : 0.0)
+              << " stream_stalls=" << raceView.streamStalls();
+    if (capture) {
+        const CaptureStats& stats = capture->stats();
+        std::cout << " written=" << stats.framesWritten
+                  << " fence_stalls=" << stats.fenceStalls
+                  << " writer_stalls=" << stats.writerStalls;
+        if (stats.writeFailed) {
+            std::cout << "\n";
+            std::cerr << "Writing frames to " << target << " failed\n";
+            return 1;
+        }
+    }
+    std::cout << "\n";
+
+    if (!memoryPath.empty()) {
+        MemoryReport memory = measureMemory(race);
+        raceView.measureMemory(memory);
+        if (!memory.writeJson(memoryPath))
+            return 1;
+    }
+    return 0;
+}
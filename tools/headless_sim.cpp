@@ -0,0 +1,224 @@
+// Runs a race without a window or GL context and prints the finish order.
+//
+// Usage: marblerun_headless [--marbles N] [--seed S] [--tick HZ]
+//                           [--max-time SECONDS] [--replay FILE] [--endless]
+//                           [--deterministic] [--hash-log FILE] [--check-hashes FILE]
+//                           [--memory-report FILE]
+//        marblerun_headless --serve SOCKET [--workers N] [--cache-tracks N]
+//
+// --endless runs on generated track until --max-time and reports the
+// generator instead of a finish order.
+//
+// --hash-log writes Race::stateHash() for every tick. --check-hashes compares
+// against such a log as the race runs and stops at the first tick that
+// differs, e.g. to check that a new build still runs the same race:
+//   marblerun_headless --deterministic --hash-log a.log
+//   other/marblerun_headless --deterministic --check-hashes a.log
+//
+// --memory-report writes what the race holds at the end of the run as JSON,
+// CPU side only; marblerun_capture writes the same with GPU bytes.
+//
+// --serve runs a race farm on a Unix domain socket instead of one race: jobs
+// come in and results go out as described in farm_protocol.h, until SIGINT
+// or SIGTERM. --workers is how many races run at once (default one per
+// hardware thread), --cache-tracks how many built tracks are kept.
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "race.h"
+#include "replay.h"
+#include "state_hash.h"
+#include "memory_report.h"
+#include "race_farm.h"
+
+static void printUsage() {
+    std::cerr << "Usage: marblerun_headless [--marbles N] [--seed S] [--tick HZ]\n"
+                 "                          [--max-time SECONDS] [--replay FILE] [--endless]\n"
+                 "                          [--deterministic] [--hash-log FILE] [--check-hashes FILE]\n"
+                 "                          [--memory-report FILE]\n"
+                 "       marblerun_headless --serve SOCKET [--workers N] [--cache-tracks N]\n";
+}
+
+static RaceFarm* servingFarm = nullptr;
+
+static void stopServing(int) {
+    if (servingFarm) servingFarm->stop();
+}
+
+static int serve(const RaceFarmSettings& settings) {
+    RaceFarm farm(settings);
+    if (!farm.listen())
+        return 1;
+
+    // A client hanging up mid-write must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+    servingFarm = &farm;
+    std::signal(SIGINT, stopServing);
+    std::signal(SIGTERM, stopServing);
+
+    std::cerr << "Serving races on " << settings.socketPath << "\n";
+    farm.serve();
+    servingFarm = nullptr;
+
+    RaceFarmStats stats = farm.stats();
+    std::cout << "# jobs_done=" << stats.jobsDone
+              << " jobs_failed=" << stats.jobsFailed
+              << " track_hits=" << stats.cache.hits
+              << " track_misses=" << stats.cache.misses
+              << " track_evictions=" << stats.cache.evictions << "\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    RaceSettings settings;
+    settings.seed = 1;
+    settings.standingsSpread = 0;   // only the finish order is printed
+    float tickRate = 60.0f;
+    float maxTime = 120.0f;
+    std::string replayPath, hashLogPath, checkPath, memoryPath;
+    RaceFarmSettings farmSettings;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--marbles" && hasValue)       settings.marbleCount = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue)     settings.seed = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--tick" && hasValue)     tickRate = (float)std::atof(argv[++i]);
+        else if (arg == "--max-time" && hasValue) maxTime = (float)std::atof(argv[++i]);
+        else if (arg == "--replay" && hasValue)   replayPath = argv[++i];
+        else if (arg == "--endless")              settings.endless = true;
+        else if (arg == "--deterministic")        settings.deterministic = true;
+        else if (arg == "--hash-log" && hasValue) hashLogPath = argv[++i];
+        else if (arg == "--check-hashes" && hasValue) checkPath = argv[++i];
+        else if (arg == "--memory-report" && hasValue) memoryPath = argv[++i];
+        else if (arg == "--serve" && hasValue)    farmSettings.socketPath = argv[++i];
+        else if (arg == "--workers" && hasValue)  farmSettings.workers = std::atoi(argv[++i]);
+        else if (arg == "--cache-tracks" && hasValue) farmSettings.cachedTracks = (size_t)std::max(1, std::atoi(argv[++i]));
+        else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (settings.marbleCount <= 0 || tickRate <= 0.0f) {
+        printUsage();
+        return 1;
+    }
+
+    if (!farmSettings.socketPath.empty())
+        return serve(farmSettings);
+
+    std::vector<uint64_t> expected;
+    if (!checkPath.empty() && !loadStateHashLog(checkPath, expected))
+        return 1;
+
+    std::ofstream hashLog;
+    if (!hashLogPath.empty()) {
+        hashLog.open(hashLogPath);
+        if (!hashLog) {
+            std::cerr << "Failed to open " << hashLogPath << " for writing\n";
+            return 1;
+        }
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto t0 = Clock::now();
+
+    Race race(settings);
+
+    auto t1 = Clock::now();
+
+    std::unique_ptr<ReplayRecorder> replay;
+    if (!replayPath.empty())
+        replay = std::make_unique<ReplayRecorder>(settings.marbleCount, tickRate);
+
+    // Tick 0 is the state before the first step
+    long divergedAt = -1;
+    auto checkTick = [&] {
+        if (!hashLog.is_open() && expected.empty()) return;
+        uint64_t hash = race.stateHash();
+        if (hashLog.is_open())
+            hashLog << race.ticks << " " << formatStateHash(hash) << "\n";
+        if ((size_t)race.ticks < expected.size() && expected[race.ticks] != hash)
+            divergedAt = race.ticks;
+    };
+    checkTick();
+
+    const float dt = 1.0f / tickRate;
+    long ticks = 0;
+    while (race.elapsed < maxTime && !race.allFinished() && divergedAt < 0) {
+        race.step(dt);
+        if (replay) replay->recordFrame(race.marbles);
+        checkTick();
+        ++ticks;
+    }
+
+    auto t2 = Clock::now();
+
+    double setupMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    double simMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+    std::cout << "# seed=" << settings.seed
+              << " marbles=" << settings.marbleCount
+              << " tick=" << tickRate
+              << " ticks=" << ticks
+              << " sim_time=" << race.elapsed << "s"
+              << " setup_ms=" << setupMs
+              << " run_ms=" << simMs
+              << " finished=" << race.finishOrder.size()
+              << " state_hash=" << formatStateHash(race.stateHash()) << "\n";
+
+    if (divergedAt >= 0) {
+        std::cout << "# diverged at tick " << divergedAt << ": expected "
+                  << formatStateHash(expected[divergedAt]) << ", got " << formatStateHash(race.stateHash()) << "\n";
+        return 2;
+    }
+    if (!expected.empty())
+        std::cout << "# hashes match for " << std::min((size_t)race.ticks + 1, expected.size())
+                  << " of " << expected.size() << " logged ticks\n";
+
+    if (race.generator) {
+        TrackGeneratorStats g = race.generator->stats();
+        std::cout << "# endless pieces=" << g.piecesGenerated
+                  << " attached=" << g.piecesAttached
+                  << " retired_segments=" << g.segmentsRetired
+                  << " live_segments=" << race.track.segments.size()
+                  << " rejected_intersect=" << g.rejectedIntersect
+                  << " rejected_drop=" << g.rejectedDrop
+                  << " forced_drops=" << g.forcedDrops
+                  << " starved=" << g.starvedUpdates
+                  << " max_generate_ms=" << g.maxGenerateMs
+                  << " max_attach_ms=" << g.maxAttachMs
+                  << " eliminated=" << race.eliminatedCount << "\n";
+    }
+
+    if (!memoryPath.empty()) {
+        MemoryReport memory = measureMemory(race);
+        MemoryBytes total = memory.total();
+        std::cout << "# memory cpu_bytes=" << total.cpu()
+                  << " geometry=" << total.geometry
+                  << " triangle_mesh=" << total.triangleMesh
+                  << " bvh=" << total.bvh << "\n";
+        if (!memory.writeJson(memoryPath))
+            return 1;
+    }
+
+    std::cout << "place,marble,time\n";
+    for (size_t i = 0; i < race.finishOrder.size(); ++i) {
+        const FinishEntry& f = race.finishOrder[i];
+        std::cout << (i + 1) << "," << f.marble << "," << f.time << "\n";
+    }
+
+    if (replay && !replay->save(replayPath))
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+// Times building the game's shader programs with an empty program binary
+// cache (cold) and again with the cache it just filled (warm).
+//
+// Usage: marblerun_shader_cache [--cache-dir DIR] [--rounds N]
+//
+// Also the cache's test: fails unless every warm build is a hit and the
+// driver takes every binary back. Exits with 77 (skipped, to ctest) when
+// there is no GL context to be had.
+//
+// Run from the directory holding shaders/. For a software-rendered
+// comparison use Mesa's llvmpipe. Mesa only offers program binaries while
+// its own disk cache is on, so point that at an empty directory instead of
+// disabling it; later rounds then also hit Mesa's cache on the cold path.
+//   LIBGL_ALWAYS_SOFTWARE=1 MESA_SHADER_CACHE_DIR=/tmp/empty marblerun_shader_cache
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "shader_program.h"
+#include "shader_utils.h"
+
+struct ProgramFiles {
+    std::string vertexPath, fragmentPath;
+    std::vector<std::string> sharedFragmentPaths;
+};
+
+// Same programs as the game
+static const std::vector<ProgramFiles> PROGRAMS = {
+    { "shaders/skybox.vert",          "shaders/skybox.frag",          {} },
+    { "shaders/marble.vert",          "shaders/marble.frag",          { "shaders/marble_shading.frag" } },
+    { "shaders/marble_impostor.vert", "shaders/marble_impostor.frag", { "shaders/marble_shading.frag" } },
+    { "shaders/obstacle.vert",        "shaders/track.frag",           {} },
+    { "shaders/track_batch.vert",     "shaders/track.frag",           {} },
+};
+
+static void printUsage() {
+    std::cerr << "Usage: marblerun_shader_cache [--cache-dir DIR] [--rounds N]\n";
+}
+
+// Build every program once; returns wall time in ms, including glFinish so
+// drivers that compile lazily are charged for it
+static double buildAll(const std::vector<ShaderSources>& sources, bool& allLinked) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<ShaderProgram> programs;
+    for (const auto& s : sources)
+        programs.emplace_back(s);
+    glFinish();
+    auto t1 = std::chrono::steady_clock::now();
+
+    allLinked = true;
+    for (const auto& p : programs) {
+        GLint linked = GL_FALSE;
+        glGetProgramiv(p.id(), GL_LINK_STATUS, &linked);
+        allLinked = allLinked && linked;
+    }
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+static double median(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+int main(int argc, char** argv) {
+    std::string cacheDir = "shader_cache_bench";
+    int rounds = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--cache-dir" && hasValue)   cacheDir = argv[++i];
+        else if (arg == "--rounds" && hasValue) rounds = std::atoi(argv[++i]);
+        else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (rounds <= 0 || cacheDir.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    // Same context as the game, just never shown
+    const int NO_CONTEXT = 77;
+    if (!glfwInit()) return NO_CONTEXT;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "shader cache", nullptr, nullptr);
+    if (!window) {
+        std::cerr << "Failed to create GL context\n";
+        glfwTerminate();
+        return NO_CONTEXT;
+    }
+    glfwMakeContextCurrent(window);
+    if (glewInit() != GLEW_OK) {
+        std::cerr << "Failed to initialize GLEW\n";
+        return 1;
+    }
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    std::cout << "# renderer=" << glGetString(GL_RENDERER)
+              << " version=" << glGetString(GL_VERSION)
+              << " binary_formats=" << formats << "\n";
+
+    // Reading files is not what is being measured
+    std::vector<ShaderSources> sources;
+    for (const auto& p : PROGRAMS)
+        sources.push_back(loadShaderSources(p.vertexPath, p.fragmentPath, p.sharedFragmentPaths));
+
+    setProgramCacheDir(cacheDir);
+    std::vector<double> cold, warm;
+    bool ok = true;
+    int warmRejected = 0;
+
+    for (int r = 0; r < rounds; ++r) {
+        std::error_code ec;
+        std::filesystem::remove_all(cacheDir, ec);
+
+        bool linked = false;
+        cold.push_back(buildAll(sources, linked));
+        ok = ok && linked;
+        int rejectedBefore = programCacheStats().rejected;
+        warm.push_back(buildAll(sources, linked));
+        ok = ok && linked;
+        warmRejected += programCacheStats().rejected - rejectedBefore;
+    }
+
+    const ProgramCacheStats& stats = programCacheStats();
+    std::cout << "programs=" << sources.size()
+              << " rounds=" << rounds
+              << " cold_ms=" << median(cold)
+              << " warm_ms=" << median(warm)
+              << " hits=" << stats.hits
+              << " misses=" << stats.misses
+              << " rejected=" << stats.rejected
+              << " stores=" << stats.stores << "\n";
+
+    std::error_code ec;
+    std::filesystem::remove_all(cacheDir, ec);
+
+    glfwTerminate();
+
+    if (!ok) {
+        std::cerr << "A program failed to link\n";
+        return 1;
+    }
+    // The cache starts empty each round, so the warm builds are the only hits
+    int expectedHits = (int)sources.size() * rounds;
+    if (stats.hits != expectedHits) {
+        std::cerr << "Expected " << expectedHits << " cache hits, got " << stats.hits
+                  << (formats == 0 ? " (the driver offers no binary formats)" : "") << "\n";
+        return 1;
+    }
+    if (warmRejected > 0) {
+        std::cerr << "The driver refused " << warmRejected << " cached binaries on the warm pass\n";
+        return 1;
+    }
+    return 0;
+}